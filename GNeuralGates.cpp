@@ -16,13 +16,15 @@
 #include <filesystem> // NEW: for std::filesystem (C++17)
 
 // --- FORWARD DECLARATIONS & Relative includes ---
-// In your real project, you would #include your actual header files.
-// Include the main header from your GNeural DLL library
-#include "../GNeural/NetworkFactory.h"
-#include "../GNeural/InterfaceGNeuralNet.h"
-#include "../GNeural/GNeural.h"
-#include "../GNeural/GNeuralNetOCL.h"
-#include "../GNeural/GTypes.h"   // For types
+// The DLL headers and the header-only engine both live in this repo's include/ directory,
+// which holds the edited GTypes.h, NetworkFactory.h and Utils.h the engine needs.
+#include "include/NetworkFactory.h"
+#include "include/InterfaceGNeuralNet.h"
+#include "include/GNeural.h"
+#include "include/GNeuralNetOCL.h"
+#include "include/GTypes.h"   // For types
+#include "include/GDataset.h" // For GDataset
+#include "include/GDataLoader.h" // For the trade CSV
 
 // If you are using a compiler older than C++17, you might need an alternative
 // for fileExists. See the helper function below.
@@ -30,11 +32,6 @@
 using VectorDouble = std::vector<double>;
 using Topology = std::vector<size_t>;
 
-struct TrainingData {
-    VectorDouble inputs;
-    VectorDouble targets;
-};
-
 typedef enum {
     BUY = 1,
     SELL = -1,
@@ -101,6 +98,7 @@ public:
         m_trainingLaunchers["nor"] = [this]() { return this->runNorTraining(); };
         m_trainingLaunchers["xnor"] = [this]() { return this->runXnorTraining(); };
         m_trainingLaunchers["trade"] = [this]() { return this->runTradeTraining(); };
+        m_trainingLaunchers["all"] = [this]() { return this->runAllGatesConcurrently(); };
     }
 
     /**
@@ -189,6 +187,7 @@ private:
         std::cout << "  - NOR       (Train the NOR gate) : LR(Eta): CPU=0.1 GPU=0.001, mom: 0.1" << std::endl; // NEW
         std::cout << "  - XNOR      (Train the XNOR gate) : LR(Eta): CPU=0.1 GPU=0.001, mom: 0.1" << std::endl; // NEW
         std::cout << "  - TRADE     (Train the Trading Network : LR(Eta): CPU=0.1 GPU=0.001, mom: 0.1)" << std::endl; // NEW
+        std::cout << "  - ALL       (Train all six gates at once, one thread per network, 2-3-1 CPU matrix networks)" << std::endl;
         std::cout << "  - i <gate>            (e.g., 'i xor' to test the XOR gate)" << std::endl;
         std::cout << "  - q / quit  (Exit the program)" << std::endl;
     }
@@ -266,11 +265,13 @@ private:
      * @brief A generic engine for training a neural network for a logic gate.
      * This function handles topology creation, network training, and saving the result.
      * @param gateName The name of the gate (e.g., "XOR"), used for titling and filenames.
-     * @param trainingSet The vector of training data (inputs and target outputs).
+     * @param trainingSet The training data (one input row and one target row per sample).
      * @param activationFunction The activation function to use for the network's neurons.
+     * @param outputLayer OUTPUT_SOFTMAX trains a CPU matrix network with a softmax / cross-entropy output layer.
      * @return True if training was successful, false otherwise.
      */
-    bool runGateTraining(const std::string& gateName, const std::vector<TrainingData>& trainingSet, ENUM_ACTIVATION activationFunction = SIGMOID) {
+    bool runGateTraining(const std::string& gateName, const GDataset& trainingSet, ENUM_ACTIVATION activationFunction = SIGMOID,
+        ENUM_OUTPUT_LAYER outputLayer = OUTPUT_ACTIVATION) {
         std::cout << "\n--- GNeural Library: " << gateName << " Gate Training Test ---" << std::endl;
 
         // The title for the save file (e.g., "AND_Gate.nnw")
@@ -279,8 +280,15 @@ private:
         // Get the desired network structure from the user
         Topology topology = getTopologyFromUser();
 
-        // Create the network
-        m_net = NetworkFactory::CreateNewNetwork(topology);
+        // Create the network; the softmax output layer is a feature of the CPU matrix network
+        if (outputLayer == OUTPUT_SOFTMAX) {
+            auto matrixNet = std::make_unique<GNeuralNetMatrix>(topology);
+            matrixNet->SetOutputLayer(OUTPUT_SOFTMAX);
+            m_net = std::move(matrixNet);
+        }
+        else {
+            m_net = NetworkFactory::CreateNewNetwork(topology);
+        }
         if (!m_net) {
             std::cerr << "FATAL ERROR: Could not create neural network!" << std::endl;
             return false;
@@ -288,7 +296,7 @@ private:
 
         m_net->SetActivationType(activationFunction);
         // Train the network with the provided data
-        bool trainingComplete = trainNetwork(trainingSet);
+        bool trainingComplete = trainNetwork(*m_net, trainingSet);
 
         // Save and verify if training was successful
         if (trainingComplete) {
@@ -313,7 +321,7 @@ private:
      * @return The result of the training process (true for success, false for failure).
      */
     bool runXorTraining() {
-        const std::vector<TrainingData> trainingSet = {
+        const GDataset trainingSet = {
             {{0.0, 0.0}, {0.0}},
             {{0.0, 1.0}, {1.0}},
             {{1.0, 0.0}, {1.0}},
@@ -327,7 +335,7 @@ private:
      * @return The result of the training process (true for success, false for failure).
      */
     bool runAndTraining() {
-        const std::vector<TrainingData> trainingSet = {
+        const GDataset trainingSet = {
             {{0.0, 0.0}, {0.0}},
             {{0.0, 1.0}, {0.0}},
             {{1.0, 0.0}, {0.0}},
@@ -341,7 +349,7 @@ private:
      * @return The result of the training process (true for success, false for failure).
      */
     bool runOrTraining() {
-        const std::vector<TrainingData> trainingSet = {
+        const GDataset trainingSet = {
             {{0.0, 0.0}, {0.0}},
             {{0.0, 1.0}, {1.0}},
             {{1.0, 0.0}, {1.0}},
@@ -355,7 +363,7 @@ private:
      * @return The result of the training process (true for success, false for failure).
      */
     bool runNandTraining() {
-        const std::vector<TrainingData> trainingSet = {
+        const GDataset trainingSet = {
             {{0.0, 0.0}, {1.0}},
             {{0.0, 1.0}, {1.0}},
             {{1.0, 0.0}, {1.0}},
@@ -370,7 +378,7 @@ private:
      * @return The result of the training process (true for success, false for failure).
      */
     bool runNorTraining() {
-        const std::vector<TrainingData> trainingSet = {
+        const GDataset trainingSet = {
             {{0.0, 0.0}, {1.0}},
             {{0.0, 1.0}, {0.0}},
             {{1.0, 0.0}, {0.0}},
@@ -384,7 +392,7 @@ private:
      * @return The result of the training process (true for success, false for failure).
      */
     bool runXnorTraining() {
-        const std::vector<TrainingData> trainingSet = {
+        const GDataset trainingSet = {
             {{0.0, 0.0}, {1.0}},
             {{0.0, 1.0}, {0.0}},
             {{1.0, 0.0}, {0.0}},
@@ -393,22 +401,79 @@ private:
         return runGateTraining("XNOR", trainingSet);
     }
 
+    /**
+     * @brief Trains all six logic gates at the same time, one thread per network.
+     * Each gate gets its own 2-3-1 CPU matrix network whose learning rate lives in the network
+     * (not in the process-wide GNeuron statics), so GTrainer::TrainConcurrently can run them side by side.
+     * @return True if every gate converged and was saved.
+     */
+    bool runAllGatesConcurrently() {
+        std::cout << "\n--- GNeural Library: All Gates Concurrent Training ---" << std::endl;
+        // Gate name and its outputs for the inputs 00, 01, 10, 11
+        const std::vector<std::pair<std::string, VectorDouble>> gates = {
+            { "XOR",  { 0.0, 1.0, 1.0, 0.0 } },
+            { "AND",  { 0.0, 0.0, 0.0, 1.0 } },
+            { "OR",   { 0.0, 1.0, 1.0, 1.0 } },
+            { "NAND", { 1.0, 1.0, 1.0, 0.0 } },
+            { "NOR",  { 1.0, 0.0, 0.0, 0.0 } },
+            { "XNOR", { 1.0, 0.0, 0.0, 1.0 } }
+        };
+        std::vector<GDataset> trainingSets;
+        std::vector<std::unique_ptr<InterfaceGNeuralNet>> networks;
+        for (const auto& gate : gates) {
+            trainingSets.push_back({
+                {{0.0, 0.0}, {gate.second[0]}},
+                {{0.0, 1.0}, {gate.second[1]}},
+                {{1.0, 0.0}, {gate.second[2]}},
+                {{1.0, 1.0}, {gate.second[3]}}
+            });
+            networks.push_back(NetworkFactory::CreateMatrixNetwork({ 2, 3, 1 }));
+            networks.back()->SetTrainingParameters(0.1, 0.1, GNeuronOpenCL::OptimizerType::Momentum, SIGMOID);
+        }
+
+        std::vector<char> converged(gates.size(), 0);
+        GTrainer::TrainConcurrently(networks, [&](InterfaceGNeuralNet& net, unsigned int index) {
+            converged[index] = trainNetwork(net, trainingSets[index], false);
+        });
+
+        bool allConverged = true;
+        for (unsigned int i = 0; i < gates.size(); ++i) {
+            const std::string filename = gates[i].first + "_Gate.nnw";
+            const bool saved = converged[i] && networks[i]->saveNetwork(filename);
+            std::cout << std::setw(5) << gates[i].first << " : "
+                << (converged[i] ? "converged" : "did not converge")
+                << (saved ? ", saved to '" + filename + "'" : "") << std::endl;
+            allConverged = allConverged && saved;
+        }
+        std::cout << "\nTest complete. Ready for new command." << std::endl;
+        return allConverged;
+    }
+
 	/**
      * @brief Prepares a sample training dataset for a trading decision model and initiates training.
      * This model uses one-hot encoding for the output: {SELL, HOLD, BUY}.
-     * It uses the SIGMOID activation function.
+     * Hidden neurons use SIGMOID; the output layer is a softmax trained on cross-entropy.
      * @return The result of the training process (true for success, false for failure).
      */
     bool runTradeTraining() {
         // for complex decision making of for a more robust and standard approach for 3 or more distinct classes
         // is to use one-hot encoding for the output.
         // 3 input neurons, a large hidden layer and 3 output neurons
-        // Activation: For this setup, you can go back to using the Sigmoid function on all output neurons.
-        // When you feed forward an input, the network's output might look like {0.85, 0.12, 0.05},
+        // Output: a softmax layer turns the 3 outputs into class probabilities that sum to 1.
+        // When you feed forward an input, the network's output might look like {0.85, 0.12, 0.03},
         // and you would interpret this as a "Sell" decision because the first neuron has the highest value.
         m_activationFunction = ENUM_ACTIVATION::SIGMOID; // Set the activation function to SIGMOID
 
-        const std::vector<TrainingData> trainingSet = {
+        // Production data: Trade_Data.csv with the columns open,close,low,high,atr,cci,macd,psar,sell,hold,buy.
+        // It is parsed once into Trade_Data.csv.gdc, which later runs load instead.
+        const std::string dataFile = "Trade_Data.csv";
+        GDataset trainingSet;
+        if (fileExists(dataFile) && GDataLoader::Load(dataFile, 8, 3, trainingSet)) {
+            std::cout << "Loaded " << trainingSet.size() << " samples from '" << dataFile << "'." << std::endl;
+            return runGateTraining("Trade", trainingSet, SIGMOID, OUTPUT_SOFTMAX);
+        }
+
+        trainingSet = {
             // Each entry:
             // {{open,  close,  low,   high,   atr,    cci,     macd,   psar}, {SELL, HOLD, BUY}}
 
@@ -442,11 +507,9 @@ private:
             {{1.1330, 1.1332, 1.1310, 1.1350, 0.0042,   25.1,  0.0005, 1.1305}, {0.0, 1.0, 0.0}},
             {{1.0980, 1.0978, 1.0960, 1.0995, 0.0039,  -12.3, -0.0001, 1.0955}, {0.0, 1.0, 0.0}},
         };
-        // We are using the Sigmoid function on all output neurons instead of TanH.
-        // When you feed forward an input, the network's output might look like {0.85, 0.12, 0.05},
-        // and you would interpret this as a "Sell" decision because the first neuron has the highest value.
+        // Softmax + cross-entropy on the output layer instead of three independent sigmoids on squared error.
 		// if necessary, add a - sign to the first neuron output to indicate SELL.
-        return runGateTraining("Trade", trainingSet, SIGMOID);
+        return runGateTraining("Trade", trainingSet, SIGMOID, OUTPUT_SOFTMAX);
 	}
 
 
@@ -463,6 +526,11 @@ private:
         // 1. Create a network object and load the state from the file.
         std::cout << "Loading trained network from '" << network_file << "'..." << std::endl;
         std::unique_ptr<InterfaceGNeuralNet> loadedNet = NetworkFactory::LoadNetworkFromFile(network_file);
+        if (!loadedNet) {
+            // Files written by the 'all' command hold CPU matrix networks
+            auto matrixNet = std::make_unique<GNeuralNetMatrix>();
+            if (matrixNet->loadNetwork(network_file)) loadedNet = std::move(matrixNet);
+        }
 
         if (!loadedNet) {
             std::cerr << "Failed to load the network. Aborting test." << std::endl;
@@ -602,56 +670,39 @@ private:
     }
 
     /**
-     * @brief Manages the core training loop for the neural network.
-     * It iterates through the training data, performing feed-forward and back-propagation passes
-     * until the network's error is low enough for a set number of consecutive epochs or the max number of passes is reached.
+     * @brief Trains the network with the library's epoch trainer (GTrainer::Run).
+     * Training stops once every output stays within the margin of error for a set number of
+     * consecutive epochs, or when the max number of passes is reached.
+     * @param net The network to train.
      * @param trainingSet The dataset to train on.
+     * @param verbose Print progress every 100 passes; off when several networks train at once.
      * @return True if the network trained successfully (converged), false otherwise.
      */
-    bool trainNetwork(const std::vector<TrainingData>& trainingSet) {
-        // Training parameters
-        const double marginOfError = 0.1;
-        const int maxPasses = 500000;
-        const int requiredSuccesses = 3;
-        int consecutiveSuccesses = 3;
-
-        std::cout << "\nStarting training...\n";
-        for (int pass = 1; pass <= maxPasses; ++pass) {
-            bool epochWasSuccessful = true;
-            double epochError = 0.0;
-
-            for (const auto& data : trainingSet) {
+    bool trainNetwork(InterfaceGNeuralNet& net, const GDataset& trainingSet, bool verbose = true) {
+        if (trainingSet.empty()) return false;
 
-                m_net->feedForward(data.inputs);
-                m_net->backPropagate(data.targets);
-
-                VectorDouble results;
-                m_net->getResults(results);
-
-                double error = std::abs(results[0] - data.targets[0]);
-                epochError += error;
-
-                if (error > marginOfError) {
-                    epochWasSuccessful = false;
+        // Training parameters
+        GTrainOptions options;
+        options.marginOfError = 0.1;
+        options.maxPasses = 500000;
+        options.requiredSuccesses = 3;
+        if (verbose) {
+            options.onEpoch = [&](const GEpochMetrics& metrics) {
+                if (metrics.epoch % 100 == 0) {
+                    std::cout << "Pass " << std::setw(5) << metrics.epoch << " | "
+                        << "Consecutive Successes: " << std::setw(2) << metrics.consecutiveSuccesses << "/" << options.requiredSuccesses
+                        << " | Avg Error: " << std::fixed << std::setprecision(4) << metrics.meanAbsError
+                        << std::endl;
+                    net.Display("GNeuralNet : Pass" + std::to_string(metrics.epoch));
                 }
-            }
-
-            consecutiveSuccesses = epochWasSuccessful ? consecutiveSuccesses + 1 : 0;
-
-            if (pass % 100 == 0) {
-                std::cout << "Pass " << std::setw(5) << pass << " | "
-                    << "Consecutive Successes: " << std::setw(2) << consecutiveSuccesses << "/" << requiredSuccesses
-                    << " | Avg Error: " << std::fixed << std::setprecision(4) << (epochError / trainingSet.size())
-                    << std::endl;
-                m_net->Display("GNeuralNet : Pass" + std::to_string(pass));
-            }
-
-            if (consecutiveSuccesses >= requiredSuccesses) {
-                std::cout << "\n--- Training Successful! ---" << std::endl;
                 return true;
-            }
+            };
         }
-        return false;
+
+        if (verbose) std::cout << "\nStarting training...\n";
+        const GTrainResult result = GTrainer::Run(net, trainingSet.view(), options);
+        if (verbose && result.converged) std::cout << "\n--- Training Successful! ---" << std::endl;
+        return result.converged;
     }
 
     /**
@@ -691,11 +742,11 @@ private:
 
     /**
      * @brief Saves the trained network to a file and performs a final verification pass.
-     * It prints the network's output for each entry in the training set to show how well it learned.
+     * It prints the network's output for the first entries of the training set to show how well it learned.
      * @param title The base name for the output file (e.g., "XOR_Gate").
      * @param trainingSet The original training data used for verification.
      */
-    void verifyAndSaveNetwork(const std::string& title, const std::vector<TrainingData>& trainingSet) {
+    void verifyAndSaveNetwork(const std::string& title, const GDataset& trainingSet) {
         std::string filename = title + ".nnw";
         std::cout << "Saving trained network to '" << filename << "'..." << std::endl;
 
@@ -707,18 +758,23 @@ private:
         }
 
         std::cout << "\n--- Final Verification ---" << std::endl;
-        for (const auto& data : trainingSet) {
-            m_net->feedForward(data.inputs);
+        // A loaded dataset can hold millions of rows; show the first ones
+        const size_t shown = std::min<size_t>(trainingSet.size(), 25);
+        VectorDouble scratch;
+        for (size_t s = 0; s < shown; ++s) {
+            const GSpan<const double> inputs = trainingSet.inputRow(s);
+            const GSpan<const double> targets = trainingSet.targetRow(s);
+            GNetSpan::FeedForward(*m_net, inputs, scratch);
             VectorDouble finalResults;
             m_net->getResults(finalResults);
 
             std::cout << "Input:  [";
-            for (size_t i = 0; i < data.inputs.size(); ++i) {
-                std::cout << std::fixed << std::setprecision(4) << data.inputs[i] << (i == data.inputs.size() - 1 ? "" : ", ");
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                std::cout << std::fixed << std::setprecision(4) << inputs[i] << (i == inputs.size() - 1 ? "" : ", ");
             }
             std::cout << "] (Target: [";
-            for (size_t i = 0; i < data.targets.size(); ++i) {
-                std::cout << static_cast<int>(data.targets[i]) << (i == data.targets.size() - 1 ? "" : ", ");
+            for (size_t i = 0; i < targets.size(); ++i) {
+                std::cout << static_cast<int>(targets[i]) << (i == targets.size() - 1 ? "" : ", ");
             }
             std::cout << "] -> Output: [";
             for (size_t i = 0; i < finalResults.size(); ++i) {
@@ -726,6 +782,9 @@ private:
             }
             std::cout << "])" << std::endl;
         }
+        if (shown < trainingSet.size()) {
+            std::cout << "... " << trainingSet.size() - shown << " more samples." << std::endl;
+        }
     }
 
     /**
@@ -0,0 +1,1596 @@
+// GNeuralBench.cpp : Micro-benchmarks for the GNeural CPU backend.
+// Usage: GNeuralBench [benchmark] [file megabytes]   (no argument runs every benchmark)
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <map>
+#include <functional>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <thread>
+#include <memory>
+#include <fstream>
+#include <filesystem>
+#include <cstdio>
+
+#include "../include/GNeuralNetMatrix.h"
+#include "../include/GSimdKernels.h"
+#include "../include/GGemm.h"
+#include "../include/GQuantizedNet.h"
+#include "../include/GStaticNet.h"
+#include "../include/GFrozenNet.h"
+#include "../include/GDataLoader.h"
+#include "../include/GMappedDataset.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Size of the generated files of the 'csv' and 'mapped' benchmarks;
+// "GNeuralBench <benchmark> <megabytes>" overrides it.
+static size_t g_dataMegabytes = 2048;
+
+// Every heap allocation of the process, counted by the replaced global operator new so the
+// 'allocations' benchmark can check the steady-state hot paths.
+static std::atomic<size_t> g_allocations{ 0 };
+
+// Set by a benchmark that checks a guarantee and finds it broken; main() then exits nonzero.
+static bool g_benchFailed = false;
+
+// The replacements below are malloc-backed, so freeing them is correct; GCC inlines the
+// free() into callers that see only the opaque operator new and reports a mismatch.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, std::align_val_t align) {
+    ++g_allocations;
+    const size_t alignment = static_cast<size_t>(align);
+#if defined(_MSC_VER)
+    if (void* p = _aligned_malloc(size ? size : 1, alignment)) return p;
+#else
+    if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) return p;
+#endif
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new[](size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+#if defined(_MSC_VER)
+void operator delete(void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { _aligned_free(p); }
+#else
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+/**
+ * @brief Returns the seconds elapsed since a given time point.
+ */
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Builds a topology {inputs, hidden x numHidden, outputs}.
+ */
+static Topology makeTopology(size_t inputs, size_t hidden, size_t numHidden, size_t outputs) {
+    Topology topology{ inputs };
+    for (size_t i = 0; i < numHidden; ++i) topology.push_back(hidden);
+    topology.push_back(outputs);
+    return topology;
+}
+
+/**
+ * @brief Generates a random dataset of inputs/targets in [0, 1].
+ */
+static void makeDataset(size_t samples, size_t inputs, size_t outputs,
+                        std::vector<VectorDouble>& x, std::vector<VectorDouble>& y) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dis(0.0, 1.0);
+    x.assign(samples, VectorDouble(inputs));
+    y.assign(samples, VectorDouble(outputs));
+    for (size_t s = 0; s < samples; ++s) {
+        for (double& v : x[s]) v = dis(gen);
+        for (double& v : y[s]) v = dis(gen);
+    }
+}
+
+/**
+ * @brief A learnable dataset in the app's trade format: 8 normalized indicators
+ * (open, close, low, high, atr, cci, macd, psar) and one-hot {SELL, HOLD, BUY} targets.
+ * BUY when the candle body, cci and macd together are clearly positive, SELL when they are
+ * clearly negative, HOLD otherwise.
+ */
+static void makeTradeDataset(size_t samples, unsigned seed, std::vector<VectorDouble>& x, std::vector<VectorDouble>& y) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> dis(-1.0, 1.0);
+    x.assign(samples, VectorDouble(8));
+    y.assign(samples, VectorDouble(3, 0.0));
+    for (size_t s = 0; s < samples; ++s) {
+        for (double& v : x[s]) v = dis(gen);
+        const double signal = (x[s][1] - x[s][0]) + x[s][5] + x[s][6];
+        y[s][signal < -0.6 ? 0 : signal > 0.6 ? 2 : 1] = 1.0;
+    }
+}
+
+/**
+ * @brief Training throughput (samples/sec) of GNeuralNetMatrix at every SIMD level
+ * the CPU supports, on the 8 x 100 x 10 x 3 trading topology.
+ */
+static void benchSimdLevels() {
+    std::cout << "\n--- SIMD levels: train samples/sec, topology 8 x 100(x10) x 3 ---" << std::endl;
+    const Topology topology = makeTopology(8, 100, 10, 3);
+    std::vector<VectorDouble> x, y;
+    makeDataset(256, 8, 3, x, y);
+
+    const ENUM_SIMD_LEVEL detected = GSimd::DetectLevel();
+    double baseline = 0.0;
+    for (int level = SIMD_SCALAR; level <= detected; ++level) {
+        GSimd::ForceLevel(static_cast<ENUM_SIMD_LEVEL>(level));
+        srand(1);
+        GNeuralNetMatrix net(topology);
+        net.SetTrainingParameters(0.01, 0.5);
+        const size_t passes = 20;
+        Clock::time_point start = Clock::now();
+        for (size_t p = 0; p < passes; ++p) {
+            for (size_t s = 0; s < x.size(); ++s) {
+                net.feedForward(x[s]);
+                net.backPropagate(y[s]);
+            }
+        }
+        const double rate = passes * x.size() / secondsSince(start);
+        if (level == SIMD_SCALAR) baseline = rate;
+        std::cout << std::setw(10) << GSimd::Kernels().name << " : " << std::fixed << std::setprecision(0)
+            << std::setw(10) << rate << " samples/sec  (x" << std::setprecision(2) << rate / baseline << ")" << std::endl;
+    }
+    GSimd::ForceLevel(detected);
+}
+
+// ===================================================================
+//  Reference: the object-per-connection neuron loop of GNeuron::feedForward
+// ===================================================================
+
+/**
+ * @brief Same footprint as a GNeuralConnection: a GObject (vptr, four list pointers, GUID)
+ * followed by weight, deltaWeight, mt and vt.
+ */
+struct NaiveConnection {
+    virtual ~NaiveConnection() = default;
+    void* links[4] = {};
+    unsigned char guid[16] = {};
+    double weight = 0.0, deltaWeight = 0.0, mt = 0.0, vt = 0.0;
+};
+
+/**
+ * @brief Mirrors GNeuron: each neuron owns its output weights and sums over the previous layer
+ * by reading prevLayer[n].m_outputWeights[m_myIndex], with the activation switch per neuron.
+ */
+struct NaiveNeuron {
+    double outputVal = 0.0;
+    unsigned myIndex = 0;
+    double gradient = 0.0;
+    std::vector<NaiveConnection> outputWeights;
+    ENUM_ACTIVATION activation = SIGMOID;
+
+    void feedForward(const std::vector<NaiveNeuron>& prevLayer) {
+        double sum = 0.0;
+        for (size_t n = 0; n < prevLayer.size(); ++n)
+            sum += prevLayer[n].outputVal * prevLayer[n].outputWeights[myIndex].weight;
+        outputVal = transferFunction(sum);
+    }
+    double transferFunction(double x) const {
+        switch (activation) {
+        case TANH: return tanh(x);
+        case RELU: return x > 0.0 ? x : 0.0;
+        default:   return 1.0 / (1.0 + exp(-x));
+        }
+    }
+};
+
+/**
+ * @brief Forward-only network built from NaiveNeuron layers (bias neuron included).
+ */
+struct NaiveNet {
+    std::vector<std::vector<NaiveNeuron>> layers;
+
+    explicit NaiveNet(const Topology& topology) {
+        for (size_t l = 0; l < topology.size(); ++l) {
+            const size_t numOutputs = l + 1 == topology.size() ? 0 : topology[l + 1];
+            layers.emplace_back(topology[l] + 1);
+            for (size_t n = 0; n < layers.back().size(); ++n) {
+                NaiveNeuron& neuron = layers.back()[n];
+                neuron.myIndex = static_cast<unsigned>(n);
+                neuron.outputWeights.resize(numOutputs);
+                for (NaiveConnection& c : neuron.outputWeights) c.weight = rand() / double(RAND_MAX) - 0.5;
+            }
+            layers.back().back().outputVal = 1.0;
+        }
+    }
+    void feedForward(const VectorDouble& inputs) {
+        for (size_t i = 0; i < inputs.size(); ++i) layers[0][i].outputVal = inputs[i];
+        for (size_t l = 1; l < layers.size(); ++l)
+            for (size_t n = 0; n + 1 < layers[l].size(); ++n)
+                layers[l][n].feedForward(layers[l - 1]);
+    }
+};
+
+/**
+ * @brief Forward throughput of the naive neuron loop against the packed GEMM engine,
+ * from 2-3-1 gate nets up to 1024-wide layers, for batch sizes 1, 16 and 64.
+ */
+static void benchGemm() {
+    std::cout << "\n--- Forward pass: naive GNeuron loop vs GGemm (" << GSimd::Kernels().name << ") ---" << std::endl;
+    const std::vector<std::pair<std::string, Topology>> topologies = {
+        { "2-3-1", { 2, 3, 1 } },
+        { "2-4-4-1", { 2, 4, 4, 1 } },
+        { "8-100x10-3", makeTopology(8, 100, 10, 3) },
+        { "64-256-256-10", { 64, 256, 256, 10 } },
+        { "1024x4", { 1024, 1024, 1024, 1024 } },
+    };
+    std::cout << std::setw(16) << "topology" << std::setw(14) << "naive" << std::setw(14) << "gemv"
+        << std::setw(14) << "gemm b=16" << std::setw(14) << "gemm b=64" << "   (samples/sec)" << std::endl;
+
+    for (const auto& entry : topologies) {
+        const Topology& topology = entry.second;
+        size_t flopsPerSample = 0;
+        for (size_t l = 1; l < topology.size(); ++l) flopsPerSample += 2 * topology[l] * (topology[l - 1] + 1);
+        // Aim for roughly the same amount of work per measurement whatever the size
+        const size_t samples = std::max<size_t>(64, static_cast<size_t>(2e8 / flopsPerSample)) / 64 * 64;
+
+        std::vector<VectorDouble> x, y;
+        makeDataset(64, topology.front(), topology.back(), x, y);
+        VectorDouble flat;
+        for (const VectorDouble& row : x) flat.insert(flat.end(), row.begin(), row.end());
+
+        srand(1);
+        NaiveNet naive(topology);
+        Clock::time_point start = Clock::now();
+        for (size_t s = 0; s < samples; ++s) naive.feedForward(x[s % 64]);
+        const double naiveRate = samples / secondsSince(start);
+
+        GNeuralNetMatrix net(topology);
+        start = Clock::now();
+        for (size_t s = 0; s < samples; ++s) net.feedForward(x[s % 64]);
+        const double gemvRate = samples / secondsSince(start);
+
+        double batchRates[2];
+        const size_t batchSizes[2] = { 16, 64 };
+        for (int i = 0; i < 2; ++i) {
+            start = Clock::now();
+            for (size_t s = 0; s < samples; s += batchSizes[i]) net.feedForwardBatch(flat.data(), batchSizes[i]);
+            batchRates[i] = samples / secondsSince(start);
+        }
+        std::cout << std::setw(16) << entry.first << std::fixed << std::setprecision(0)
+            << std::setw(14) << naiveRate << std::setw(14) << gemvRate
+            << std::setw(14) << batchRates[0] << std::setw(14) << batchRates[1]
+            << "   (gemm b=64 x" << std::setprecision(1) << batchRates[1] / naiveRate << ")" << std::endl;
+    }
+}
+
+/**
+ * @brief Training samples/sec with the intra-layer thread pool at 1, 2, 4, ... threads,
+ * single-sample and at batch 64, from gate-sized nets (which stay serial under the
+ * parallel threshold) up to 1024-wide layers.
+ */
+static void benchThreads() {
+    std::cout << "\n--- Intra-layer threads: train samples/sec (single | batch 64) ---" << std::endl;
+    const std::vector<std::pair<std::string, Topology>> nets = {
+        { "2-4-4-1", { 2, 4, 4, 1 } },
+        { "8-100x10-3", makeTopology(8, 100, 10, 3) },
+        { "64-256-256-10", { 64, 256, 256, 10 } },
+        { "1024x4", { 1024, 1024, 1024, 1024 } },
+    };
+    std::vector<unsigned> threadCounts{ 1 };
+    for (unsigned t = 2; t <= GThreadPool::HardwareThreads(); t *= 2) threadCounts.push_back(t);
+
+    const size_t batch = 64;
+    for (const auto& entry : nets) {
+        const Topology& topology = entry.second;
+        std::vector<VectorDouble> x, y;
+        makeDataset(batch, topology.front(), topology.back(), x, y);
+        VectorDouble flatX, flatY;
+        for (size_t s = 0; s < batch; ++s) {
+            flatX.insert(flatX.end(), x[s].begin(), x[s].end());
+            flatY.insert(flatY.end(), y[s].begin(), y[s].end());
+        }
+        const size_t passes = topology.front() >= 1024 ? 1 : 20;
+        double baseline = 0.0;
+        for (unsigned threads : threadCounts) {
+            srand(1);
+            GNeuralNetMatrix net(topology);
+            net.SetTrainingParameters(0.01, 0.5);
+            net.SetThreadCount(threads);
+
+            Clock::time_point start = Clock::now();
+            for (size_t p = 0; p < passes; ++p) {
+                for (size_t s = 0; s < batch; ++s) {
+                    net.feedForward(x[s]);
+                    net.backPropagate(y[s]);
+                }
+            }
+            const double singleRate = passes * batch / secondsSince(start);
+
+            start = Clock::now();
+            for (size_t p = 0; p < passes * 4; ++p) {
+                net.feedForwardBatch(flatX.data(), batch);
+                net.backPropagateBatch(flatY.data(), batch);
+            }
+            const double batchRate = passes * 4 * batch / secondsSince(start);
+            if (threads == 1) baseline = batchRate;
+            std::cout << std::setw(16) << entry.first << std::setw(4) << threads << " thr" << std::fixed << std::setprecision(0)
+                << std::setw(14) << singleRate << std::setw(14) << batchRate
+                << "   (batch x" << std::setprecision(2) << batchRate / baseline << ")" << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief Data-parallel training scaling: samples/sec of batch-256 training with the
+ * mini-batch sharded over 1 .. all hardware threads (PARALLEL_DATA), next to the
+ * intra-layer split (PARALLEL_LAYER) at the same thread count.
+ */
+static void benchDataParallel() {
+    std::cout << "\n--- Data-parallel scaling: train samples/sec at batch 256 (data | layer) ---" << std::endl;
+    const std::vector<std::pair<std::string, Topology>> nets = {
+        { "8-100x10-3", makeTopology(8, 100, 10, 3) },
+        { "64-256-256-10", { 64, 256, 256, 10 } },
+    };
+    std::vector<unsigned> threadCounts{ 1 };
+    for (unsigned t = 2; t < GThreadPool::HardwareThreads(); t *= 2) threadCounts.push_back(t);
+    if (GThreadPool::HardwareThreads() > 1) threadCounts.push_back(GThreadPool::HardwareThreads());
+
+    const size_t batch = 256, passes = 10;
+    for (const auto& entry : nets) {
+        const Topology& topology = entry.second;
+        std::vector<VectorDouble> x, y;
+        makeDataset(batch, topology.front(), topology.back(), x, y);
+        VectorDouble flatX, flatY;
+        for (size_t s = 0; s < batch; ++s) {
+            flatX.insert(flatX.end(), x[s].begin(), x[s].end());
+            flatY.insert(flatY.end(), y[s].begin(), y[s].end());
+        }
+        double baseline = 0.0;
+        for (unsigned threads : threadCounts) {
+            double rates[2];
+            const ENUM_PARALLEL_MODE modes[2] = { PARALLEL_DATA, PARALLEL_LAYER };
+            for (int m = 0; m < 2; ++m) {
+                srand(1);
+                GNeuralNetMatrix net(topology);
+                net.SetTrainingParameters(0.01, 0.5);
+                net.SetThreadCount(threads);
+                net.SetParallelMode(modes[m]);
+                Clock::time_point start = Clock::now();
+                for (size_t p = 0; p < passes; ++p) {
+                    net.feedForwardBatch(flatX.data(), batch);
+                    net.backPropagateBatch(flatY.data(), batch);
+                }
+                rates[m] = passes * batch / secondsSince(start);
+            }
+            if (threads == 1) baseline = rates[0];
+            std::cout << std::setw(16) << entry.first << std::setw(4) << threads << " thr" << std::fixed << std::setprecision(0)
+                << std::setw(14) << rates[0] << std::setw(14) << rates[1]
+                << "   (data x" << std::setprecision(2) << rates[0] / baseline << ")" << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief Hogwild! convergence vs threads: per-sample SGD on a learnable 8 -> 3 mapping,
+ * the single-threaded feedForward/backPropagate loop against PARALLEL_HOGWILD at
+ * 2 .. all hardware threads. Reports samples/sec and the dataset RMS error per epoch.
+ */
+static void benchHogwild() {
+    std::cout << "\n--- Hogwild: samples/sec and RMS error per epoch, topology 8-64-64-3 ---" << std::endl;
+    const Topology topology{ 8, 64, 64, 3 };
+    const size_t samples = 4096, batch = 256, epochs = 5;
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> dis(0.0, 1.0);
+    VectorDouble flatX(samples * 8), flatY(samples * 3);
+    for (size_t s = 0; s < samples; ++s) {
+        double* in = &flatX[s * 8];
+        for (size_t i = 0; i < 8; ++i) in[i] = dis(gen);
+        flatY[s * 3 + 0] = 1.0 / (1.0 + std::exp(-(in[0] + in[1] - in[2] - in[3]) * 3.0));
+        flatY[s * 3 + 1] = 0.5 + 0.4 * std::sin(3.0 * in[4] * in[5]);
+        flatY[s * 3 + 2] = in[6] > in[7] ? 0.9 : 0.1;
+    }
+    auto datasetError = [&](GNeuralNetMatrix& net) {
+        VectorDouble results;
+        net.feedForwardBatch(flatX.data(), samples);
+        net.getBatchResults(results);
+        double sum = 0.0;
+        for (size_t i = 0; i < results.size(); ++i) sum += (results[i] - flatY[i]) * (results[i] - flatY[i]);
+        return std::sqrt(sum / results.size());
+    };
+
+    std::vector<unsigned> threadCounts{ 1 };
+    for (unsigned t = 2; t < GThreadPool::HardwareThreads(); t *= 2) threadCounts.push_back(t);
+    if (GThreadPool::HardwareThreads() > 1) threadCounts.push_back(GThreadPool::HardwareThreads());
+
+    for (unsigned threads : threadCounts) {
+        srand(1);
+        GNeuralNetMatrix net(topology);
+        net.SetTrainingParameters(0.05, 0.5);
+        net.SetThreadCount(threads);
+        net.SetParallelMode(PARALLEL_HOGWILD);
+        // Zero-centred init; the default [0, 1] weights saturate the sigmoids of this net
+        std::mt19937 init(1);
+        for (size_t l = 1; l < net.getLayerCount(); ++l) {
+            GLayerMatrix& layer = net.getLayer(l);
+            const double scale = 2.0 / std::sqrt(static_cast<double>(layer.getRowLength()));
+            for (size_t n = 0; n < layer.getNeuronCount(); ++n)
+                for (size_t i = 0; i < layer.getRowLength(); ++i)
+                    layer.weight(n, i) = (dis(init) - 0.5) * scale;
+        }
+        double seconds = 0.0;
+        std::cout << std::setw(4) << threads << (threads == 1 ? " thr (serial)" : " thr (hogwild)") << " error/epoch:";
+        for (size_t e = 0; e < epochs; ++e) {
+            Clock::time_point start = Clock::now();
+            for (size_t b0 = 0; b0 < samples; b0 += batch) {
+                if (threads == 1) {
+                    for (size_t s = b0; s < b0 + batch; ++s) {
+                        net.feedForward(VectorDouble(flatX.begin() + s * 8, flatX.begin() + s * 8 + 8));
+                        net.backPropagate(VectorDouble(flatY.begin() + s * 3, flatY.begin() + s * 3 + 3));
+                    }
+                } else {
+                    net.feedForwardBatch(&flatX[b0 * 8], batch);
+                    net.backPropagateBatch(&flatY[b0 * 3], batch);
+                }
+            }
+            seconds += secondsSince(start);
+            net.SetParallelMode(PARALLEL_LAYER);
+            std::cout << std::fixed << std::setprecision(4) << " " << datasetError(net);
+            net.SetParallelMode(PARALLEL_HOGWILD);
+        }
+        std::cout << std::setprecision(0) << "   " << epochs * samples / seconds << " samples/sec" << std::endl;
+    }
+}
+
+/**
+ * @brief Exact (libm) against fast (polynomial exp) tanh/sigmoid: kernel throughput and
+ * measured max error at every SIMD level, then the effect on training: passes for XOR
+ * to converge and the error/throughput of the 8 x 100(x10) x 3 trading topology.
+ */
+static void benchActivation() {
+    std::cout << "\n--- Activation precision: Melem/sec exact | fast, max abs error ---" << std::endl;
+    const size_t n = 4096, repeats = 2000;
+    VectorDouble inputs(n);
+    for (size_t i = 0; i < n; ++i) inputs[i] = -20.0 + 40.0 * i / (n - 1);
+
+    const ENUM_SIMD_LEVEL detected = GSimd::DetectLevel();
+    for (int level = SIMD_SCALAR; level <= detected; ++level) {
+        GSimd::ForceLevel(static_cast<ENUM_SIMD_LEVEL>(level));
+        const GSimdKernels& K = GSimd::Kernels();
+        for (ENUM_ACTIVATION activation : { TANH, SIGMOID }) {
+            VectorDouble exact(inputs), fast(inputs), work(n);
+            K.forActivation(activation, ACTIVATION_EXACT).activate(exact.data(), n);
+            K.forActivation(activation, ACTIVATION_FAST).activate(fast.data(), n);
+            double maxError = 0.0;
+            for (size_t i = 0; i < n; ++i) maxError = std::max(maxError, std::fabs(exact[i] - fast[i]));
+
+            double rates[2];
+            for (int fastPath = 0; fastPath < 2; ++fastPath) {
+                Clock::time_point start = Clock::now();
+                for (size_t r = 0; r < repeats; ++r) {
+                    std::copy(inputs.begin(), inputs.end(), work.begin());
+                    K.forActivation(activation, fastPath ? ACTIVATION_FAST : ACTIVATION_EXACT).activate(work.data(), n);
+                }
+                rates[fastPath] = n * repeats / secondsSince(start) / 1e6;
+            }
+            std::cout << std::setw(10) << K.name << std::setw(9) << (activation == TANH ? "tanh" : "sigmoid")
+                << std::fixed << std::setprecision(0) << std::setw(10) << rates[0] << std::setw(10) << rates[1]
+                << "   (x" << std::setprecision(2) << rates[1] / rates[0] << ")   max error "
+                << std::scientific << std::setprecision(1) << maxError << std::defaultfloat << std::endl;
+        }
+    }
+    GSimd::ForceLevel(detected);
+
+    std::cout << "\n--- Activation precision: training, exact | fast ---" << std::endl;
+    const double xorInputs[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } };
+    const double xorTargets[4] = { 0, 1, 1, 0 };
+    std::vector<VectorDouble> x, y;
+    makeDataset(256, 8, 3, x, y);
+    for (ENUM_ACTIVATION_PRECISION precision : { ACTIVATION_EXACT, ACTIVATION_FAST }) {
+        const char* name = precision == ACTIVATION_EXACT ? "exact" : "fast";
+        // XOR: passes until every output is within 0.1 of its target
+        srand(1);
+        GNeuralNetMatrix xorNet({ 2, 3, 1 });
+        xorNet.SetTrainingParameters(0.5, 0.5, GNeuronOpenCL::OptimizerType::Momentum, SIGMOID);
+        xorNet.SetActivationPrecision(precision);
+        int pass = 1;
+        for (; pass <= 100000; ++pass) {
+            bool converged = true;
+            VectorDouble results;
+            for (int s = 0; s < 4; ++s) {
+                xorNet.feedForward({ xorInputs[s][0], xorInputs[s][1] });
+                xorNet.backPropagate({ xorTargets[s] });
+                xorNet.getResults(results);
+                converged = converged && std::fabs(results[0] - xorTargets[s]) < 0.1;
+            }
+            if (converged) break;
+        }
+        // Trading topology: throughput and error after a fixed number of passes
+        srand(1);
+        GNeuralNetMatrix tradeNet(makeTopology(8, 100, 10, 3));
+        tradeNet.SetTrainingParameters(0.01, 0.5, GNeuronOpenCL::OptimizerType::Momentum, TANH);
+        tradeNet.SetActivationPrecision(precision);
+        const size_t passes = 20;
+        Clock::time_point start = Clock::now();
+        for (size_t p = 0; p < passes; ++p) {
+            for (size_t s = 0; s < x.size(); ++s) {
+                tradeNet.feedForward(x[s]);
+                tradeNet.backPropagate(y[s]);
+            }
+        }
+        const double rate = passes * x.size() / secondsSince(start);
+        std::cout << std::setw(6) << name << " : XOR converged after " << std::setw(6) << pass << " passes | 8-100x10-3 tanh "
+            << std::fixed << std::setprecision(0) << std::setw(8) << rate << " samples/sec, recent error "
+            << std::setprecision(6) << tradeNet.getRecentAverageError() << std::endl;
+    }
+}
+
+/**
+ * @brief Per-neuron activation through a runtime switch, as GNeuron::transferFunction does.
+ */
+static double transferSwitch(ENUM_ACTIVATION activation, double x) {
+    switch (activation) {
+    case TANH: return GSimd::detail::activateOne<TANH, true>(x);
+    case RELU: return GSimd::detail::activateOne<RELU, true>(x);
+    default:   return GSimd::detail::activateOne<SIGMOID, true>(x);
+    }
+}
+
+/**
+ * @brief One layer forward (fast precision) three ways: per neuron an indirect dot call plus
+ * the activation switch; indirect dot calls plus one activation call per layer; and the
+ * compile-time specialized GLayerKernels::forwardLayer with the dot inlined. Outputs must match.
+ */
+static void benchDispatch() {
+    std::cout << "\n--- Activation dispatch: Mneurons/sec per-neuron switch | per-layer call | specialized ("
+        << GSimd::Kernels().name << ") ---" << std::endl;
+    const GSimdKernels& K = GSimd::Kernels();
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> dis(-1.0, 1.0);
+    for (size_t width : { 8, 32, 128, 512 }) {
+        const size_t stride = GPaddedCount<double>(width + 1);
+        GAlignedBuffer<double> weights(width * stride), x(stride), out(width), reference(width);
+        for (size_t n = 0; n < width; ++n)
+            for (size_t i = 0; i <= width; ++i) weights[n * stride + i] = dis(gen) / std::sqrt(double(width));
+        for (size_t i = 0; i < width; ++i) x[i] = dis(gen);
+        x[width] = 1.0;
+        const size_t repeats = std::max<size_t>(1, (size_t(1) << 24) / (width * stride));
+        for (ENUM_ACTIVATION activation : { TANH, SIGMOID, RELU }) {
+            const GLayerKernels& A = K.forActivation(activation, ACTIVATION_FAST);
+            double rates[3], maxDiff = 0.0;
+            for (int path = 0; path < 3; ++path) {
+                double* result = path ? out.data() : reference.data();
+                Clock::time_point start = Clock::now();
+                for (size_t r = 0; r < repeats; ++r) {
+                    if (path == 0) {
+                        for (size_t n = 0; n < width; ++n)
+                            result[n] = transferSwitch(activation, K.dot(weights.data() + n * stride, x.data(), stride));
+                    } else if (path == 1) {
+                        for (size_t n = 0; n < width; ++n)
+                            result[n] = K.dot(weights.data() + n * stride, x.data(), stride);
+                        A.activate(result, width);
+                    } else {
+                        A.forwardLayer(weights.data(), stride, x.data(), result, width);
+                    }
+                }
+                rates[path] = width * repeats / secondsSince(start) / 1e6;
+                for (size_t n = 0; path && n < width; ++n) maxDiff = std::max(maxDiff, std::fabs(result[n] - reference[n]));
+            }
+            static const char* names[] = { "tanh", "sigmoid", "relu" };
+            std::cout << std::setw(6) << width << std::setw(9) << names[activation] << std::fixed << std::setprecision(1)
+                << std::setw(10) << rates[0] << std::setw(10) << rates[1] << std::setw(10) << rates[2]
+                << "   (x" << std::setprecision(2) << rates[2] / rates[0] << ")   max diff "
+                << std::scientific << std::setprecision(1) << maxDiff << std::defaultfloat << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief Overwrites the weights with zero-centred values from a fixed seed, so networks of
+ * different types or storage start from the same point and their outputs do not saturate.
+ */
+template<typename Net>
+static void seedWeights(Net& net, const Topology& topology) {
+    std::mt19937 gen(7);
+    for (size_t l = 1; l < topology.size(); ++l) {
+        std::uniform_real_distribution<double> dis(-1.0 / std::sqrt(double(topology[l - 1])), 1.0 / std::sqrt(double(topology[l - 1])));
+        for (size_t n = 0; n < topology[l]; ++n)
+            for (size_t i = 0; i <= topology[l - 1]; ++i) net.getLayer(l).weight(n, i) = dis(gen);
+    }
+}
+
+/**
+ * @brief Trains and runs one network type on a dataset: per-sample train samples/sec,
+ * batch-64 inference samples/sec, and the final inference outputs for comparison.
+ */
+template<typename Net>
+static void runPrecision(const Topology& topology, const std::vector<VectorDouble>& x, const std::vector<VectorDouble>& y,
+                         double rates[2], size_t& footprint, VectorDouble& results) {
+    Net net(topology);
+    seedWeights(net, topology);
+    net.SetTrainingParameters(0.01, 0.5, GNeuronOpenCL::OptimizerType::Momentum, TANH);
+    const size_t passes = 5, batch = 64, inputs = topology.front();
+    Clock::time_point start = Clock::now();
+    for (size_t p = 0; p < passes; ++p) {
+        for (size_t s = 0; s < x.size(); ++s) {
+            net.feedForward(x[s]);
+            net.backPropagate(y[s]);
+        }
+    }
+    rates[0] = passes * x.size() / secondsSince(start);
+
+    VectorDouble flat(x.size() * inputs);
+    for (size_t s = 0; s < x.size(); ++s) std::copy(x[s].begin(), x[s].end(), flat.begin() + s * inputs);
+    const size_t repeats = 20;
+    start = Clock::now();
+    for (size_t r = 0; r < repeats; ++r)
+        for (size_t s = 0; s + batch <= x.size(); s += batch)
+            net.feedForwardBatch(flat.data() + s * inputs, batch);
+    rates[1] = repeats * (x.size() / batch * batch) / secondsSince(start);
+
+    net.feedForwardBatch(flat.data(), batch);
+    net.getBatchResults(results);
+    footprint = net.getMemoryFootprint();
+}
+
+/**
+ * @brief GNeuralNetMatrix (double) against GNeuralNetMatrixF (float) from the same seed:
+ * training and batched inference throughput, memory held by the layers, and the max
+ * difference between their outputs after the same training.
+ */
+static void benchFloat() {
+    std::cout << "\n--- Scalar type: samples/sec double | float (" << GSimd::Kernels().name << ") ---" << std::endl;
+    const std::vector<std::pair<std::string, Topology>> topologies = {
+        { "8-100x10-3", makeTopology(8, 100, 10, 3) },
+        { "64-256x2-10", makeTopology(64, 256, 2, 10) },
+        { "256-1024-10", { 256, 1024, 10 } },
+    };
+    for (const auto& entry : topologies) {
+        const Topology& topology = entry.second;
+        std::vector<VectorDouble> x, y;
+        makeDataset(256, topology.front(), topology.back(), x, y);
+        double rates[2][2];
+        size_t footprint[2];
+        VectorDouble results[2];
+        runPrecision<GNeuralNetMatrix>(topology, x, y, rates[0], footprint[0], results[0]);
+        runPrecision<GNeuralNetMatrixF>(topology, x, y, rates[1], footprint[1], results[1]);
+        double maxDiff = 0.0;
+        for (size_t i = 0; i < results[0].size(); ++i) maxDiff = std::max(maxDiff, std::fabs(results[0][i] - results[1][i]));
+        std::cout << std::setw(12) << entry.first << std::fixed << std::setprecision(0)
+            << "  train " << std::setw(8) << rates[0][0] << std::setw(8) << rates[1][0]
+            << " (x" << std::setprecision(2) << rates[1][0] / rates[0][0] << ")"
+            << "  infer " << std::setprecision(0) << std::setw(8) << rates[0][1] << std::setw(8) << rates[1][1]
+            << " (x" << std::setprecision(2) << rates[1][1] / rates[0][1] << ")"
+            << "  memory " << footprint[0] / 1024 << " | " << footprint[1] / 1024 << " KB"
+            << "  max diff " << std::scientific << std::setprecision(1) << maxDiff << std::defaultfloat << std::endl;
+    }
+}
+
+/**
+ * @brief One network type of the 'half' benchmark: trains it with full, bfloat16 and IEEE half
+ * weight storage, then prints per-sample and batch-64 inference samples/sec, resident bytes
+ * once the master weights are released, max output difference to the full weights, and the
+ * recent error after the same training (which updates the masters and refreshes the 16-bit copy).
+ */
+template<typename Net>
+static void benchHalfStorage(const Topology& topology, const std::vector<VectorDouble>& x, const std::vector<VectorDouble>& y,
+    const VectorDouble& flat) {
+    static const char* names[] = { "full", "bf16", "fp16" };
+    const size_t inputs = topology.front(), batch = 64;
+    VectorDouble reference;
+    for (ENUM_WEIGHT_STORAGE storage : { STORAGE_FULL, STORAGE_BF16, STORAGE_FP16 }) {
+        Net net(topology);
+        seedWeights(net, topology);
+        net.SetTrainingParameters(0.01, 0.5, GNeuronOpenCL::OptimizerType::Momentum, TANH);
+        net.SetWeightStorage(storage);
+        for (size_t s = 0; s < x.size(); ++s) {
+            net.feedForward(x[s]);
+            net.backPropagate(y[s]);
+        }
+        const double trainedError = net.getRecentAverageError();
+        if (storage != STORAGE_FULL) net.ReleaseMasterWeights();
+
+        const size_t repeats = 10;
+        Clock::time_point start = Clock::now();
+        for (size_t r = 0; r < repeats; ++r)
+            for (size_t s = 0; s < x.size(); ++s) net.feedForward(x[s]);
+        const double sampleRate = repeats * x.size() / secondsSince(start);
+        start = Clock::now();
+        for (size_t r = 0; r < repeats; ++r)
+            for (size_t s = 0; s + batch <= x.size(); s += batch) net.feedForwardBatch(flat.data() + s * inputs, batch);
+        const double batchRate = repeats * (x.size() / batch * batch) / secondsSince(start);
+
+        VectorDouble results;
+        net.feedForwardBatch(flat.data(), batch);
+        net.getBatchResults(results);
+        if (storage == STORAGE_FULL) reference = results;
+        double maxDiff = 0.0;
+        for (size_t i = 0; i < results.size(); ++i) maxDiff = std::max(maxDiff, std::fabs(results[i] - reference[i]));
+        std::cout << std::setw(8) << names[storage] << std::fixed << std::setprecision(0)
+            << "  infer " << std::setw(8) << sampleRate << " | batch " << std::setw(8) << batchRate << " samples/sec"
+            << "  memory " << std::setw(6) << net.getMemoryFootprint() / 1024 << " KB  max diff "
+            << std::scientific << std::setprecision(1) << maxDiff << "  trained error " << std::fixed << std::setprecision(6)
+            << trainedError << std::defaultfloat << std::endl;
+    }
+}
+
+/**
+ * @brief Weight storage of GNeuralNetMatrixF and GNeuralNetMatrix: full weights against
+ * bfloat16 and IEEE half copies, whose kernels accumulate in fp32 for both types.
+ */
+static void benchHalf() {
+    std::cout << "\n--- Weight storage: full | bf16 | fp16 (" << GSimd::HalfKernels<float, GBFloat16>().name << ", "
+        << GSimd::HalfKernels<float, GFloat16>().name << ") ---" << std::endl;
+    const std::vector<std::pair<std::string, Topology>> topologies = {
+        { "8-100x10-3", makeTopology(8, 100, 10, 3) },
+        { "256-1024x2-10", makeTopology(256, 1024, 2, 10) },
+    };
+    for (const auto& entry : topologies) {
+        const Topology& topology = entry.second;
+        std::vector<VectorDouble> x, y;
+        makeDataset(256, topology.front(), topology.back(), x, y);
+        const size_t inputs = topology.front();
+        VectorDouble flat(x.size() * inputs);
+        for (size_t s = 0; s < x.size(); ++s) std::copy(x[s].begin(), x[s].end(), flat.begin() + s * inputs);
+
+        std::cout << entry.first << " float" << std::endl;
+        benchHalfStorage<GNeuralNetMatrixF>(topology, x, y, flat);
+        std::cout << entry.first << " double" << std::endl;
+        benchHalfStorage<GNeuralNetMatrix>(topology, x, y, flat);
+    }
+}
+
+/**
+ * @brief Post-training int8 quantization of GNeuralNetMatrix: per-sample inference
+ * samples/sec of the double network, its float copy and the int8 network (per-row and
+ * per-layer weight scales), bytes held and the largest output difference. The accuracy
+ * delta is measured on held-out samples of a trade model trained until it classifies its
+ * whole training set correctly, where it means something.
+ */
+static void benchInt8() {
+    std::cout << "\n--- Int8 inference: double | float | int8 (" << GSimd::Int8Kernels().name << ") ---" << std::endl;
+    const std::vector<std::pair<std::string, Topology>> topologies = {
+        { "8-100x10-3", makeTopology(8, 100, 10, 3) },
+        { "256-1024x2-10", makeTopology(256, 1024, 2, 10) },
+    };
+    for (const auto& entry : topologies) {
+        const Topology& topology = entry.second;
+        const size_t inputs = topology.front(), outputs = topology.back();
+        std::vector<VectorDouble> x, y;
+        makeDataset(256, inputs, outputs, x, y);
+        VectorDouble flatX(x.size() * inputs), flatY(y.size() * outputs);
+        for (size_t s = 0; s < x.size(); ++s) {
+            std::copy(x[s].begin(), x[s].end(), flatX.begin() + s * inputs);
+            std::copy(y[s].begin(), y[s].end(), flatY.begin() + s * outputs);
+        }
+        GNeuralNetMatrix net(topology);
+        seedWeights(net, topology);
+        net.SetActivationType(TANH);
+        GNeuralNetMatrixF netF(topology);
+        for (size_t l = 1; l < topology.size(); ++l)
+            for (size_t n = 0; n < topology[l]; ++n)
+                for (size_t i = 0; i <= topology[l - 1]; ++i) netF.getLayer(l).weight(n, i) = float(net.getLayer(l).weight(n, i));
+        netF.SetActivationType(TANH);
+
+        const size_t repeats = 10;
+        auto rate = [&](auto& model) {
+            Clock::time_point start = Clock::now();
+            for (size_t r = 0; r < repeats; ++r)
+                for (size_t s = 0; s < x.size(); ++s) model.feedForward(x[s]);
+            return repeats * x.size() / secondsSince(start);
+        };
+        std::cout << entry.first << std::fixed << std::setprecision(0)
+            << "  double " << std::setw(8) << rate(net) << " samples/sec, " << net.getMemoryFootprint() / 1024 << " KB"
+            << "  float " << std::setw(8) << rate(netF) << " samples/sec, " << netF.getMemoryFootprint() / 1024 << " KB" << std::endl;
+        for (ENUM_QUANT_GRANULARITY granularity : { QUANT_PER_ROW, QUANT_PER_LAYER }) {
+            GQuantizedNet quantized;
+            quantized.quantize(net, flatX.data(), x.size(), granularity);
+            const double int8Rate = rate(quantized);
+            const GQuantizationReport report = quantized.compare(net, flatX.data(), flatY.data(), x.size());
+            std::cout << std::setw(12) << (granularity == QUANT_PER_ROW ? "int8/row" : "int8/layer") << std::fixed << std::setprecision(0)
+                << "  infer " << std::setw(8) << int8Rate << " samples/sec, " << quantized.getMemoryFootprint() / 1024 << " KB"
+                << "  max diff " << std::scientific << std::setprecision(1) << report.maxAbsDiff << std::defaultfloat << std::endl;
+        }
+    }
+
+    // Accuracy: a converged 8-100x10-3 trade model, calibrated on its training set and
+    // compared on samples it has not seen
+    const Topology topology = makeTopology(8, 100, 10, 3);
+    std::vector<VectorDouble> x, y, testX, testY;
+    makeTradeDataset(2048, 1, x, y);
+    makeTradeDataset(1024, 2, testX, testY);
+    GDataset trainingSet(8, 3);
+    VectorDouble flatX, flatTestX, flatTestY;
+    for (size_t s = 0; s < x.size(); ++s) {
+        trainingSet.addSample(x[s], y[s]);
+        flatX.insert(flatX.end(), x[s].begin(), x[s].end());
+    }
+    for (size_t s = 0; s < testX.size(); ++s) {
+        flatTestX.insert(flatTestX.end(), testX[s].begin(), testX[s].end());
+        flatTestY.insert(flatTestY.end(), testY[s].begin(), testY[s].end());
+    }
+    GNeuralNetMatrix net(topology);
+    seedWeights(net, topology);
+    net.SetTrainingParameters(0.01, 0.5, GNeuronOpenCL::OptimizerType::Momentum, TANH);
+    // Every output within 0.5 of its 0/1 target: every training sample classified correctly
+    GTrainOptions options;
+    options.marginOfError = 0.5;
+    options.maxPasses = 500;
+    options.shuffle = true;
+    const GTrainResult trained = GTrainer::Run(net, trainingSet.view(), options);
+    std::cout << "trade 8-100x10-3 " << (trained.converged ? "converged" : "not converged") << " after " << trained.epochs
+        << " epochs, " << testX.size() << " held-out samples" << std::endl;
+    for (ENUM_QUANT_GRANULARITY granularity : { QUANT_PER_ROW, QUANT_PER_LAYER }) {
+        GQuantizedNet quantized;
+        quantized.quantize(net, flatX.data(), x.size(), granularity);
+        const GQuantizationReport report = quantized.compare(net, flatTestX.data(), flatTestY.data(), testX.size());
+        std::cout << std::setw(12) << (granularity == QUANT_PER_ROW ? "int8/row" : "int8/layer")
+            << "  max diff " << std::scientific << std::setprecision(1) << report.maxAbsDiff
+            << "  rms error " << std::fixed << std::setprecision(4) << report.referenceError << " -> " << report.quantizedError
+            << "  accuracy " << report.referenceAccuracy << " -> " << report.quantizedAccuracy
+            << "  agreement " << report.agreement << std::defaultfloat << std::endl;
+    }
+}
+
+/**
+ * @brief Trains one gate topology on XOR both ways from the same weights: GNeuralNetMatrix
+ * through InterfaceGNeuralNet (virtual calls, VectorDouble) against GStaticNet. Prints
+ * train and inference samples/sec and the max output difference after training.
+ */
+template<size_t... Sizes>
+static void runStaticGate(const char* name) {
+    const double inputs[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } }, targets[4] = { 0, 1, 1, 0 };
+    const size_t passes = 20000;
+    GNeuralNetMatrix matrix(Topology{ Sizes... });
+    GStaticNet<Sizes...> fixed;
+    fixed.importWeights(matrix);
+    InterfaceGNeuralNet& net = matrix;
+    net.SetTrainingParameters(0.1, 0.5, GNeuronOpenCL::OptimizerType::Momentum, TANH);
+    fixed.SetTrainingParameters(0.1, 0.5, TANH);
+    std::vector<VectorDouble> x(4), y(4);
+    for (size_t k = 0; k < 4; ++k) {
+        x[k].assign(inputs[k], inputs[k] + 2);
+        y[k].assign(1, targets[k]);
+    }
+
+    Clock::time_point start = Clock::now();
+    VectorDouble results;
+    for (size_t p = 0; p < passes; ++p)
+        for (size_t k = 0; k < 4; ++k) {
+            net.feedForward(x[k]);
+            net.backPropagate(y[k]);
+            net.getResults(results);
+        }
+    const double matrixTrain = passes * 4 / secondsSince(start);
+    start = Clock::now();
+    double out[1];
+    for (size_t p = 0; p < passes; ++p)
+        for (size_t k = 0; k < 4; ++k) {
+            fixed.feedForward(inputs[k]);
+            fixed.backPropagate(&targets[k]);
+            fixed.getResults(out);
+        }
+    const double fixedTrain = passes * 4 / secondsSince(start);
+
+    start = Clock::now();
+    volatile double sink = 0.0;
+    for (size_t p = 0; p < passes; ++p)
+        for (size_t k = 0; k < 4; ++k) {
+            net.feedForward(x[k]);
+            net.getResults(results);
+            sink = results[0];
+        }
+    const double matrixInfer = passes * 4 / secondsSince(start);
+    start = Clock::now();
+    for (size_t p = 0; p < passes; ++p)
+        for (size_t k = 0; k < 4; ++k) {
+            fixed.feedForward(inputs[k]);
+            fixed.getResults(out);
+            sink = out[0];
+        }
+    const double fixedInfer = passes * 4 / secondsSince(start);
+    (void)sink;
+
+    double maxDiff = 0.0;
+    for (size_t k = 0; k < 4; ++k) {
+        net.feedForward(x[k]);
+        net.getResults(results);
+        fixed.feedForward(inputs[k]);
+        maxDiff = std::max(maxDiff, std::fabs(results[0] - fixed.results()[0]));
+    }
+    std::cout << std::setw(8) << name << std::fixed << std::setprecision(0)
+        << "  train " << std::setw(10) << matrixTrain << std::setw(10) << fixedTrain << " (x" << std::setprecision(1) << fixedTrain / matrixTrain << ")"
+        << "  infer " << std::setprecision(0) << std::setw(10) << matrixInfer << std::setw(10) << fixedInfer << " (x" << std::setprecision(1) << fixedInfer / matrixInfer << ")"
+        << "  max diff " << std::scientific << std::setprecision(1) << maxDiff << std::defaultfloat << std::endl;
+}
+
+/**
+ * @brief Logic-gate sized nets: GNeuralNetMatrix behind the virtual interface against the
+ * fixed-topology GStaticNet, samples/sec for XOR training and inference.
+ */
+static void benchStatic() {
+    std::cout << "\n--- Tiny nets: samples/sec GNeuralNetMatrix | GStaticNet (" << GSimd::Kernels().name << ") ---" << std::endl;
+    runStaticGate<2, 3, 1>("2-3-1");
+    runStaticGate<2, 4, 4, 1>("2-4-4-1");
+}
+
+/**
+ * @brief Frozen inference copies against the trained GNeuralNetMatrix: bytes held, per-sample
+ * samples/sec, the max output difference, and the aggregate rate of 1, 2 and 4 threads
+ * sharing one const GFrozenNet.
+ */
+static void benchFrozen() {
+    std::cout << "\n--- Frozen inference: GNeuralNetMatrix | GFrozenNet (" << GSimd::Kernels().name << ") ---" << std::endl;
+    const std::vector<std::pair<std::string, Topology>> topologies = {
+        { "8-100x10-3", makeTopology(8, 100, 10, 3) },
+        { "256-1024x2-10", makeTopology(256, 1024, 2, 10) },
+    };
+    for (const auto& entry : topologies) {
+        const Topology& topology = entry.second;
+        std::vector<VectorDouble> x, y;
+        makeDataset(256, topology.front(), topology.back(), x, y);
+        GNeuralNetMatrix net(topology);
+        seedWeights(net, topology);
+        net.SetTrainingParameters(0.01, 0.5, GNeuronOpenCL::OptimizerType::Adam, TANH);
+        for (size_t s = 0; s < x.size(); ++s) {
+            net.feedForward(x[s]);
+            net.backPropagate(y[s]);
+        }
+        const GFrozenNet frozen = net.freeze();
+
+        const size_t repeats = 10;
+        VectorDouble results(topology.back()), frozenResults(topology.back());
+        Clock::time_point start = Clock::now();
+        for (size_t r = 0; r < repeats; ++r)
+            for (size_t s = 0; s < x.size(); ++s) {
+                net.feedForward(GSpan<const double>(x[s]));
+                net.getResults(GSpan<double>(results));
+            }
+        const double netRate = repeats * x.size() / secondsSince(start);
+        start = Clock::now();
+        for (size_t r = 0; r < repeats; ++r)
+            for (size_t s = 0; s < x.size(); ++s)
+                frozen.infer(x[s], frozenResults);
+        const double frozenRate = repeats * x.size() / secondsSince(start);
+        double maxDiff = 0.0;
+        for (size_t s = 0; s < x.size(); ++s) {
+            net.feedForward(GSpan<const double>(x[s]));
+            net.getResults(GSpan<double>(results));
+            frozen.infer(x[s], frozenResults);
+            for (size_t k = 0; k < results.size(); ++k)
+                maxDiff = std::max(maxDiff, std::fabs(results[k] - frozenResults[k]));
+        }
+        std::cout << entry.first << std::fixed << std::setprecision(0)
+            << "  net " << std::setw(8) << netRate << " samples/sec, " << net.getMemoryFootprint() / 1024 << " KB"
+            << "  frozen " << std::setw(8) << frozenRate << " samples/sec, " << frozen.getMemoryFootprint() / 1024 << " KB"
+            << "  max diff " << std::scientific << std::setprecision(1) << maxDiff << std::defaultfloat << std::endl;
+
+        std::cout << std::setw(16) << "shared";
+        for (unsigned threads : { 1u, 2u, 4u }) {
+            std::vector<std::thread> workers;
+            start = Clock::now();
+            for (unsigned t = 0; t < threads; ++t)
+                workers.emplace_back([&] {
+                    VectorDouble out(topology.back());
+                    for (size_t r = 0; r < repeats; ++r)
+                        for (size_t s = 0; s < x.size(); ++s)
+                            frozen.infer(x[s], out);
+                });
+            for (std::thread& worker : workers)
+                worker.join();
+            std::cout << "  " << threads << "T " << std::fixed << std::setprecision(0) << std::setw(8)
+                << threads * repeats * x.size() / secondsSince(start) << std::defaultfloat;
+        }
+        std::cout << " samples/sec" << std::endl;
+    }
+}
+
+/**
+ * @brief Serving 4 worker threads: one GNeuralNetMatrix copy per worker (feedForward +
+ * getResults) against one shared network, and one shared GFrozenNet, with a
+ * GInferenceContext per worker. Bytes held by the models and contexts, and the aggregate
+ * inference samples/sec.
+ */
+static void benchShared() {
+    const unsigned workers = 4;
+    std::cout << "\n--- " << workers << " inference workers: per-worker copies | shared net + contexts | shared frozen + contexts ---" << std::endl;
+    const std::vector<std::pair<std::string, Topology>> topologies = {
+        { "8-100x10-3", makeTopology(8, 100, 10, 3) },
+        { "256-1024x2-10", makeTopology(256, 1024, 2, 10) },
+    };
+    for (const auto& entry : topologies) {
+        const Topology& topology = entry.second;
+        std::vector<VectorDouble> x, y;
+        makeDataset(256, topology.front(), topology.back(), x, y);
+        GNeuralNetMatrix net(topology);
+        seedWeights(net, topology);
+        net.SetActivationType(TANH);
+        const GFrozenNet frozen = net.freeze();
+        std::vector<std::unique_ptr<GNeuralNetMatrix>> copies;
+        for (unsigned w = 0; w < workers; ++w) {
+            copies.emplace_back(new GNeuralNetMatrix(topology));
+            for (size_t l = 1; l < topology.size(); ++l)
+                copies.back()->getLayer(l).weights() = net.getLayer(l).weights();
+            copies.back()->SetActivationType(TANH);
+        }
+        std::vector<GInferenceContext> contexts;
+        for (unsigned w = 0; w < workers; ++w)
+            contexts.push_back(net.createContext());
+
+        const size_t repeats = 5;
+        auto rate = [&](const std::function<void(unsigned, const VectorDouble&, VectorDouble&)>& infer) {
+            std::vector<std::thread> threads;
+            Clock::time_point start = Clock::now();
+            for (unsigned w = 0; w < workers; ++w)
+                threads.emplace_back([&, w] {
+                    VectorDouble out(topology.back());
+                    for (size_t r = 0; r < repeats; ++r)
+                        for (size_t s = 0; s < x.size(); ++s)
+                            infer(w, x[s], out);
+                });
+            for (std::thread& thread : threads)
+                thread.join();
+            return workers * repeats * x.size() / secondsSince(start);
+        };
+        const double copiesRate = rate([&](unsigned w, const VectorDouble& in, VectorDouble& out) {
+            copies[w]->feedForward(GSpan<const double>(in));
+            copies[w]->getResults(GSpan<double>(out));
+        });
+        const double sharedRate = rate([&](unsigned w, const VectorDouble& in, VectorDouble& out) { net.infer(contexts[w], in, out); });
+        const double frozenRate = rate([&](unsigned w, const VectorDouble& in, VectorDouble& out) { frozen.infer(contexts[w], in, out); });
+        const size_t contextBytes = workers * contexts.front().getMemoryFootprint();
+        std::cout << entry.first << std::fixed << std::setprecision(0)
+            << "  copies " << std::setw(8) << copiesRate << " samples/sec, " << workers * net.getMemoryFootprint() / 1024 << " KB"
+            << "  shared " << std::setw(8) << sharedRate << " samples/sec, " << (net.getMemoryFootprint() + contextBytes) / 1024 << " KB"
+            << "  frozen " << std::setw(8) << frozenRate << " samples/sec, " << (frozen.getMemoryFootprint() + contextBytes) / 1024 << " KB"
+            << std::defaultfloat << std::endl;
+    }
+}
+
+/**
+ * @brief Three-class classification (class = argmax of three fixed random projections of 8
+ * inputs, one-hot targets) on 8-16-3 nets from the same weights: sigmoid outputs on squared
+ * error against a softmax output layer on cross-entropy, at learning rate 0.02. Epochs to 99%
+ * training accuracy (capped at 500), per-sample training samples/sec and the final accuracy.
+ */
+static void benchSoftmax() {
+    std::cout << "\n--- 3-class training: sigmoid + MSE | softmax + cross-entropy (8-16-3) ---" << std::endl;
+    const size_t samples = 512, inputs = 8, classes = 3, maxEpochs = 500;
+    const Topology topology{ inputs, 16, classes };
+    std::mt19937 gen(11);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::vector<VectorDouble> projections(classes, VectorDouble(inputs));
+    for (VectorDouble& p : projections)
+        for (double& v : p) v = normal(gen);
+    std::vector<VectorDouble> x(samples, VectorDouble(inputs)), y(samples, VectorDouble(classes, 0.0));
+    std::vector<size_t> labels(samples);
+    for (size_t s = 0; s < samples; ++s) {
+        for (double& v : x[s]) v = normal(gen);
+        double best = -1e300;
+        for (size_t c = 0; c < classes; ++c) {
+            double score = 0.0;
+            for (size_t i = 0; i < inputs; ++i) score += projections[c][i] * x[s][i];
+            if (score > best) { best = score; labels[s] = c; }
+        }
+        y[s][labels[s]] = 1.0;
+    }
+    for (ENUM_OUTPUT_LAYER outputLayer : { OUTPUT_ACTIVATION, OUTPUT_SOFTMAX }) {
+        GNeuralNetMatrix net(topology);
+        seedWeights(net, topology);
+        net.SetTrainingParameters(0.02, 0.5, GNeuronOpenCL::OptimizerType::Momentum, SIGMOID);
+        net.SetOutputLayer(outputLayer);
+        VectorDouble results(classes);
+        auto accuracy = [&] {
+            size_t correct = 0;
+            for (size_t s = 0; s < samples; ++s) {
+                net.feedForward(GSpan<const double>(x[s]));
+                net.getResults(GSpan<double>(results));
+                correct += size_t(std::max_element(results.begin(), results.end()) - results.begin()) == labels[s];
+            }
+            return double(correct) / samples;
+        };
+        size_t epochs = 0;
+        double acc = 0.0, seconds = 0.0;
+        while (epochs < maxEpochs && acc < 0.99) {
+            Clock::time_point start = Clock::now();
+            for (size_t s = 0; s < samples; ++s) {
+                net.feedForward(GSpan<const double>(x[s]));
+                net.backPropagate(GSpan<const double>(y[s]));
+            }
+            seconds += secondsSince(start);
+            ++epochs;
+            acc = accuracy();
+        }
+        std::cout << std::setw(24) << (outputLayer == OUTPUT_SOFTMAX ? "softmax + cross-entropy" : "sigmoid + MSE")
+            << "  epochs " << std::setw(4) << epochs << (acc < 0.99 ? "+" : " ") << std::fixed << std::setprecision(0)
+            << "  train " << std::setw(8) << epochs * samples / seconds << " samples/sec"
+            << "  accuracy " << std::setprecision(3) << acc << std::defaultfloat << std::endl;
+    }
+}
+
+/**
+ * @brief Epoch training samples/sec of the application-side loop (feedForward, backPropagate
+ * and getResults through InterfaceGNeuralNet per sample, error recomputed by the caller)
+ * against GTrainer::Run per sample and at batch 64, for a fixed number of epochs.
+ */
+static void benchTrain() {
+    std::cout << "\n--- Epoch training: app loop | GTrainer::Run | Run batch 64 (samples/sec) ---" << std::endl;
+    const std::vector<std::pair<std::string, Topology>> topologies = {
+        { "2-3-1", Topology{ 2, 3, 1 } },
+        { "8-64-64-3", makeTopology(8, 64, 2, 3) },
+    };
+    for (const auto& entry : topologies) {
+        const Topology& topology = entry.second;
+        const size_t inputs = topology.front(), outputs = topology.back();
+        std::vector<VectorDouble> x, y;
+        makeDataset(256, inputs, outputs, x, y);
+        GDataset dataset(inputs, outputs);
+        for (size_t s = 0; s < x.size(); ++s)
+            dataset.addSample(x[s], y[s]);
+        const size_t epochs = topology.size() == 3 ? 400 : 20;
+
+        GNeuralNetMatrix appNet(topology);
+        InterfaceGNeuralNet& app = appNet;
+        VectorDouble results;
+        volatile double sink = 0.0;
+        Clock::time_point start = Clock::now();
+        for (size_t e = 0; e < epochs; ++e)
+            for (size_t s = 0; s < x.size(); ++s) {
+                app.feedForward(x[s]);
+                app.backPropagate(y[s]);
+                app.getResults(results);
+                sink = std::fabs(results[0] - y[s][0]);
+            }
+        const double appRate = epochs * x.size() / secondsSince(start);
+        (void)sink;
+
+        GTrainOptions options;
+        options.maxPasses = epochs;
+        options.requiredSuccesses = int(epochs) + 1;
+        auto trainRate = [&](size_t batchSize) {
+            GNeuralNetMatrix net(topology);
+            InterfaceGNeuralNet& base = net;
+            options.batchSize = batchSize;
+            Clock::time_point begin = Clock::now();
+            const GTrainResult result = GTrainer::Run(base, dataset.view(), options);
+            return result.epochs * x.size() / secondsSince(begin);
+        };
+        const double trainSample = trainRate(1);
+        const double trainBatch = trainRate(64);
+        std::cout << std::setw(10) << entry.first << std::fixed << std::setprecision(0)
+            << "  app loop " << std::setw(10) << appRate
+            << "  Run() " << std::setw(10) << trainSample << " (x" << std::setprecision(2) << trainSample / appRate << ")"
+            << "  batch 64 " << std::setprecision(0) << std::setw(10) << trainBatch << " (x" << std::setprecision(2) << trainBatch / appRate << ")"
+            << std::defaultfloat << std::endl;
+    }
+}
+
+/**
+ * @brief Mini-batch training (batch 64) over a 16384-sample GDataset: dataset order straight
+ * from the view, a shuffled order gathered from per-sample vectors on the training thread
+ * before every batch, and a shuffled GBatchLoader, which gathers the next batch in the
+ * background. Samples/sec.
+ */
+static void benchDataset() {
+    std::cout << "\n--- Batch 64 training: in order | shuffled, inline gather | shuffled, prefetched (samples/sec) ---" << std::endl;
+    const std::vector<std::pair<std::string, Topology>> topologies = {
+        { "64-32-10", Topology{ 64, 32, 10 } },
+        { "256-256-10", Topology{ 256, 256, 10 } },
+    };
+    const size_t samples = 16384, batchSize = 64, epochs = 3;
+    for (const auto& entry : topologies) {
+        const Topology& topology = entry.second;
+        const size_t inputs = topology.front(), outputs = topology.back();
+        std::vector<VectorDouble> x, y;
+        makeDataset(samples, inputs, outputs, x, y);
+        GDataset dataset(inputs, outputs);
+        dataset.reserve(samples);
+        for (size_t s = 0; s < samples; ++s)
+            dataset.addSample(x[s], y[s]);
+
+        // Same training step for every variant; only the source of the batch rows differs
+        auto loaderRate = [&](bool shuffle) {
+            GNeuralNetMatrix net(topology);
+            GBatchLoader loader(dataset.view(), batchSize, shuffle, 0);
+            GBatchView batch;
+            Clock::time_point begin = Clock::now();
+            for (size_t e = 0; e < epochs; ++e) {
+                loader.startEpoch();
+                while (loader.next(batch)) {
+                    net.feedForwardBatch(batch.inputs, batch.rows);
+                    net.backPropagateBatch(batch.targets, batch.rows);
+                }
+            }
+            return epochs * samples / secondsSince(begin);
+        };
+        const double ordered = loaderRate(false);
+
+        GNeuralNetMatrix inlineNet(topology);
+        std::vector<size_t> order(samples);
+        std::mt19937 gen(0);
+        VectorDouble batchX(batchSize * inputs), batchY(batchSize * outputs);
+        Clock::time_point start = Clock::now();
+        for (size_t e = 0; e < epochs; ++e) {
+            for (size_t i = 0; i < samples; ++i) order[i] = i;
+            std::shuffle(order.begin(), order.end(), gen);
+            for (size_t b0 = 0; b0 < samples; b0 += batchSize) {
+                const size_t rows = std::min(batchSize, samples - b0);
+                for (size_t r = 0; r < rows; ++r) {
+                    std::copy(x[order[b0 + r]].begin(), x[order[b0 + r]].end(), batchX.begin() + r * inputs);
+                    std::copy(y[order[b0 + r]].begin(), y[order[b0 + r]].end(), batchY.begin() + r * outputs);
+                }
+                inlineNet.feedForwardBatch(batchX.data(), rows);
+                inlineNet.backPropagateBatch(batchY.data(), rows);
+            }
+        }
+        const double inlineGather = epochs * samples / secondsSince(start);
+        const double prefetched = loaderRate(true);
+
+        std::cout << std::setw(10) << entry.first << std::fixed << std::setprecision(0)
+            << "  in order " << std::setw(10) << ordered
+            << "  inline gather " << std::setw(10) << inlineGather
+            << "  prefetched " << std::setw(10) << prefetched << " (x" << std::setprecision(2) << prefetched / inlineGather << ")"
+            << std::defaultfloat << std::endl;
+    }
+}
+
+/**
+ * @brief Loading of a generated trade CSV (8 indicator inputs, 3 one-hot targets per row, about
+ * 75 bytes a row) of g_dataMegabytes: a std::getline + strtod loop, GDataLoader::LoadCsv
+ * (background chunk reader, SWAR number parser) and the binary cache written from it.
+ * Rows/sec and MB/sec of CSV; the files are deleted afterwards.
+ */
+static void benchCsv() {
+    std::cout << "\n--- Trade CSV loading, " << g_dataMegabytes << " MB: getline + strtod | LoadCsv | binary cache (rows/sec) ---" << std::endl;
+    const std::string csvFile = "GNeuralBench_trade.csv";
+    const std::string cacheFile = GDataLoader::CachePath(csvFile);
+    const size_t inputs = 8, outputs = 3;
+
+    // A pool of random rows in the format of the app's trade set, written until the size is reached
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> price(1.05, 1.15), range(0.0, 0.01), cci(-150.0, 150.0), macd(-0.003, 0.003);
+    std::vector<std::string> pool(4096);
+    for (std::string& row : pool) {
+        const double open = price(gen), close = open + range(gen) - 0.005;
+        const int label = int(gen() % 3);
+        char line[256];
+        std::snprintf(line, sizeof(line), "%.4f,%.4f,%.4f,%.4f,%.4f,%.1f,%.4f,%.4f,%d,%d,%d\n",
+            open, close, std::min(open, close) - range(gen), std::max(open, close) + range(gen), range(gen), cci(gen), macd(gen),
+            open - range(gen), label == 0, label == 1, label == 2);
+        row = line;
+    }
+    {
+        std::ofstream out(csvFile, std::ios::binary);
+        out << "open,close,low,high,atr,cci,macd,psar,sell,hold,buy\n";
+        const size_t bytes = g_dataMegabytes << 20;
+        std::string block;
+        for (const std::string& row : pool) block += row;
+        for (size_t written = 0; written < bytes; written += block.size()) out << block;
+        if (!out) {
+            std::cerr << "Could not write " << csvFile << std::endl;
+            return;
+        }
+    }
+    const double megabytes = double(std::filesystem::file_size(csvFile)) / (1 << 20);
+    auto report = [&](const char* name, size_t rows, double seconds, double mb) {
+        std::cout << std::setw(16) << name << std::fixed << std::setprecision(0)
+            << std::setw(12) << rows / seconds << " rows/s" << std::setw(8) << mb / seconds << " MB/s"
+            << std::setprecision(2) << std::setw(8) << seconds << " s" << std::defaultfloat << std::endl;
+    };
+
+    size_t rows = 0;
+    {
+        Clock::time_point start = Clock::now();
+        std::ifstream in(csvFile);
+        std::string line;
+        std::getline(in, line);
+        GDataset data(inputs, outputs);
+        double row[11];
+        while (std::getline(in, line)) {
+            const char* p = line.c_str();
+            for (double& v : row) {
+                char* next = nullptr;
+                v = std::strtod(p, &next);
+                p = next + 1;
+            }
+            data.addSample(GSpan<const double>(row, inputs), GSpan<const double>(row + inputs, outputs));
+        }
+        rows = data.size();
+        report("getline+strtod", rows, secondsSince(start), megabytes);
+    }
+    {
+        Clock::time_point start = Clock::now();
+        GDataset data(inputs, outputs);
+        if (!GDataLoader::LoadCsv(csvFile, data)) return;
+        report("LoadCsv", data.size(), secondsSince(start), megabytes);
+        if (data.size() != rows) std::cout << "row count mismatch: " << data.size() << " vs " << rows << std::endl;
+        GDataLoader::SaveCache(cacheFile, data);
+    }
+    {
+        Clock::time_point start = Clock::now();
+        GDataset data;
+        if (!GDataLoader::LoadCache(cacheFile, data)) return;
+        report("cache", data.size(), secondsSince(start), megabytes);
+    }
+    std::filesystem::remove(csvFile);
+    std::filesystem::remove(cacheFile);
+}
+
+/**
+ * @brief One epoch of batch-64 training of an 8-16-3 net over a generated dataset file of
+ * g_dataMegabytes: LoadCache into memory, then train; training straight from a GMappedDataset
+ * in order (sequential hint); and shuffled from the mapping (random hint, rows gathered by the
+ * GBatchLoader thread). Setup time, epoch time and samples/sec. The file was just written, so
+ * it is served from the page cache; on a cold cache the mapping pages it in during the epoch.
+ */
+static void benchMapped() {
+    std::cout << "\n--- Dataset file, " << g_dataMegabytes << " MB, 8-16-3 batch 64: load + train | mapped | mapped shuffled ---" << std::endl;
+    const std::string dataFile = "GNeuralBench_dataset.gdc";
+    const size_t inputs = 8, outputs = 3;
+    const size_t samples = (g_dataMegabytes << 20) / ((inputs + outputs) * sizeof(double));
+    {
+        GDatasetFileWriter writer;
+        if (!writer.open(dataFile, inputs, outputs)) return;
+        std::mt19937 gen(9);
+        std::uniform_real_distribution<double> dis(0.0, 1.0);
+        double row[inputs + outputs];
+        for (size_t s = 0; s < samples; ++s) {
+            for (double& v : row) v = dis(gen);
+            writer.addSample(GSpan<const double>(row, inputs), GSpan<const double>(row + inputs, outputs));
+        }
+        if (!writer.close()) return;
+    }
+    const Topology topology{ inputs, 16, outputs };
+    GTrainOptions options;
+    options.batchSize = 64;
+    options.maxPasses = 1;
+    options.requiredSuccesses = 2;
+    auto report = [&](const char* name, double setup, double epoch) {
+        std::cout << std::setw(16) << name << std::fixed << std::setprecision(3)
+            << "  setup " << std::setw(7) << setup << " s  epoch " << std::setw(7) << epoch << " s  "
+            << std::setprecision(0) << std::setw(10) << samples / epoch << " samples/s" << std::defaultfloat << std::endl;
+    };
+    auto train = [&](const GDatasetView& view, bool shuffle) {
+        GNeuralNetMatrix net(topology);
+        options.shuffle = shuffle;
+        Clock::time_point start = Clock::now();
+        GTrainer::Run(net, view, options);
+        return secondsSince(start);
+    };
+    {
+        Clock::time_point start = Clock::now();
+        GDataset data;
+        if (!GDataLoader::LoadCache(dataFile, data)) return;
+        const double setup = secondsSince(start);
+        report("load + train", setup, train(data.view(), false));
+    }
+    for (bool shuffle : { false, true }) {
+        Clock::time_point start = Clock::now();
+        GMappedDataset mapped;
+        if (!mapped.open(dataFile, shuffle)) return;
+        const double setup = secondsSince(start);
+        report(shuffle ? "mapped shuffled" : "mapped", setup, train(mapped.view(), shuffle));
+    }
+    std::filesystem::remove(dataFile);
+}
+
+/**
+ * @brief Process-start model loading: 200 models saved as .nnw version 1 (saveNetwork, one
+ * row of doubles per neuron) and as version 2 (freeze().save(), aligned weight sections),
+ * then all loaded as frozen networks the way NetworkFactory::LoadFrozenNetwork does: version 1
+ * parsed into a GNeuralNetMatrix and frozen, version 2 memory-mapped by GFrozenNet::load. Total and per-model load time, then the first inference over
+ * every model (where the mapped pages are touched). The files are deleted afterwards.
+ */
+static void benchModelFiles() {
+    std::cout << "\n--- Loading 200 frozen models: .nnw v1 (parse + copy) | v2 (mapped in place) ---" << std::endl;
+    const std::vector<std::pair<std::string, Topology>> topologies = {
+        { "8-100x10-3", makeTopology(8, 100, 10, 3) },
+        { "64-256-256-10", { 64, 256, 256, 10 } },
+    };
+    const size_t models = 200;
+    for (const auto& entry : topologies) {
+        const Topology& topology = entry.second;
+        GNeuralNetMatrix net(topology);
+        for (size_t m = 0; m < models; ++m) {
+            net.saveNetwork("GNeuralBench_model" + std::to_string(m) + ".v1.nnw");
+            net.freeze().save("GNeuralBench_model" + std::to_string(m) + ".v2.nnw");
+        }
+        VectorDouble input(topology.front(), 0.5), output(topology.back());
+        double loadSeconds[2], inferSeconds[2], difference = 0.0;
+        VectorDouble first[2];
+        for (int version = 0; version < 2; ++version) {
+            const std::string suffix = version == 0 ? ".v1.nnw" : ".v2.nnw";
+            std::vector<std::shared_ptr<const GFrozenNet>> loaded;
+            Clock::time_point start = Clock::now();
+            for (size_t m = 0; m < models; ++m) {
+                const std::string file = "GNeuralBench_model" + std::to_string(m) + suffix;
+                if (version == 0) {
+                    GNeuralNetMatrix source;
+                    source.loadNetwork(file);
+                    loaded.push_back(std::make_shared<const GFrozenNet>(source.freeze()));
+                }
+                else {
+                    auto frozen = std::make_shared<GFrozenNet>();
+                    frozen->load(file);
+                    loaded.push_back(frozen);
+                }
+            }
+            loadSeconds[version] = secondsSince(start);
+            start = Clock::now();
+            for (const auto& model : loaded) model->infer(input, output);
+            inferSeconds[version] = secondsSince(start);
+            first[version] = output;
+        }
+        for (size_t n = 0; n < output.size(); ++n) difference = std::max(difference, std::fabs(first[0][n] - first[1][n]));
+        for (size_t m = 0; m < models; ++m) {
+            std::filesystem::remove("GNeuralBench_model" + std::to_string(m) + ".v1.nnw");
+            std::filesystem::remove("GNeuralBench_model" + std::to_string(m) + ".v2.nnw");
+        }
+        std::cout << std::setw(14) << entry.first << std::fixed << std::setprecision(2)
+            << "  v1 load " << std::setw(8) << loadSeconds[0] * 1000.0 << " ms (" << std::setprecision(3) << loadSeconds[0] * 1000.0 / models << " ms/model)"
+            << "  v2 load " << std::setprecision(2) << std::setw(8) << loadSeconds[1] * 1000.0 << " ms (" << std::setprecision(3) << loadSeconds[1] * 1000.0 / models << " ms/model)"
+            << "  x" << std::setprecision(1) << loadSeconds[0] / loadSeconds[1]
+            << "  | first infer v1 " << std::setprecision(2) << inferSeconds[0] * 1000.0 << " ms, v2 " << inferSeconds[1] * 1000.0 << " ms"
+            << "  max diff " << std::scientific << std::setprecision(1) << difference << std::defaultfloat << std::endl;
+    }
+}
+
+/**
+ * @brief Heap allocations per call of fn after a warm-up. Several warm-up calls, so every
+ * pool thread has had a chunk and allocated its thread_local GEMM buffers.
+ */
+template<typename F>
+static double allocationsPerCall(F&& fn) {
+    const size_t warmup = 10, calls = 100;
+    for (size_t c = 0; c < warmup; ++c) fn();
+    const size_t before = g_allocations.load();
+    for (size_t c = 0; c < calls; ++c) fn();
+    return double(g_allocations.load() - before) / calls;
+}
+
+/**
+ * @brief Heap allocations per training step and per inference call once warmed up, for the
+ * span overloads, the GNetSpan adapters and the VectorDouble API of the matrix network (double, float, bf16 weights,
+ * intra-layer threads, batch 64, infer(ctx)), GStaticNet, GQuantizedNet and GFrozenNet. Every row but
+ * VectorDouble must show 0; one that does not is marked and fails the run.
+ */
+static void benchAllocations() {
+    std::cout << "\n--- Heap allocations per call after warm-up (8-64-64-3) ---" << std::endl;
+    const Topology topology = makeTopology(8, 64, 2, 3);
+    std::vector<VectorDouble> x, y;
+    makeDataset(64, 8, 3, x, y);
+    VectorDouble flatX, flatY, results(3), batchResults;
+    for (size_t s = 0; s < x.size(); ++s) {
+        flatX.insert(flatX.end(), x[s].begin(), x[s].end());
+        flatY.insert(flatY.end(), y[s].begin(), y[s].end());
+    }
+    auto report = [](const std::string& name, double train, double infer, bool zeroAllocation = true) {
+        const bool failed = zeroAllocation && (train > 0.0 || infer > 0.0);
+        g_benchFailed = g_benchFailed || failed;
+        std::cout << std::setw(32) << name << std::fixed << std::setprecision(2)
+            << "  train step " << std::setw(6) << train << "  inference " << std::setw(6) << infer << std::defaultfloat
+            << (failed ? "  FAIL: allocates after warm-up" : "") << std::endl;
+    };
+    auto matrixRow = [&](const std::string& name, auto& net) {
+        report(name + " span",
+            allocationsPerCall([&] { net.feedForward(GSpan<const double>(x[0])); net.backPropagate(GSpan<const double>(y[0])); net.getResults(GSpan<double>(results)); }),
+            allocationsPerCall([&] { net.feedForward(GSpan<const double>(x[1])); net.getResults(GSpan<double>(results)); }));
+        InterfaceGNeuralNet& base = net;
+        VectorDouble scratch;
+        report(name + " GNetSpan",
+            allocationsPerCall([&] {
+                GNetSpan::FeedForward(base, GSpan<const double>(x[0]), scratch);
+                GNetSpan::BackPropagate(base, GSpan<const double>(y[0]), scratch);
+                GNetSpan::GetResults(base, GSpan<double>(results), scratch);
+            }),
+            allocationsPerCall([&] { GNetSpan::FeedForward(base, GSpan<const double>(x[1]), scratch); GNetSpan::GetResults(base, GSpan<double>(results), scratch); }));
+        VectorDouble vectorResults;
+        report(name + " VectorDouble",
+            allocationsPerCall([&] { net.feedForward(x[0]); net.backPropagate(y[0]); net.getResults(vectorResults); }),
+            allocationsPerCall([&] { VectorDouble fresh; net.feedForward(x[1]); net.getResults(fresh); }), false);
+        report(name + " batch 64",
+            allocationsPerCall([&] { net.feedForwardBatch(flatX.data(), 64); net.backPropagateBatch(flatY.data(), 64); }),
+            allocationsPerCall([&] { net.feedForwardBatch(flatX.data(), 64); net.getBatchResults(batchResults); }));
+    };
+    {
+        GNeuralNetMatrix net(topology);
+        matrixRow("double", net);
+    }
+    {
+        GNeuralNetMatrixF net(topology);
+        matrixRow("float", net);
+    }
+    {
+        GNeuralNetMatrixF net(topology);
+        net.SetWeightStorage(STORAGE_BF16);
+        matrixRow("float bf16", net);
+    }
+    {
+        GNeuralNetMatrix net(topology);
+        net.SetThreadCount(2);
+        net.SetParallelThreshold(0);
+        matrixRow("double 2 threads", net);
+    }
+    {
+        GStaticNet<8, 64, 64, 3> net;
+        report("GStaticNet",
+            allocationsPerCall([&] { net.feedForward(x[0].data()); net.backPropagate(y[0].data()); net.getResults(results.data()); }),
+            allocationsPerCall([&] { net.feedForward(x[1].data()); net.getResults(results.data()); }));
+    }
+    {
+        GNeuralNetMatrix net(topology);
+        GQuantizedNet quantized;
+        quantized.quantize(net, flatX.data(), x.size());
+        report("GQuantizedNet", 0.0,
+            allocationsPerCall([&] { quantized.feedForward(x[1]); quantized.getResults(results); }));
+    }
+    {
+        GNeuralNetMatrix net(topology);
+        const GFrozenNet frozen = net.freeze();
+        GInferenceContext ctx = net.createContext();
+        report("GNeuralNetMatrix infer(ctx)", 0.0, allocationsPerCall([&] { net.infer(ctx, x[1], results); }));
+        report("GFrozenNet", 0.0, allocationsPerCall([&] { frozen.infer(x[1], results); }));
+    }
+}
+
+int main(int argc, char** argv) {
+    std::map<std::string, std::function<void()>> benchmarks;
+    benchmarks["simd"] = benchSimdLevels;
+    benchmarks["gemm"] = benchGemm;
+    benchmarks["threads"] = benchThreads;
+    benchmarks["dataparallel"] = benchDataParallel;
+    benchmarks["hogwild"] = benchHogwild;
+    benchmarks["activation"] = benchActivation;
+    benchmarks["dispatch"] = benchDispatch;
+    benchmarks["float"] = benchFloat;
+    benchmarks["half"] = benchHalf;
+    benchmarks["int8"] = benchInt8;
+    benchmarks["static"] = benchStatic;
+    benchmarks["frozen"] = benchFrozen;
+    benchmarks["shared"] = benchShared;
+    benchmarks["softmax"] = benchSoftmax;
+    benchmarks["train"] = benchTrain;
+    benchmarks["dataset"] = benchDataset;
+    benchmarks["csv"] = benchCsv;
+    benchmarks["mapped"] = benchMapped;
+    benchmarks["nnw"] = benchModelFiles;
+    benchmarks["allocations"] = benchAllocations;
+
+    if (argc > 2) g_dataMegabytes = std::strtoul(argv[2], nullptr, 10);
+    if (argc > 1) {
+        auto it = benchmarks.find(argv[1]);
+        if (it == benchmarks.end()) {
+            std::cerr << "Unknown benchmark '" << argv[1] << "'. Available:";
+            for (const auto& b : benchmarks) std::cerr << " " << b.first;
+            std::cerr << std::endl;
+            return 1;
+        }
+        it->second();
+        return g_benchFailed ? 1 : 0;
+    }
+    for (const auto& b : benchmarks) b.second();
+    return g_benchFailed ? 1 : 0;
+}
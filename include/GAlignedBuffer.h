@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+
+// Cache-line alignment used for every dense buffer of the CPU backend.
+constexpr size_t G_CACHE_LINE = 64;
+
+/// <summary>
+/// Rounds a number of elements up so that a row of T fills whole cache lines.
+/// </summary>
+template<typename T>
+constexpr size_t GPaddedCount(size_t count)
+{
+	const size_t perLine = G_CACHE_LINE / sizeof(T);
+	return (count + perLine - 1) / perLine * perLine;
+}
+
+/// <summary>
+/// Owning, zero-initialized, 64-byte aligned array of trivially copyable values.
+/// This is the storage primitive behind the contiguous layer matrices.
+/// </summary>
+template<typename T>
+class GAlignedBuffer
+{
+public:
+					GAlignedBuffer() : m_data(nullptr), m_size(0) {}
+	explicit		GAlignedBuffer(size_t count) : m_data(nullptr), m_size(0) { resize(count); }
+					GAlignedBuffer(const GAlignedBuffer& other) : m_data(nullptr), m_size(0) { *this = other; }
+					GAlignedBuffer(GAlignedBuffer&& other) noexcept : m_data(other.m_data), m_size(other.m_size) { other.m_data = nullptr; other.m_size = 0; }
+					~GAlignedBuffer() { release(); }
+
+	GAlignedBuffer& operator=(const GAlignedBuffer& other)
+	{
+		if (this != &other) {
+			resize(other.m_size);
+			if (m_size)
+				std::memcpy(m_data, other.m_data, m_size * sizeof(T));
+		}
+		return *this;
+	}
+	GAlignedBuffer& operator=(GAlignedBuffer&& other) noexcept
+	{
+		if (this != &other) {
+			release();
+			std::swap(m_data, other.m_data);
+			std::swap(m_size, other.m_size);
+		}
+		return *this;
+	}
+
+	// Reallocates to exactly 'count' elements; the contents are reset to zero.
+	void			resize(size_t count)
+	{
+		if (count != m_size) {
+			release();
+			if (count) {
+				m_data = static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(G_CACHE_LINE)));
+				m_size = count;
+			}
+		}
+		fill(T());
+	}
+	// Frees the storage and returns the buffer to the empty state.
+	void			release()
+	{
+		if (m_data)
+			::operator delete(m_data, std::align_val_t(G_CACHE_LINE));
+		m_data = nullptr;
+		m_size = 0;
+	}
+	void			fill(const T& value) { for (size_t i = 0; i < m_size; ++i) m_data[i] = value; }
+
+	T*				data() { return m_data; }
+	const T*		data() const { return m_data; }
+	size_t			size() const { return m_size; }
+	bool			empty() const { return m_size == 0; }
+	size_t			bytes() const { return m_size * sizeof(T); }
+	T&				operator[](size_t i) { return m_data[i]; }
+	const T&		operator[](size_t i) const { return m_data[i]; }
+
+private:
+	T*				m_data;
+	size_t			m_size;
+};
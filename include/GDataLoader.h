@@ -0,0 +1,431 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "GDataset.h"
+#include "GMappedDataset.h"
+#include "GFileIO.h"
+#include "constants.h"
+
+/// <summary>
+/// Number parsing for the CSV loader. ParseDouble is a fast path for the decimal numbers
+/// of market data ("1.1205", "-115.3", "2.5e-3"): the digits are accumulated eight at a time
+/// with SWAR arithmetic (eight ASCII digits in one 64-bit register), and the value is scaled
+/// by one exact power of ten when both the mantissa and the power are exactly representable,
+/// which makes it correctly rounded. Longer or extreme numbers fall back to strtod.
+/// </summary>
+namespace GCsv
+{
+	namespace detail
+	{
+		inline uint64_t	load8(const char* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+
+		// True if the eight bytes of v are all ASCII digits.
+		inline bool		isEightDigits(uint64_t v)
+		{
+			return ((v & 0xF0F0F0F0F0F0F0F0ull) | (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+		}
+
+		// Value of eight ASCII digits, first digit in the lowest byte (little-endian load).
+		inline uint32_t	parseEightDigits(uint64_t v)
+		{
+			const uint64_t mask = 0x000000FF000000FFull;
+			const uint64_t mul1 = 0x000F424000000064ull;	// 100 + (1000000 << 32)
+			const uint64_t mul2 = 0x0000271000000001ull;	// 1 + (10000 << 32)
+			v -= 0x3030303030303030ull;
+			v = v * 10 + (v >> 8);
+			v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+			return uint32_t(v);
+		}
+
+		// Appends the digits at p to mantissa; returns the number of digits read.
+		inline int		parseDigits(const char*& p, const char* end, uint64_t& mantissa)
+		{
+			const char* start = p;
+			while (end - p >= 8 && isEightDigits(load8(p))) {
+				mantissa = mantissa * 100000000ull + parseEightDigits(load8(p));
+				p += 8;
+			}
+			while (p < end && unsigned(*p - '0') < 10) {
+				mantissa = mantissa * 10 + unsigned(*p - '0');
+				++p;
+			}
+			return int(p - start);
+		}
+
+		inline bool		parseSlow(const char* start, const char* end, double& value)
+		{
+			char buffer[128];
+			const size_t length = size_t(end - start);
+			if (length >= sizeof(buffer))
+				return false;
+			std::memcpy(buffer, start, length);
+			buffer[length] = '\0';
+			char* last = nullptr;
+			value = std::strtod(buffer, &last);
+			return last == buffer + length;
+		}
+	}
+
+	/// <summary>
+	/// Parses one decimal number at p (sign, digits, fraction, exponent; no leading spaces).
+	/// On success p is left after the number.
+	/// </summary>
+	inline bool ParseDouble(const char*& p, const char* end, double& value)
+	{
+		static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+		const char* start = p;
+		const char* q = p;
+		const bool negative = q < end && *q == '-';
+		if (q < end && (*q == '-' || *q == '+'))
+			++q;
+		uint64_t mantissa = 0;
+		int digits = detail::parseDigits(q, end, mantissa);
+		int exponent = 0;
+		if (q < end && *q == '.') {
+			++q;
+			const int fraction = detail::parseDigits(q, end, mantissa);
+			digits += fraction;
+			exponent = -fraction;
+		}
+		if (digits == 0)
+			return false;
+		if (q < end && (*q == 'e' || *q == 'E')) {
+			const char* e = q + 1;
+			const bool negativeExponent = e < end && *e == '-';
+			if (e < end && (*e == '-' || *e == '+'))
+				++e;
+			uint64_t power = 0;
+			if (detail::parseDigits(e, end, power) == 0)
+				return false;
+			exponent += negativeExponent ? -int(std::min<uint64_t>(power, 100000)) : int(std::min<uint64_t>(power, 100000));
+			q = e;
+		}
+		// Exact when the mantissa fits 53 bits and the power of ten is exact (10^22 at most)
+		if (digits <= 19 && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22) {
+			double v = double(mantissa);
+			v = exponent < 0 ? v / powers[-exponent] : v * powers[exponent];
+			value = negative ? -v : v;
+			p = q;
+			return true;
+		}
+		if (!detail::parseSlow(start, q, value))
+			return false;
+		p = q;
+		return true;
+	}
+}
+
+/// <summary>
+/// Options of GDataLoader::LoadCsv.
+/// </summary>
+struct GCsvOptions
+{
+	char			delimiter = ',';
+	// Bytes read from disk per chunk; the background reader keeps one chunk ahead of the parser.
+	size_t			chunkBytes = size_t(4) << 20;
+};
+
+/// <summary>
+/// Reads a file in chunks of whole lines on a background thread, one chunk ahead of the
+/// caller, so the disk reads overlap the parsing. A line cut by the end of a chunk is carried
+/// over to the next one.
+/// </summary>
+class GChunkReader
+{
+public:
+					GChunkReader(const std::string& file_name, size_t chunkBytes)
+						: m_file(file_name, std::ios::binary), m_chunkBytes(std::max<size_t>(chunkBytes, 4096))
+	{
+		if (m_file.is_open())
+			m_thread = std::thread([this] { read(); });
+	}
+					~GChunkReader()
+	{
+		if (!m_thread.joinable())
+			return;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_cv.notify_all();
+		m_thread.join();
+	}
+					GChunkReader(const GChunkReader&) = delete;
+	GChunkReader&	operator=(const GChunkReader&) = delete;
+
+	bool			is_open() const { return m_thread.joinable(); }
+	// Next chunk of whole lines, or false at the end of the file (or on a read error).
+	// The chunk is valid until the next call.
+	bool			next(const char*& data, size_t& size);
+	bool			failed() const { return m_failed; }
+
+private:
+	struct Slot
+	{
+		std::vector<char>	bytes;
+		size_t				size = 0;
+		bool				ready = false;
+		bool				last = false;		// no chunk follows this one
+	};
+
+	void			read();
+
+	std::ifstream			m_file;
+	size_t					m_chunkBytes;
+	Slot					m_slots[2];			// chunk c is read into slot c % 2
+	size_t					m_next = 0;			// chunk returned by the next next()
+	bool					m_done = false;
+	bool					m_failed = false;
+	bool					m_stop = false;
+	std::mutex				m_mutex;
+	std::condition_variable	m_cv;
+	std::thread				m_thread;
+};
+
+inline bool GChunkReader::next(const char*& data, size_t& size)
+{
+	if (m_done || !is_open())
+		return false;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	// The caller is done with the previous chunk: the reader can refill its slot
+	if (m_next > 0) {
+		m_slots[(m_next - 1) % 2].ready = false;
+		m_cv.notify_all();
+	}
+	Slot& slot = m_slots[m_next % 2];
+	m_cv.wait(lock, [&] { return slot.ready; });
+	++m_next;
+	m_done = slot.last;
+	data = slot.bytes.data();
+	size = slot.size;
+	return size > 0 || !m_done;
+}
+
+inline void GChunkReader::read()
+{
+	std::vector<char> carry;		// start of a line cut by the end of the previous chunk
+	for (size_t c = 0;; ++c) {
+		Slot& slot = m_slots[c % 2];
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.wait(lock, [&] { return m_stop || !slot.ready; });
+			if (m_stop)
+				return;
+		}
+		size_t total = carry.size();
+		slot.bytes.resize(std::max(slot.bytes.size(), total + m_chunkBytes));
+		std::copy(carry.begin(), carry.end(), slot.bytes.begin());
+		bool eof = false, failed = false;
+		size_t cut = 0;
+		for (;;) {
+			if (slot.bytes.size() < total + m_chunkBytes)
+				slot.bytes.resize(total + m_chunkBytes);
+			m_file.read(slot.bytes.data() + total, std::streamsize(m_chunkBytes));
+			const size_t count = size_t(m_file.gcount());
+			failed = m_file.bad();
+			eof = count < m_chunkBytes;
+			const size_t from = total;
+			total += count;
+			if (eof || failed) {
+				cut = total;
+				break;
+			}
+			// Cut after the last newline; a line longer than a chunk needs another read
+			const char* bytes = slot.bytes.data();
+			size_t n = total;
+			while (n > from && bytes[n - 1] != '\n')
+				--n;
+			if (n > from) {
+				cut = n;
+				break;
+			}
+		}
+		carry.assign(slot.bytes.begin() + cut, slot.bytes.begin() + total);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		slot.size = cut;
+		slot.last = eof || failed;
+		slot.ready = true;
+		m_failed = failed;
+		m_cv.notify_all();
+		if (slot.last)
+			return;
+	}
+}
+
+/// <summary>
+/// Loading of training sets from disk. A CSV file holds one sample per line: inputCount
+/// input columns followed by outputCount target columns. A first line that is not numeric is
+/// taken as a header. Load() converts a CSV once into a binary cache next to it
+/// ("file.csv.gdc", a GMappedDataset file) and reads the cache on later runs, skipping the
+/// parsing entirely, as long as the cache is newer than the CSV. ConvertCsv() streams a CSV
+/// that does not fit in memory into a dataset file to map with GMappedDataset.
+/// </summary>
+namespace GDataLoader
+{
+	// Parses a CSV file with numInputs + numOutputs columns and passes every sample to
+	// addSample(inputs, targets); sizeHint(samples) is called once with an estimate of the rows.
+	template<typename AddSample, typename SizeHint>
+	inline bool ParseCsv(const std::string& file_name, size_t numInputs, size_t numOutputs, const GCsvOptions& options,
+		AddSample&& addSample, SizeHint&& sizeHint)
+	{
+		GChunkReader reader(file_name, options.chunkBytes);
+		if (!reader.is_open()) {
+			std::cerr << "Error: Could not open file " << file_name << " for reading." << std::endl;
+			return false;
+		}
+		const size_t columns = numInputs + numOutputs;
+		std::error_code error;
+		const uintmax_t fileBytes = std::filesystem::file_size(file_name, error);
+		VectorDouble row(columns);
+		size_t line = 0;
+		bool reserved = false;
+		const char* chunk = nullptr;
+		size_t chunkSize = 0;
+		while (reader.next(chunk, chunkSize)) {
+			const char* p = chunk;
+			const char* end = chunk + chunkSize;
+			size_t chunkSamples = 0;
+			while (p < end) {
+				const char* eol = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+				if (!eol)
+					eol = end;
+				++line;
+				const char* lineEnd = eol > p && eol[-1] == '\r' ? eol - 1 : eol;
+				const char* q = p;
+				p = eol + 1;
+				if (q == lineEnd)
+					continue;		// blank line
+				size_t column = 0;
+				for (; column < columns; ++column) {
+					while (q < lineEnd && (*q == ' ' || *q == '\t'))
+						++q;
+					if (!GCsv::ParseDouble(q, lineEnd, row[column]))
+						break;
+					while (q < lineEnd && (*q == ' ' || *q == '\t'))
+						++q;
+					if (column + 1 < columns) {
+						if (q == lineEnd || *q != options.delimiter)
+							break;
+						++q;
+					}
+				}
+				if (column < columns || q != lineEnd) {
+					if (line == 1)
+						continue;		// header
+					std::cerr << "Error: " << file_name << " line " << line << ": expected " << numInputs << " inputs and "
+						<< numOutputs << " targets separated by '" << options.delimiter << "'." << std::endl;
+					return false;
+				}
+				addSample(GSpan<const double>(row.data(), numInputs), GSpan<const double>(row.data() + numInputs, numOutputs));
+				++chunkSamples;
+			}
+			// Estimate the rows of the whole file from the bytes per row of the first chunk
+			if (!reserved && !error && chunkSamples > 0) {
+				reserved = true;
+				const double bytesPerRow = double(chunkSize) / double(chunkSamples);
+				sizeHint(size_t(double(fileBytes) / bytesPerRow * 1.02) + 1);
+			}
+		}
+		if (reader.failed()) {
+			std::cerr << "Error: Failed to read " << file_name << "." << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// Appends the samples of a CSV file to data (which sets the column counts).
+	inline bool LoadCsv(const std::string& file_name, GDataset& data, const GCsvOptions& options = GCsvOptions())
+	{
+		const size_t samplesBefore = data.size();
+		return ParseCsv(file_name, data.getInputCount(), data.getOutputCount(), options,
+			[&](GSpan<const double> inputs, GSpan<const double> targets) { data.addSample(inputs, targets); },
+			[&](size_t samples) { data.reserve(samplesBefore + samples); });
+	}
+
+	/// <summary>
+	/// Converts a CSV file into a dataset file for GMappedDataset without holding it in memory:
+	/// the samples stream from the CSV parser into a GDatasetFileWriter.
+	/// </summary>
+	inline bool ConvertCsv(const std::string& csvFile, size_t inputCount, size_t outputCount, const std::string& datasetFile,
+		const GCsvOptions& options = GCsvOptions())
+	{
+		GDatasetFileWriter writer;
+		if (!writer.open(datasetFile, inputCount, outputCount))
+			return false;
+		const bool parsed = ParseCsv(csvFile, inputCount, outputCount, options,
+			[&](GSpan<const double> inputs, GSpan<const double> targets) { writer.addSample(inputs, targets); },
+			[](size_t) {});
+		const bool written = writer.close();
+		if (!parsed)
+			std::remove(datasetFile.c_str());
+		return parsed && written;
+	}
+
+	// Writes the dataset to a binary cache file (the GMappedDataset file format).
+	inline bool SaveCache(const std::string& file_name, const GDataset& data)
+	{
+		return GMappedDataset::Write(file_name, data.view());
+	}
+
+	// Reads a dataset file written by SaveCache or ConvertCsv into memory.
+	inline bool LoadCache(const std::string& file_name, GDataset& data)
+	{
+		GFile inFile;
+		if (!inFile.open(file_name))
+			return false;
+		const uint64_t fileSize = inFile.size();
+		GDatasetFileHeader header = {};
+		if (!ReadBytesAt(inFile.handle(), &header, sizeof(header), 0) || !header.valid(fileSize)) {
+			std::cerr << "Error: " << file_name << " is not a dataset file." << std::endl;
+			return false;
+		}
+		data = GDataset(size_t(header.inputCount), size_t(header.outputCount));
+		data.resize(size_t(header.rows));
+		// One positioned read per section
+		if (!ReadDoublesAt(inFile.handle(), GSpan<double>(data.inputData(), size_t(header.rows * header.inputCount)), header.inputOffset)
+			|| !ReadDoublesAt(inFile.handle(), GSpan<double>(data.targetData(), size_t(header.rows * header.outputCount)), header.targetOffset)) {
+			std::cerr << "Error: " << file_name << " is truncated." << std::endl;
+			data.clear();
+			return false;
+		}
+		return true;
+	}
+
+	inline std::string CachePath(const std::string& csvFile) { return csvFile + ".gdc"; }
+
+	/// <summary>
+	/// Loads a CSV training set with inputCount inputs and outputCount targets per line through
+	/// its binary cache: the cache when it is newer than the CSV and has the same columns,
+	/// otherwise the CSV, which is then cached for the next run.
+	/// </summary>
+	inline bool Load(const std::string& csvFile, size_t inputCount, size_t outputCount, GDataset& data,
+		const GCsvOptions& options = GCsvOptions())
+	{
+		namespace fs = std::filesystem;
+		const std::string cacheFile = CachePath(csvFile);
+		std::error_code error;
+		const bool cacheCurrent = fs::exists(cacheFile, error) && fs::exists(csvFile, error)
+			&& fs::last_write_time(cacheFile, error) >= fs::last_write_time(csvFile, error) && !error;
+		if (cacheCurrent && LoadCache(cacheFile, data)
+			&& data.getInputCount() == inputCount && data.getOutputCount() == outputCount)
+			return true;
+
+		data = GDataset(inputCount, outputCount);
+		if (!LoadCsv(csvFile, data, options))
+			return false;
+		if (!SaveCache(cacheFile, data))
+			std::cerr << "Warning: " << csvFile << " loaded, but its cache could not be written." << std::endl;
+		return true;
+	}
+}
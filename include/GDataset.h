@@ -0,0 +1,261 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <initializer_list>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cassert>
+#include "GTypes.h"
+#include "GSpan.h"
+#include "GAlignedBuffer.h"
+
+/// <summary>
+/// Non-owning view of a training set: row-major [samples x inputCount] inputs and
+/// [samples x outputCount] targets. The caller keeps the storage alive while training.
+/// </summary>
+struct GDatasetView
+{
+	const double*	inputs = nullptr;
+	const double*	targets = nullptr;
+	size_t			samples = 0;
+	size_t			inputCount = 0;
+	size_t			outputCount = 0;
+
+	const double*	input(size_t sample) const { return inputs + sample * inputCount; }
+	const double*	target(size_t sample) const { return targets + sample * outputCount; }
+};
+
+/// <summary>
+/// Training set stored as one contiguous input matrix and one contiguous target matrix
+/// (row-major, one row per sample), instead of two heap vectors per sample. view() hands
+/// both matrices to GTrainer::Run or to a GBatchLoader.
+/// </summary>
+class GDataset
+{
+public:
+					GDataset() : m_inputCount(0), m_outputCount(0) {}
+					GDataset(size_t inputCount, size_t outputCount) : m_inputCount(inputCount), m_outputCount(outputCount) {}
+	// { { inputs }, { targets } } per sample; the first sample sets the row widths.
+					GDataset(std::initializer_list<std::pair<VectorDouble, VectorDouble>> samples) : GDataset()
+	{
+		if (samples.size() == 0)
+			return;
+		m_inputCount = samples.begin()->first.size();
+		m_outputCount = samples.begin()->second.size();
+		reserve(samples.size());
+		for (const std::pair<VectorDouble, VectorDouble>& sample : samples)
+			addSample(sample.first, sample.second);
+	}
+
+	void			reserve(size_t samples)
+	{
+		m_inputs.reserve(samples * m_inputCount);
+		m_targets.reserve(samples * m_outputCount);
+	}
+	// Appends one sample; the rows must have the dataset's widths.
+	void			addSample(GSpan<const double> inputs, GSpan<const double> targets)
+	{
+		assert(inputs.size() == m_inputCount && targets.size() == m_outputCount);
+		m_inputs.insert(m_inputs.end(), inputs.begin(), inputs.end());
+		m_targets.insert(m_targets.end(), targets.begin(), targets.end());
+	}
+	void			clear() { m_inputs.clear(); m_targets.clear(); }
+	// Sets the number of samples; new rows are zero. For loaders that fill the matrices in bulk.
+	void			resize(size_t samples)
+	{
+		m_inputs.resize(samples * m_inputCount);
+		m_targets.resize(samples * m_outputCount);
+	}
+
+	size_t			size() const { return m_inputCount ? m_inputs.size() / m_inputCount : 0; }
+	bool			empty() const { return m_inputs.empty(); }
+	size_t			getInputCount() const { return m_inputCount; }
+	size_t			getOutputCount() const { return m_outputCount; }
+	GSpan<const double> inputRow(size_t sample) const { return GSpan<const double>(m_inputs.data() + sample * m_inputCount, m_inputCount); }
+	GSpan<const double> targetRow(size_t sample) const { return GSpan<const double>(m_targets.data() + sample * m_outputCount, m_outputCount); }
+	// Whole [samples x inputCount] and [samples x outputCount] matrices.
+	double*			inputData() { return m_inputs.data(); }
+	const double*	inputData() const { return m_inputs.data(); }
+	double*			targetData() { return m_targets.data(); }
+	const double*	targetData() const { return m_targets.data(); }
+
+	GDatasetView	view() const
+	{
+		GDatasetView v;
+		v.inputs = m_inputs.data();
+		v.targets = m_targets.data();
+		v.samples = size();
+		v.inputCount = m_inputCount;
+		v.outputCount = m_outputCount;
+		return v;
+	}
+
+private:
+	size_t			m_inputCount;
+	size_t			m_outputCount;
+	VectorDouble	m_inputs;		// [samples x inputCount]
+	VectorDouble	m_targets;		// [samples x outputCount]
+};
+
+/// <summary>
+/// Rows [0, rows) of one mini-batch, row-major, ready for feedForwardBatch / backPropagateBatch.
+/// </summary>
+struct GBatchView
+{
+	const double*	inputs = nullptr;
+	const double*	targets = nullptr;
+	size_t			rows = 0;
+};
+
+/// <summary>
+/// Walks a dataset one mini-batch at a time, epoch after epoch.
+/// </summary>
+/// <remarks>
+/// Without shuffling the batches are views straight into the dataset. With shuffling every
+/// epoch draws a new index permutation. A background thread then gathers the permuted rows
+/// into two aligned staging slots, filling batch b + 1 while the caller trains on batch b.
+/// The caller therefore only waits when the gather is slower than a training step.
+/// </remarks>
+class GBatchLoader
+{
+public:
+					GBatchLoader(const GDatasetView& data, size_t batchSize, bool shuffle, unsigned seed = 0)
+						: m_data(data), m_batchSize(std::max<size_t>(batchSize, 1)), m_shuffle(shuffle), m_rng(seed)
+	{
+		m_batchCount = (m_data.samples + m_batchSize - 1) / m_batchSize;
+		if (!m_shuffle)
+			return;
+		m_order.resize(m_data.samples);
+		for (Slot& slot : m_slots) {
+			slot.inputs.resize(m_batchSize * m_data.inputCount);
+			slot.targets.resize(m_batchSize * m_data.outputCount);
+		}
+		m_requested = m_batchCount;		// idle until startEpoch()
+		m_thread = std::thread([this] { prefetch(); });
+	}
+					~GBatchLoader()
+	{
+		if (!m_thread.joinable())
+			return;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_cv.notify_all();
+		m_thread.join();
+	}
+					GBatchLoader(const GBatchLoader&) = delete;
+	GBatchLoader&	operator=(const GBatchLoader&) = delete;
+
+	size_t			getBatchCount() const { return m_batchCount; }
+	// Starts an epoch: a new permutation when shuffling, and the prefetch of its first batch.
+	void			startEpoch();
+	// Next batch of the epoch, or false at its end. The view is valid until the next call.
+	bool			next(GBatchView& batch);
+
+private:
+	struct Slot
+	{
+		GAlignedBuffer<double>	inputs;
+		GAlignedBuffer<double>	targets;
+		size_t					batch = 0;
+		bool					ready = false;
+	};
+
+	size_t			rowsOf(size_t batch) const { return std::min(m_batchSize, m_data.samples - batch * m_batchSize); }
+	void			prefetch();
+
+	GDatasetView			m_data;
+	size_t					m_batchSize;
+	size_t					m_batchCount = 0;
+	bool					m_shuffle;
+	std::mt19937			m_rng;
+	std::vector<size_t>		m_order;		// sample index of every position in the epoch
+	Slot					m_slots[2];		// batch b is staged in slot b % 2
+	size_t					m_next = 0;		// batch returned by the next next()
+	size_t					m_requested = 0;	// batches the prefetch thread has started this epoch
+	bool					m_filling = false;
+	bool					m_stop = false;
+	std::mutex				m_mutex;
+	std::condition_variable	m_cv;
+	std::thread				m_thread;
+};
+
+inline void GBatchLoader::startEpoch()
+{
+	if (!m_shuffle) {
+		m_next = 0;
+		return;
+	}
+	std::unique_lock<std::mutex> lock(m_mutex);
+	// The permutation and the slots belong to the prefetch thread while it gathers
+	m_cv.wait(lock, [this] { return !m_filling; });
+	for (size_t i = 0; i < m_order.size(); ++i)
+		m_order[i] = i;
+	std::shuffle(m_order.begin(), m_order.end(), m_rng);
+	for (Slot& slot : m_slots)
+		slot.ready = false;
+	m_next = 0;
+	m_requested = 0;
+	lock.unlock();
+	m_cv.notify_all();
+}
+
+inline bool GBatchLoader::next(GBatchView& batch)
+{
+	if (m_next >= m_batchCount)
+		return false;
+	if (!m_shuffle) {
+		batch.inputs = m_data.input(m_next * m_batchSize);
+		batch.targets = m_data.target(m_next * m_batchSize);
+		batch.rows = rowsOf(m_next);
+		++m_next;
+		return true;
+	}
+	std::unique_lock<std::mutex> lock(m_mutex);
+	// The caller is done with the previous batch: its slot can take batch m_next + 1
+	if (m_next > 0) {
+		m_slots[(m_next - 1) % 2].ready = false;
+		m_cv.notify_all();
+	}
+	Slot& slot = m_slots[m_next % 2];
+	m_cv.wait(lock, [&] { return slot.ready && slot.batch == m_next; });
+	batch.inputs = slot.inputs.data();
+	batch.targets = slot.targets.data();
+	batch.rows = rowsOf(m_next);
+	++m_next;
+	return true;
+}
+
+inline void GBatchLoader::prefetch()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;) {
+		m_cv.wait(lock, [this] {
+			return m_stop || (m_requested < m_batchCount && !m_slots[m_requested % 2].ready);
+		});
+		if (m_stop)
+			return;
+		const size_t b = m_requested++;
+		Slot& slot = m_slots[b % 2];
+		m_filling = true;
+		lock.unlock();
+
+		const size_t first = b * m_batchSize, rows = rowsOf(b);
+		const size_t numInputs = m_data.inputCount, numOutputs = m_data.outputCount;
+		for (size_t r = 0; r < rows; ++r) {
+			const size_t sample = m_order[first + r];
+			std::copy(m_data.input(sample), m_data.input(sample) + numInputs, slot.inputs.data() + r * numInputs);
+			std::copy(m_data.target(sample), m_data.target(sample) + numOutputs, slot.targets.data() + r * numOutputs);
+		}
+
+		lock.lock();
+		slot.batch = b;
+		slot.ready = true;
+		m_filling = false;
+		m_cv.notify_all();
+	}
+}
@@ -0,0 +1,221 @@
+#pragma once
+#include <string>
+#include <iostream>
+#include <cstddef>
+#include <cstdint>
+#include "GSpan.h"
+
+#if defined(_WIN32)
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#  include <io.h>
+#else
+#  include <cerrno>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/stat.h>
+#endif
+
+/// <summary>
+/// Bulk binary file I/O: a whole array moves in one system call (or one per GFileIO::maxTransfer
+/// bytes), where FileWriteDouble / StreamWriteDouble of Utils.h move one double per call.
+/// </summary>
+/// <remarks>
+/// The handle is a file descriptor on POSIX (write / read / pread, retried on EINTR and short
+/// transfers) and a HANDLE on Windows (WriteFile / ReadFile, with an OVERLAPPED offset for the
+/// positioned read). The stream overloads hand the array to the stream in one write / read,
+/// which std::filebuf passes straight to the file when it is larger than its buffer.
+/// </remarks>
+#if defined(_WIN32)
+typedef HANDLE GFileHandle;
+#else
+typedef int GFileHandle;
+#endif
+
+namespace GFileIO
+{
+	// Largest single transfer; Win32 takes a DWORD count and Linux stops near 2 GB anyway.
+	constexpr size_t	maxTransfer = size_t(1) << 30;
+}
+
+// Writes count bytes at the current position.
+inline bool WriteBytes(GFileHandle file, const void* bytes, size_t count)
+{
+	const char* p = static_cast<const char*>(bytes);
+	while (count > 0) {
+		const size_t chunk = count < GFileIO::maxTransfer ? count : GFileIO::maxTransfer;
+#if defined(_WIN32)
+		DWORD written = 0;
+		if (!WriteFile(file, p, DWORD(chunk), &written, nullptr) || written == 0)
+			return false;
+#else
+		const ssize_t written = ::write(file, p, chunk);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return false;
+#endif
+		p += written;
+		count -= size_t(written);
+	}
+	return true;
+}
+
+// Reads exactly count bytes from the current position; false on error or end of file.
+inline bool ReadBytes(GFileHandle file, void* bytes, size_t count)
+{
+	char* p = static_cast<char*>(bytes);
+	while (count > 0) {
+		const size_t chunk = count < GFileIO::maxTransfer ? count : GFileIO::maxTransfer;
+#if defined(_WIN32)
+		DWORD done = 0;
+		if (!ReadFile(file, p, DWORD(chunk), &done, nullptr) || done == 0)
+			return false;
+#else
+		const ssize_t done = ::read(file, p, chunk);
+		if (done < 0 && errno == EINTR)
+			continue;
+		if (done <= 0)
+			return false;
+#endif
+		p += done;
+		count -= size_t(done);
+	}
+	return true;
+}
+
+// Reads exactly count bytes at a byte offset. On POSIX the file position is left unchanged.
+inline bool ReadBytesAt(GFileHandle file, void* bytes, size_t count, uint64_t offset)
+{
+	char* p = static_cast<char*>(bytes);
+	while (count > 0) {
+		const size_t chunk = count < GFileIO::maxTransfer ? count : GFileIO::maxTransfer;
+#if defined(_WIN32)
+		OVERLAPPED position = {};
+		position.Offset = DWORD(offset);
+		position.OffsetHigh = DWORD(offset >> 32);
+		DWORD done = 0;
+		if (!ReadFile(file, p, DWORD(chunk), &done, &position) || done == 0)
+			return false;
+#else
+		const ssize_t done = ::pread(file, p, chunk, off_t(offset));
+		if (done < 0 && errno == EINTR)
+			continue;
+		if (done <= 0)
+			return false;
+#endif
+		p += done;
+		offset += uint64_t(done);
+		count -= size_t(done);
+	}
+	return true;
+}
+
+inline bool WriteDoubles(GFileHandle file, GSpan<const double> values) { return WriteBytes(file, values.data(), values.size() * sizeof(double)); }
+inline bool ReadDoubles(GFileHandle file, GSpan<double> values) { return ReadBytes(file, values.data(), values.size() * sizeof(double)); }
+inline bool ReadDoublesAt(GFileHandle file, GSpan<double> values, uint64_t offset)
+{
+	return ReadBytesAt(file, values.data(), values.size() * sizeof(double), offset);
+}
+
+#if defined(_WIN32)
+// CRT descriptors, as taken by GObject::Save / Load(const int)
+inline bool WriteDoubles(int file, GSpan<const double> values) { return WriteDoubles(reinterpret_cast<HANDLE>(_get_osfhandle(file)), values); }
+inline bool ReadDoubles(int file, GSpan<double> values) { return ReadDoubles(reinterpret_cast<HANDLE>(_get_osfhandle(file)), values); }
+#endif
+
+inline bool WriteDoubles(std::ostream& out, GSpan<const double> values)
+{
+	out.write(reinterpret_cast<const char*>(values.data()), std::streamsize(values.size() * sizeof(double)));
+	return bool(out);
+}
+inline bool ReadDoubles(std::istream& in, GSpan<double> values)
+{
+	in.read(reinterpret_cast<char*>(values.data()), std::streamsize(values.size() * sizeof(double)));
+	return bool(in);
+}
+
+/// <summary>
+/// Owning handle of a file opened for bulk reads or for writing (created or truncated).
+/// </summary>
+class GFile
+{
+public:
+					GFile() {}
+					~GFile() { close(); }
+					GFile(const GFile&) = delete;
+	GFile&			operator=(const GFile&) = delete;
+
+	// Opens file_name for reading, or for writing when write is set. Reports the failure on std::cerr.
+	bool			open(const std::string& file_name, bool write = false);
+	// Closes the file; false if the final flush failed.
+	bool			close();
+	bool			isOpen() const;
+	GFileHandle		handle() const { return m_file; }
+	// Size of the file in bytes.
+	uint64_t		size() const;
+
+private:
+#if defined(_WIN32)
+	HANDLE			m_file = INVALID_HANDLE_VALUE;
+#else
+	int				m_file = -1;
+#endif
+};
+
+inline bool GFile::open(const std::string& file_name, bool write)
+{
+	close();
+#if defined(_WIN32)
+	m_file = write
+		? CreateFileA(file_name.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr)
+		: CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+#else
+	m_file = write ? ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) : ::open(file_name.c_str(), O_RDONLY);
+#endif
+	if (!isOpen()) {
+		std::cerr << "Error: Could not open file " << file_name << (write ? " for writing." : " for reading.") << std::endl;
+		return false;
+	}
+	return true;
+}
+
+inline bool GFile::close()
+{
+	bool ok = true;
+#if defined(_WIN32)
+	if (m_file != INVALID_HANDLE_VALUE)
+		ok = CloseHandle(m_file) != 0;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_file >= 0)
+		ok = ::close(m_file) == 0;
+	m_file = -1;
+#endif
+	return ok;
+}
+
+inline bool GFile::isOpen() const
+{
+#if defined(_WIN32)
+	return m_file != INVALID_HANDLE_VALUE;
+#else
+	return m_file >= 0;
+#endif
+}
+
+inline uint64_t GFile::size() const
+{
+#if defined(_WIN32)
+	LARGE_INTEGER fileSize = {};
+	return GetFileSizeEx(m_file, &fileSize) ? uint64_t(fileSize.QuadPart) : 0;
+#else
+	struct stat status;
+	return fstat(m_file, &status) == 0 ? uint64_t(status.st_size) : 0;
+#endif
+}
@@ -0,0 +1,256 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include "GTypes.h"
+#include "GSpan.h"
+#include "GAlignedBuffer.h"
+#include "GSimdKernels.h"
+#include "GInferenceContext.h"
+#include "GNetworkFile.h"
+#include "GMappedFile.h"
+#include "GFileIO.h"
+
+template<typename T> class GNeuralNetMatrixT;
+
+/// <summary>
+/// Immutable, inference-only network produced by GNeuralNetMatrixT::freeze() (or
+/// NetworkFactory::LoadFrozenNetwork). It holds only the packed weight rows of every layer
+/// (bias in the last used column, rows padded like GLayerMatrix) in one aligned block, the
+/// layer kernels for its activation, picked once when it is frozen, and the output layer type.
+/// No gradients, momentum, optimizer moments, batch buffers or thread pool are kept. infer()
+/// is const and writes its activations to a caller-owned GInferenceContextT (or a thread_local
+/// one), so one instance can be shared by any number of threads without locks.
+/// </summary>
+/// <remarks>
+/// The forward pass runs the same forwardLayer kernels as the source network, so with full
+/// precision weights the outputs are identical. The T master weights are frozen whatever the
+/// weight storage; after ReleaseMasterWeights() the 16-bit copy is widened back to T. The
+/// SIMD level is the one active at freeze time.
+/// save() writes a .nnw v2 file (GNetworkFile.h), whose weight sections have exactly the
+/// layout of the frozen weight block. load() maps such a file and, when its dtype is T, runs
+/// on the weights in place: no parsing, no copy, and the pages are shared by every process
+/// that maps the same model.
+/// </remarks>
+template<typename T>
+class GFrozenNetT
+{
+public:
+					GFrozenNetT() {}
+
+		// Runs one sample. input holds the input count, output receives the output count.
+		void		infer(GInferenceContextT<T>& ctx, GSpan<const double> input, GSpan<double> output) const;
+		// Same, through a thread_local context (rebuilt when the thread switches topology).
+		void		infer(GSpan<const double> input, GSpan<double> output) const;
+		// Activation rows for one thread of infer(ctx, ...).
+		GInferenceContextT<T> createContext() const { return GInferenceContextT<T>(m_topology); }
+
+		bool		empty() const { return m_layers.empty(); }
+		Topology	getTopology() const { return m_topology; }
+		size_t		getInputCount() const { return m_topology.front(); }
+		size_t		getOutputCount() const { return m_topology.back(); }
+		ENUM_ACTIVATION GetActivationType() const { return m_activation; }
+		ENUM_ACTIVATION_PRECISION GetActivationPrecision() const { return m_precision; }
+		ENUM_OUTPUT_LAYER GetOutputLayer() const { return m_outputLayer; }
+		// True if the weights are read in place from a mapped v2 file.
+		bool		isMapped() const { return m_mapping != nullptr; }
+		// Bytes held by the frozen network (mapped weights live in the page cache and are not counted).
+		size_t		getMemoryFootprint() const
+		{
+			return sizeof(*this) + m_weights.bytes() + m_layers.capacity() * sizeof(LayerInfo) + m_topology.capacity() * sizeof(size_t);
+		}
+
+		// Writes the network as a .nnw v2 file.
+		bool		save(const std::string& file_name) const;
+		// Reads a .nnw v2 file. With map, a file of dtype T is memory-mapped and its weights are
+		// used in place; otherwise (or for the other dtype) the weights are copied.
+		bool		load(const std::string& file_name, bool map = true);
+
+private:
+		friend class GNeuralNetMatrixT<T>;
+
+		struct LayerInfo
+		{
+			size_t				neurons;
+			size_t				inputs;			// without the bias input
+			size_t				stride;			// padded row length
+			size_t				offset;			// first weight of the layer in m_weights
+		};
+
+		Topology					m_topology;
+		std::vector<LayerInfo>		m_layers;		// layers 1..L-1
+		GAlignedBuffer<T>			m_weights;		// every layer's [neurons x stride] rows, back to back
+		std::shared_ptr<const GMappedFile> m_mapping;	// set when the weights are read from a mapped file
+		const T*					m_mappedWeights = nullptr;	// first section in m_mapping
+		ENUM_ACTIVATION				m_activation = SIGMOID;
+		ENUM_ACTIVATION_PRECISION	m_precision = ACTIVATION_EXACT;
+		ENUM_OUTPUT_LAYER			m_outputLayer = OUTPUT_ACTIVATION;
+		const GLayerKernelsT<T>*	m_kernels = nullptr;
+		T							(*m_dot)(const T* a, const T* b, size_t n) = nullptr;	// softmax output logits
+
+		// Lays out the layers of 'topology' and allocates the weight block (zeroed).
+		void		allocate(const Topology& topology, ENUM_ACTIVATION activation, ENUM_ACTIVATION_PRECISION precision,
+						ENUM_OUTPUT_LAYER outputLayer, bool allocateWeights = true)
+		{
+			m_topology = topology;
+			m_activation = activation;
+			m_precision = precision;
+			m_outputLayer = outputLayer;
+			m_kernels = &GSimd::Kernels<T>().forActivation(activation, precision);
+			m_dot = GSimd::Kernels<T>().dot;
+			m_layers.clear();
+			size_t offset = 0;
+			for (size_t l = 1; l < topology.size(); ++l) {
+				const LayerInfo layer = { topology[l], topology[l - 1], GPaddedCount<T>(topology[l - 1] + 1), offset };
+				m_layers.push_back(layer);
+				offset += layer.neurons * layer.stride;
+			}
+			m_mapping.reset();
+			m_mappedWeights = nullptr;
+			m_weights.resize(allocateWeights ? offset : 0);
+		}
+		// Weight block of all layers: the own buffer, or the sections of the mapped file.
+		const T*	weights() const { return m_mappedWeights ? m_mappedWeights : m_weights.data(); }
+		T*			weightRow(size_t layer, size_t neuron) { return m_weights.data() + m_layers[layer].offset + neuron * m_layers[layer].stride; }
+};
+typedef GFrozenNetT<double> GFrozenNet;
+typedef GFrozenNetT<float> GFrozenNetF;
+
+template<typename T>
+inline void GFrozenNetT<T>::infer(GInferenceContextT<T>& ctx, GSpan<const double> input, GSpan<double> output) const
+{
+	assert(!empty() && ctx.matches(m_topology));
+	assert(input.size() == getInputCount() && output.size() == getOutputCount());
+	T* in = ctx.row(0);
+	for (size_t i = 0; i < input.size(); ++i)
+		in[i] = T(input[i]);
+	for (size_t l = 0; l < m_layers.size(); ++l) {
+		const LayerInfo& layer = m_layers[l];
+		const T* w = weights() + layer.offset;
+		const T* x = ctx.row(l);
+		T* y = ctx.row(l + 1);
+		if (m_outputLayer == OUTPUT_SOFTMAX && l + 1 == m_layers.size()) {
+			for (size_t n = 0; n < layer.neurons; ++n)
+				y[n] = m_dot(w + n * layer.stride, x, layer.stride);
+			GSimd::Softmax(y, layer.neurons, m_precision);
+		}
+		else
+			m_kernels->forwardLayer(w, layer.stride, x, y, layer.neurons);
+	}
+	const T* out = ctx.row(m_layers.size());
+	for (size_t n = 0; n < output.size(); ++n)
+		output[n] = double(out[n]);
+}
+
+template<typename T>
+inline void GFrozenNetT<T>::infer(GSpan<const double> input, GSpan<double> output) const
+{
+	thread_local GInferenceContextT<T> ctx;
+	if (!ctx.matches(m_topology))
+		ctx = createContext();
+	infer(ctx, input, output);
+}
+
+template<typename T>
+inline bool GFrozenNetT<T>::save(const std::string& file_name) const
+{
+	assert(!empty());
+	GFile outFile;
+	if (!outFile.open(file_name, true))
+		return false;
+	std::vector<uint64_t> sections;
+	GNetworkFileHeader header = GNetworkFile::Layout(m_topology, GNetworkFile::ScalarTypeOf<T>(), sections);
+	header.activation = m_activation;
+	header.precision = m_precision;
+	header.outputLayer = m_outputLayer;
+	const std::vector<uint64_t> topology(m_topology.begin(), m_topology.end());
+	std::vector<char> prefix(size_t(sections.front()), 0);
+	std::memcpy(prefix.data(), &header, sizeof(header));
+	std::memcpy(prefix.data() + header.topologyOffset, topology.data(), topology.size() * sizeof(uint64_t));
+	std::memcpy(prefix.data() + header.sectionsOffset, sections.data(), sections.size() * sizeof(uint64_t));
+	// The sections are the frozen weight block: the layer blocks are whole cache lines, back to back
+	const size_t count = m_layers.back().offset + m_layers.back().neurons * m_layers.back().stride;
+	bool ok = WriteBytes(outFile.handle(), prefix.data(), prefix.size())
+		&& WriteBytes(outFile.handle(), weights(), count * sizeof(T));
+	ok = outFile.close() && ok;
+	if (!ok) {
+		std::cerr << "Error: Failed to write " << file_name << "." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+template<typename T>
+inline bool GFrozenNetT<T>::load(const std::string& file_name, bool map)
+{
+	GNetworkFileHeader header = {};
+	Topology topology;
+	std::vector<uint64_t> sections;
+	std::shared_ptr<GMappedFile> mapping;
+	GFile inFile;
+	if (map) {
+		mapping = std::make_shared<GMappedFile>();
+		if (!mapping->open(file_name))
+			return false;
+		if (mapping->size() >= sizeof(header))
+			std::memcpy(&header, mapping->data(), sizeof(header));
+		if (!GNetworkFile::Parse(header, mapping->data(), mapping->size(), mapping->size(), topology, sections)) {
+			std::cerr << "Error: " << file_name << " is not a version 2 network file." << std::endl;
+			return false;
+		}
+	}
+	else {
+		if (!inFile.open(file_name))
+			return false;
+		if (!GNetworkFile::ReadHeader(inFile, header, topology, sections)) {
+			std::cerr << "Error: " << file_name << " is not a version 2 network file." << std::endl;
+			return false;
+		}
+	}
+
+	const bool inPlace = map && header.dtype == GNetworkFile::ScalarTypeOf<T>();
+	allocate(topology, static_cast<ENUM_ACTIVATION>(header.activation), static_cast<ENUM_ACTIVATION_PRECISION>(header.precision),
+		static_cast<ENUM_OUTPUT_LAYER>(header.outputLayer), !inPlace);
+	// In place needs the sections back to back with the frozen layout, which save() produces
+	bool contiguous = inPlace;
+	for (size_t l = 0; contiguous && l < m_layers.size(); ++l)
+		contiguous = sections[l] == sections[0] + m_layers[l].offset * sizeof(T);
+	if (inPlace && contiguous) {
+		m_mapping = mapping;
+		m_mappedWeights = reinterpret_cast<const T*>(mapping->data() + sections[0]);
+		return true;
+	}
+	if (inPlace)
+		m_weights.resize(m_layers.back().offset + m_layers.back().neurons * m_layers.back().stride);
+
+	// Copy (and convert) the sections row by row; the file stride depends on its dtype.
+	// Without a mapping every section comes in with one positioned read.
+	const size_t scalarSize = GNetworkFile::ScalarSize(header.dtype);
+	std::vector<unsigned char> buffer;
+	for (size_t l = 0; l < m_layers.size(); ++l) {
+		const LayerInfo& layer = m_layers[l];
+		const size_t rowBytes = GNetworkFile::Stride(header.dtype, layer.inputs) * scalarSize;
+		const unsigned char* section = nullptr;
+		if (mapping)
+			section = mapping->data() + sections[l];
+		else {
+			buffer.resize(layer.neurons * rowBytes);
+			if (!ReadBytesAt(inFile.handle(), buffer.data(), buffer.size(), sections[l])) {
+				std::cerr << "Error: " << file_name << " is truncated." << std::endl;
+				return false;
+			}
+			section = buffer.data();
+		}
+		for (size_t n = 0; n < layer.neurons; ++n) {
+			const unsigned char* bytes = section + n * rowBytes;
+			T* w = weightRow(l, n);
+			for (size_t i = 0; i <= layer.inputs; ++i)
+				w[i] = header.dtype == SCALAR_FP32 ? T(reinterpret_cast<const float*>(bytes)[i]) : T(reinterpret_cast<const double*>(bytes)[i]);
+		}
+	}
+	return true;
+}
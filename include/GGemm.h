@@ -0,0 +1,391 @@
+#pragma once
+#include <cstddef>
+#include <algorithm>
+#include "GAlignedBuffer.h"
+#include "GSimdKernels.h"
+#include "GHalfKernels.h"
+
+/// <summary>
+/// Packed, cache-blocked, register-blocked matrix multiply for the CPU backend.
+/// Self contained (no external BLAS) so GNeural stays a standalone library.
+/// </summary>
+/// <remarks>
+/// All matrices are row-major. C[M x N] = alpha * op(A)[M x K] * op(B)[K x N] + beta * C,
+/// in double or float (the element type of A, B and C; alpha/beta are always double).
+/// B may also hold 16-bit weights (GBFloat16, GFloat16): they are widened by the half kernels
+/// while B is packed, so the micro-kernels always run on T.
+/// The loop nest follows the usual Goto layout: B is packed into KC x NC panels (L2/L3),
+/// A into MC x KC blocks (L2), and an MR x NR micro-kernel accumulates one tile of C in
+/// registers while streaming NR-wide slivers of B out of L1. M == 1 (single sample
+/// inference) skips packing altogether and runs as a GEMV on the dot/axpy kernels.
+/// </remarks>
+namespace GGemm
+{
+	enum Transpose { NoTrans = 0, Trans = 1 };
+
+	// Cache blocking: KC x NR elements of B stay in L1, MC x KC of A in L2, KC x NC of B in L2/L3.
+	constexpr size_t KC = 256;
+	constexpr size_t MC = 96;
+	constexpr size_t NC = 512;
+
+	template<typename T>
+	struct KernelInfo
+	{
+		void		(*kernel)(size_t kc, const T* a, const T* b, T* c, size_t ldc, T alpha, T beta, size_t mr, size_t nr);
+		size_t		mr;
+		size_t		nr;
+	};
+
+	namespace detail
+	{
+		// Writes an MR x NR register tile (held in 'acc') to C, honouring alpha/beta and edges.
+		template<typename T>
+		inline void storeTile(const T* acc, size_t accStride, T* c, size_t ldc,
+							  T alpha, T beta, size_t mr, size_t nr)
+		{
+			for (size_t i = 0; i < mr; ++i) {
+				T* crow = c + i * ldc;
+				const T* arow = acc + i * accStride;
+				if (beta == T(0))
+					for (size_t j = 0; j < nr; ++j) crow[j] = alpha * arow[j];
+				else
+					for (size_t j = 0; j < nr; ++j) crow[j] = alpha * arow[j] + beta * crow[j];
+			}
+		}
+
+		// Portable 4 x 4 micro-kernel; fixed trip counts let the compiler keep it in registers.
+		template<typename T>
+		inline void microScalar4x4(size_t kc, const T* a, const T* b, T* c, size_t ldc,
+								   T alpha, T beta, size_t mr, size_t nr)
+		{
+			T acc[4][4] = {};
+			for (size_t k = 0; k < kc; ++k, a += 4, b += 4)
+				for (size_t i = 0; i < 4; ++i)
+					for (size_t j = 0; j < 4; ++j)
+						acc[i][j] += a[i] * b[j];
+			storeTile(&acc[0][0], 4, c, ldc, alpha, beta, mr, nr);
+		}
+
+#ifdef G_SIMD_X86
+		// AVX2 + FMA 4 x 8 micro-kernel: 8 ymm accumulators, 2 loads of B and 4 broadcasts of A per k.
+		G_TARGET_AVX2 inline void microAVX2_4x8(size_t kc, const double* a, const double* b, double* c, size_t ldc,
+												 double alpha, double beta, size_t mr, size_t nr)
+		{
+			__m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+			__m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+			__m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+			__m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+			for (size_t k = 0; k < kc; ++k, a += 4, b += 8) {
+				const __m256d b0 = _mm256_load_pd(b), b1 = _mm256_load_pd(b + 4);
+				__m256d ai = _mm256_broadcast_sd(a);
+				c00 = _mm256_fmadd_pd(ai, b0, c00); c01 = _mm256_fmadd_pd(ai, b1, c01);
+				ai = _mm256_broadcast_sd(a + 1);
+				c10 = _mm256_fmadd_pd(ai, b0, c10); c11 = _mm256_fmadd_pd(ai, b1, c11);
+				ai = _mm256_broadcast_sd(a + 2);
+				c20 = _mm256_fmadd_pd(ai, b0, c20); c21 = _mm256_fmadd_pd(ai, b1, c21);
+				ai = _mm256_broadcast_sd(a + 3);
+				c30 = _mm256_fmadd_pd(ai, b0, c30); c31 = _mm256_fmadd_pd(ai, b1, c31);
+			}
+			alignas(32) double acc[4][8];
+			_mm256_store_pd(acc[0], c00); _mm256_store_pd(acc[0] + 4, c01);
+			_mm256_store_pd(acc[1], c10); _mm256_store_pd(acc[1] + 4, c11);
+			_mm256_store_pd(acc[2], c20); _mm256_store_pd(acc[2] + 4, c21);
+			_mm256_store_pd(acc[3], c30); _mm256_store_pd(acc[3] + 4, c31);
+			storeTile(&acc[0][0], 8, c, ldc, alpha, beta, mr, nr);
+		}
+
+		// AVX-512F 4 x 16 micro-kernel: 8 zmm accumulators.
+		G_TARGET_AVX512 inline void microAVX512_4x16(size_t kc, const double* a, const double* b, double* c, size_t ldc,
+													  double alpha, double beta, size_t mr, size_t nr)
+		{
+			__m512d c00 = _mm512_setzero_pd(), c01 = _mm512_setzero_pd();
+			__m512d c10 = _mm512_setzero_pd(), c11 = _mm512_setzero_pd();
+			__m512d c20 = _mm512_setzero_pd(), c21 = _mm512_setzero_pd();
+			__m512d c30 = _mm512_setzero_pd(), c31 = _mm512_setzero_pd();
+			for (size_t k = 0; k < kc; ++k, a += 4, b += 16) {
+				const __m512d b0 = _mm512_load_pd(b), b1 = _mm512_load_pd(b + 8);
+				__m512d ai = _mm512_set1_pd(a[0]);
+				c00 = _mm512_fmadd_pd(ai, b0, c00); c01 = _mm512_fmadd_pd(ai, b1, c01);
+				ai = _mm512_set1_pd(a[1]);
+				c10 = _mm512_fmadd_pd(ai, b0, c10); c11 = _mm512_fmadd_pd(ai, b1, c11);
+				ai = _mm512_set1_pd(a[2]);
+				c20 = _mm512_fmadd_pd(ai, b0, c20); c21 = _mm512_fmadd_pd(ai, b1, c21);
+				ai = _mm512_set1_pd(a[3]);
+				c30 = _mm512_fmadd_pd(ai, b0, c30); c31 = _mm512_fmadd_pd(ai, b1, c31);
+			}
+			alignas(64) double acc[4][16];
+			_mm512_store_pd(acc[0], c00); _mm512_store_pd(acc[0] + 8, c01);
+			_mm512_store_pd(acc[1], c10); _mm512_store_pd(acc[1] + 8, c11);
+			_mm512_store_pd(acc[2], c20); _mm512_store_pd(acc[2] + 8, c21);
+			_mm512_store_pd(acc[3], c30); _mm512_store_pd(acc[3] + 8, c31);
+			storeTile(&acc[0][0], 16, c, ldc, alpha, beta, mr, nr);
+		}
+
+		// Single precision AVX2 4 x 16 micro-kernel: same register budget, twice the columns.
+		G_TARGET_AVX2 inline void microAVX2_4x16(size_t kc, const float* a, const float* b, float* c, size_t ldc,
+												  float alpha, float beta, size_t mr, size_t nr)
+		{
+			__m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+			__m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+			__m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+			__m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+			for (size_t k = 0; k < kc; ++k, a += 4, b += 16) {
+				const __m256 b0 = _mm256_load_ps(b), b1 = _mm256_load_ps(b + 8);
+				__m256 ai = _mm256_broadcast_ss(a);
+				c00 = _mm256_fmadd_ps(ai, b0, c00); c01 = _mm256_fmadd_ps(ai, b1, c01);
+				ai = _mm256_broadcast_ss(a + 1);
+				c10 = _mm256_fmadd_ps(ai, b0, c10); c11 = _mm256_fmadd_ps(ai, b1, c11);
+				ai = _mm256_broadcast_ss(a + 2);
+				c20 = _mm256_fmadd_ps(ai, b0, c20); c21 = _mm256_fmadd_ps(ai, b1, c21);
+				ai = _mm256_broadcast_ss(a + 3);
+				c30 = _mm256_fmadd_ps(ai, b0, c30); c31 = _mm256_fmadd_ps(ai, b1, c31);
+			}
+			alignas(32) float acc[4][16];
+			_mm256_store_ps(acc[0], c00); _mm256_store_ps(acc[0] + 8, c01);
+			_mm256_store_ps(acc[1], c10); _mm256_store_ps(acc[1] + 8, c11);
+			_mm256_store_ps(acc[2], c20); _mm256_store_ps(acc[2] + 8, c21);
+			_mm256_store_ps(acc[3], c30); _mm256_store_ps(acc[3] + 8, c31);
+			storeTile(&acc[0][0], 16, c, ldc, alpha, beta, mr, nr);
+		}
+
+		// Single precision AVX-512F 4 x 32 micro-kernel.
+		G_TARGET_AVX512 inline void microAVX512_4x32(size_t kc, const float* a, const float* b, float* c, size_t ldc,
+													  float alpha, float beta, size_t mr, size_t nr)
+		{
+			__m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps();
+			__m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+			__m512 c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+			__m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps();
+			for (size_t k = 0; k < kc; ++k, a += 4, b += 32) {
+				const __m512 b0 = _mm512_load_ps(b), b1 = _mm512_load_ps(b + 16);
+				__m512 ai = _mm512_set1_ps(a[0]);
+				c00 = _mm512_fmadd_ps(ai, b0, c00); c01 = _mm512_fmadd_ps(ai, b1, c01);
+				ai = _mm512_set1_ps(a[1]);
+				c10 = _mm512_fmadd_ps(ai, b0, c10); c11 = _mm512_fmadd_ps(ai, b1, c11);
+				ai = _mm512_set1_ps(a[2]);
+				c20 = _mm512_fmadd_ps(ai, b0, c20); c21 = _mm512_fmadd_ps(ai, b1, c21);
+				ai = _mm512_set1_ps(a[3]);
+				c30 = _mm512_fmadd_ps(ai, b0, c30); c31 = _mm512_fmadd_ps(ai, b1, c31);
+			}
+			alignas(64) float acc[4][32];
+			_mm512_store_ps(acc[0], c00); _mm512_store_ps(acc[0] + 16, c01);
+			_mm512_store_ps(acc[1], c10); _mm512_store_ps(acc[1] + 16, c11);
+			_mm512_store_ps(acc[2], c20); _mm512_store_ps(acc[2] + 16, c21);
+			_mm512_store_ps(acc[3], c30); _mm512_store_ps(acc[3] + 16, c31);
+			storeTile(&acc[0][0], 32, c, ldc, alpha, beta, mr, nr);
+		}
+#endif
+
+		// Packs rows [0, mc) x cols [0, kc) of op(A) into MR-row slivers, k-major, zero padded.
+		template<typename T>
+		inline void packA(Transpose transA, const T* A, size_t lda, size_t mc, size_t kc, size_t mr, T* Ap)
+		{
+			for (size_t ir = 0; ir < mc; ir += mr) {
+				const size_t rows = std::min(mr, mc - ir);
+				for (size_t k = 0; k < kc; ++k) {
+					for (size_t i = 0; i < rows; ++i)
+						Ap[k * mr + i] = transA ? A[k * lda + ir + i] : A[(ir + i) * lda + k];
+					for (size_t i = rows; i < mr; ++i)
+						Ap[k * mr + i] = T(0);
+				}
+				Ap += kc * mr;
+			}
+		}
+
+		// Packs rows [0, kc) x cols [0, nc) of op(B) into NR-column slivers, k-major, zero padded.
+		// TB is T (16-bit B has the overloads below).
+		template<typename TB, typename T>
+		inline void packB(Transpose transB, const TB* B, size_t ldb, size_t kc, size_t nc, size_t nr, T* Bp)
+		{
+			for (size_t jr = 0; jr < nc; jr += nr) {
+				const size_t cols = std::min(nr, nc - jr);
+				for (size_t k = 0; k < kc; ++k) {
+					for (size_t j = 0; j < cols; ++j)
+						Bp[k * nr + j] = T(transB ? B[(jr + j) * ldb + k] : B[k * ldb + jr + j]);
+					for (size_t j = cols; j < nr; ++j)
+						Bp[k * nr + j] = T(0);
+				}
+				Bp += kc * nr;
+			}
+		}
+
+		// One row of a GEMV operand against x; 16-bit rows go through the half kernels.
+		template<typename T>
+		inline T rowDot(const GSimdKernelsT<T>& K, const T* a, const T* x, size_t n) { return K.dot(a, x, n); }
+		template<typename T, typename S>
+		inline T rowDot(const GSimdKernelsT<T>&, const S* a, const T* x, size_t n) { return GSimd::HalfKernels<T, S>().dot(a, x, n); }
+		template<typename T>
+		inline void rowAxpy(const GSimdKernelsT<T>& K, T alpha, const T* a, T* y, size_t n) { K.axpy(alpha, a, y, n); }
+		template<typename T, typename S>
+		inline void rowAxpy(const GSimdKernelsT<T>&, T alpha, const S* a, T* y, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i)
+				y[i] += alpha * T(a[i]);
+		}
+
+		// Per-thread packing buffers, grown on demand and then reused.
+		template<typename T>
+		inline T* scratch(GAlignedBuffer<T>& buffer, size_t count)
+		{
+			if (buffer.size() < count)
+				buffer.resize(count);
+			return buffer.data();
+		}
+
+		// packB for 16-bit B: each source row is widened with the half kernels, then packed.
+		template<typename S, typename T>
+		inline void packHalfB(Transpose transB, const S* B, size_t ldb, size_t kc, size_t nc, size_t nr, T* Bp)
+		{
+			const GHalfKernelsT<T, S>& H = GSimd::HalfKernels<T, S>();
+			thread_local GAlignedBuffer<T> wideRow;
+			T* row = scratch(wideRow, transB ? kc : nc);
+			if (!transB) {
+				for (size_t k = 0; k < kc; ++k) {
+					H.widen(B + k * ldb, row, nc);
+					for (size_t jr = 0; jr < nc; jr += nr) {
+						const size_t cols = std::min(nr, nc - jr);
+						T* dst = Bp + jr * kc + k * nr;
+						for (size_t j = 0; j < cols; ++j) dst[j] = row[jr + j];
+						for (size_t j = cols; j < nr; ++j) dst[j] = T(0);
+					}
+				}
+				return;
+			}
+			for (size_t jr = 0; jr < nc; jr += nr) {
+				const size_t cols = std::min(nr, nc - jr);
+				for (size_t j = 0; j < nr; ++j) {
+					if (j < cols)
+						H.widen(B + (jr + j) * ldb, row, kc);
+					for (size_t k = 0; k < kc; ++k)
+						Bp[k * nr + j] = j < cols ? row[k] : T(0);
+				}
+				Bp += kc * nr;
+			}
+		}
+		template<typename T>
+		inline void packB(Transpose transB, const GBFloat16* B, size_t ldb, size_t kc, size_t nc, size_t nr, T* Bp)
+		{
+			packHalfB(transB, B, ldb, kc, nc, nr, Bp);
+		}
+		template<typename T>
+		inline void packB(Transpose transB, const GFloat16* B, size_t ldb, size_t kc, size_t nc, size_t nr, T* Bp)
+		{
+			packHalfB(transB, B, ldb, kc, nc, nr, Bp);
+		}
+	}
+
+	/// <summary>
+	/// Micro-kernel matching the active SIMD level (see GSimd::Kernels()).
+	/// </summary>
+	template<typename T> KernelInfo<T> ActiveKernel();
+	template<>
+	inline KernelInfo<double> ActiveKernel<double>()
+	{
+#ifdef G_SIMD_X86
+		switch (GSimd::ActiveLevel()) {
+		case SIMD_AVX512:	return { detail::microAVX512_4x16, 4, 16 };
+		case SIMD_AVX2:		return { detail::microAVX2_4x8, 4, 8 };
+		default:			break;
+		}
+#endif
+		return { detail::microScalar4x4<double>, 4, 4 };
+	}
+	template<>
+	inline KernelInfo<float> ActiveKernel<float>()
+	{
+#ifdef G_SIMD_X86
+		switch (GSimd::ActiveLevel()) {
+		case SIMD_AVX512:	return { detail::microAVX512_4x32, 4, 32 };
+		case SIMD_AVX2:		return { detail::microAVX2_4x16, 4, 16 };
+		default:			break;
+		}
+#endif
+		return { detail::microScalar4x4<float>, 4, 4 };
+	}
+
+	/// <summary>
+	/// y[M] = alpha * op(A)[M x N] * x[N] + beta * y. Used directly for single samples.
+	/// A holds T or 16-bit weights (TA).
+	/// </summary>
+	template<typename T, typename TA>
+	inline void gemv(Transpose transA, size_t M, size_t N, double alpha, const TA* A, size_t lda,
+					 const T* x, double beta, T* y)
+	{
+		const GSimdKernelsT<T>& K = GSimd::Kernels<T>();
+		const T a = T(alpha), b = T(beta);
+		if (!transA) {
+			for (size_t i = 0; i < M; ++i) {
+				const T dot = a * detail::rowDot(K, A + i * lda, x, N);
+				y[i] = beta == 0.0 ? dot : dot + b * y[i];
+			}
+		}
+		else {
+			// op(A) = A^T: y is a combination of the rows of A
+			if (beta == 0.0)
+				for (size_t i = 0; i < M; ++i) y[i] = T(0);
+			else if (beta != 1.0)
+				for (size_t i = 0; i < M; ++i) y[i] *= b;
+			for (size_t j = 0; j < N; ++j)
+				detail::rowAxpy(K, T(a * x[j]), A + j * lda, y, M);
+		}
+	}
+
+	/// <summary>
+	/// C[M x N] = alpha * op(A)[M x K] * op(B)[K x N] + beta * C, all row-major.
+	/// B holds T or 16-bit weights (TB).
+	/// </summary>
+	template<typename T, typename TB>
+	inline void gemm(Transpose transA, Transpose transB, size_t M, size_t N, size_t K,
+					 double alpha, const T* A, size_t lda, const TB* B, size_t ldb,
+					 double beta, T* C, size_t ldc)
+	{
+		if (M == 0 || N == 0)
+			return;
+		if (K == 0) {
+			for (size_t i = 0; i < M; ++i)
+				for (size_t j = 0; j < N; ++j)
+					C[i * ldc + j] = beta == 0.0 ? T(0) : T(beta) * C[i * ldc + j];
+			return;
+		}
+		if (M == 1) {
+			// Row vector times op(B): a GEMV on the transposed problem, no packing needed
+			const T* x = A;
+			if (transA && lda != 1) {
+				thread_local GAlignedBuffer<T> row;
+				T* gathered = detail::scratch(row, K);
+				for (size_t k = 0; k < K; ++k) gathered[k] = A[k * lda];
+				x = gathered;
+			}
+			gemv(transB ? NoTrans : Trans, N, K, alpha, B, ldb, x, beta, C);
+			return;
+		}
+
+		const KernelInfo<T> micro = ActiveKernel<T>();
+		thread_local GAlignedBuffer<T> bufferA, bufferB;
+		T* Ap = detail::scratch(bufferA, (MC + micro.mr) * KC);
+		T* Bp = detail::scratch(bufferB, (NC + micro.nr) * KC);
+
+		for (size_t jc = 0; jc < N; jc += NC) {
+			const size_t nc = std::min(NC, N - jc);
+			for (size_t pc = 0; pc < K; pc += KC) {
+				const size_t kc = std::min(KC, K - pc);
+				const T betaBlock = pc == 0 ? T(beta) : T(1);
+				const TB* Bblock = transB ? B + jc * ldb + pc : B + pc * ldb + jc;
+				detail::packB(transB, Bblock, ldb, kc, nc, micro.nr, Bp);
+				for (size_t ic = 0; ic < M; ic += MC) {
+					const size_t mc = std::min(MC, M - ic);
+					const T* Ablock = transA ? A + pc * lda + ic : A + ic * lda + pc;
+					detail::packA(transA, Ablock, lda, mc, kc, micro.mr, Ap);
+					for (size_t jr = 0; jr < nc; jr += micro.nr) {
+						const size_t nr = std::min(micro.nr, nc - jr);
+						for (size_t ir = 0; ir < mc; ir += micro.mr) {
+							const size_t mr = std::min(micro.mr, mc - ir);
+							micro.kernel(kc, Ap + ir * kc, Bp + jr * kc, C + (ic + ir) * ldc + jc + jr, ldc,
+								T(alpha), betaBlock, mr, nr);
+						}
+					}
+				}
+			}
+		}
+	}
+}
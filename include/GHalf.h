@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+/// <summary>
+/// Software conversions between float and the two 16-bit weight formats. They round to
+/// nearest even and keep infinities and NaNs, like the F16C / AVX512-BF16 instructions,
+/// and are the reference for the vectorized kernels in GHalfKernels.h.
+/// </summary>
+namespace GHalf
+{
+	inline uint32_t FloatBits(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+	inline float BitsFloat(uint32_t bits)
+	{
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// bfloat16 is the upper half of a float: rounding is one add on the dropped 16 bits.
+	inline uint16_t FloatToBF16(float value)
+	{
+		const uint32_t bits = FloatBits(value);
+		if ((bits & 0x7FFFFFFF) > 0x7F800000)
+			return static_cast<uint16_t>((bits >> 16) | 0x40);		// quiet NaN
+		return static_cast<uint16_t>((bits + 0x7FFF + ((bits >> 16) & 1)) >> 16);
+	}
+	inline float BF16ToFloat(uint16_t bits) { return BitsFloat(static_cast<uint32_t>(bits) << 16); }
+
+	inline uint16_t FloatToFP16(float value)
+	{
+		uint32_t x = FloatBits(value);
+		const uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+		x &= 0x7FFFFFFF;
+		if (x >= 0x7F800000)										// Inf / NaN
+			return sign | 0x7C00 | (x > 0x7F800000 ? 0x200 | ((x >> 13) & 0x3FF) : 0);
+		if (x >= 0x477FF000)										// rounds above 65504
+			return sign | 0x7C00;
+		if (x < 0x38800000) {										// below 2^-14: subnormal
+			if (x <= 0x33000000)
+				return sign;
+			const uint32_t shift = 126 - (x >> 23);
+			const uint32_t mantissa = (x & 0x7FFFFF) | 0x800000;
+			const uint32_t rest = mantissa & ((1u << shift) - 1), half = 1u << (shift - 1);
+			uint32_t h = mantissa >> shift;
+			if (rest > half || (rest == half && (h & 1)))
+				++h;
+			return sign | static_cast<uint16_t>(h);
+		}
+		uint32_t h = (x - 0x38000000) >> 13;						// rebias 127 -> 15
+		const uint32_t rest = x & 0x1FFF;
+		if (rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+			++h;
+		return sign | static_cast<uint16_t>(h);
+	}
+	inline float FP16ToFloat(uint16_t h)
+	{
+		const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+		uint32_t exponent = (h >> 10) & 0x1F, mantissa = h & 0x3FF;
+		if (exponent == 0x1F)
+			return BitsFloat(sign | 0x7F800000 | (mantissa << 13));
+		if (exponent)
+			return BitsFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+		if (!mantissa)
+			return BitsFloat(sign);
+		// Subnormal half: normalize into a float exponent
+		exponent = 113;
+		while (!(mantissa & 0x400)) {
+			mantissa <<= 1;
+			--exponent;
+		}
+		return BitsFloat(sign | (exponent << 23) | ((mantissa & 0x3FF) << 13));
+	}
+}
+
+/// <summary>
+/// bfloat16 weight: same range as float, 8 significant bits. Converts to float implicitly,
+/// so templated code written for T can read it (GGemm packs it straight into float panels).
+/// </summary>
+struct GBFloat16
+{
+	uint16_t		bits;
+
+					GBFloat16() = default;
+	explicit		GBFloat16(float value) : bits(GHalf::FloatToBF16(value)) {}
+					operator float() const { return GHalf::BF16ToFloat(bits); }
+};
+
+/// <summary>
+/// IEEE 754 binary16 weight: 11 significant bits, magnitudes up to 65504.
+/// </summary>
+struct GFloat16
+{
+	uint16_t		bits;
+
+					GFloat16() = default;
+	explicit		GFloat16(float value) : bits(GHalf::FloatToFP16(value)) {}
+					operator float() const { return GHalf::FP16ToFloat(bits); }
+};
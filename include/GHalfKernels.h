@@ -0,0 +1,322 @@
+#pragma once
+#include <cstddef>
+#include "GHalf.h"
+#include "GSimdKernels.h"
+
+// F16C is a separate CPUID bit from AVX2; AVX512-BF16 only narrows, widening is a shift.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define G_TARGET_F16C
+#define G_TARGET_AVX512BF16
+#else
+#define G_TARGET_F16C		__attribute__((target("avx2,fma,f16c")))
+#define G_TARGET_AVX512BF16	__attribute__((target("avx512f,avx512bf16,avx2,fma")))
+#endif
+
+/// <summary>
+/// Kernels between compute type T and one 16-bit storage format S (GBFloat16 or GFloat16),
+/// used when a network keeps a 16-bit copy of its weights (ENUM_WEIGHT_STORAGE). The dot
+/// product widens the weights in registers and accumulates in fp32, so the 16-bit row is
+/// the only weight data read from memory; for double the inputs are narrowed to fp32 in
+/// registers too, as the weights carry no more precision than that. GSimd::HalfKernels&lt;T, S&gt;()
+/// returns the set of the active level.
+/// </summary>
+template<typename T, typename S>
+struct GHalfKernelsT
+{
+	const char*		name;
+	// Returns sum(w[i] * x[i]) with w widened to T: one neuron's net input from 16-bit weights.
+	T				(*dot)(const S* w, const T* x, size_t n);
+	// dst[i] = S(src[i]), rounded to nearest even: refreshes the 16-bit copy of a master row.
+	void			(*narrow)(const T* src, S* dst, size_t n);
+	// dst[i] = T(src[i]), exact.
+	void			(*widen)(const S* src, T* dst, size_t n);
+};
+
+namespace GSimd
+{
+	namespace detail
+	{
+		// --- Scalar reference kernels (software conversion), also used for tails ---
+		template<typename T, typename S> inline T dotHalfScalar(const S* w, const T* x, size_t n)
+		{
+			T sum = T(0);
+			for (size_t i = 0; i < n; ++i)
+				sum += T(w[i]) * x[i];
+			return sum;
+		}
+		template<typename T, typename S> inline void narrowHalfScalar(const T* src, S* dst, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i)
+				dst[i] = S(static_cast<float>(src[i]));
+		}
+		template<typename T, typename S> inline void widenHalfScalar(const S* src, T* dst, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i)
+				dst[i] = T(src[i]);
+		}
+
+#ifdef G_SIMD_X86
+		// --- SSE4.2: bfloat16 only (IEEE half needs F16C) ---
+		// Four values of the compute type as fp32 lanes, and back.
+		G_TARGET_SSE42 inline __m128 loadComputeSSE42(const float* x) { return _mm_loadu_ps(x); }
+		G_TARGET_SSE42 inline __m128 loadComputeSSE42(const double* x)
+		{
+			return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(x)), _mm_cvtpd_ps(_mm_loadu_pd(x + 2)));
+		}
+		G_TARGET_SSE42 inline void storeComputeSSE42(float* dst, __m128 v) { _mm_storeu_ps(dst, v); }
+		G_TARGET_SSE42 inline void storeComputeSSE42(double* dst, __m128 v)
+		{
+			_mm_storeu_pd(dst, _mm_cvtps_pd(v));
+			_mm_storeu_pd(dst + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+		}
+		G_TARGET_SSE42 inline __m128 loadBF16SSE42(const GBFloat16* w)
+		{
+			return _mm_castsi128_ps(_mm_slli_epi32(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(w))), 16));
+		}
+		G_TARGET_SSE42 inline void storeBF16SSE42(GBFloat16* dst, __m128 v)
+		{
+			const __m128i bits = _mm_castps_si128(v), upper = _mm_srli_epi32(bits, 16);
+			__m128i r = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bits, _mm_set1_epi32(0x7FFF)),
+				_mm_and_si128(upper, _mm_set1_epi32(1))), 16);
+			r = _mm_blendv_epi8(r, _mm_or_si128(upper, _mm_set1_epi32(0x40)), _mm_castps_si128(_mm_cmpunord_ps(v, v)));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi32(r, r));
+		}
+		template<typename T> G_TARGET_SSE42 inline T dotHalfSSE42(const GBFloat16* w, const T* x, size_t n)
+		{
+			__m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				acc0 = _mm_add_ps(acc0, _mm_mul_ps(loadBF16SSE42(w + i), loadComputeSSE42(x + i)));
+				acc1 = _mm_add_ps(acc1, _mm_mul_ps(loadBF16SSE42(w + i + 4), loadComputeSSE42(x + i + 4)));
+			}
+			for (; i + 4 <= n; i += 4)
+				acc0 = _mm_add_ps(acc0, _mm_mul_ps(loadBF16SSE42(w + i), loadComputeSSE42(x + i)));
+			__m128 s = _mm_add_ps(acc0, acc1);
+			s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			return T(_mm_cvtss_f32(s)) + dotHalfScalar(w + i, x + i, n - i);
+		}
+		template<typename T> G_TARGET_SSE42 inline void narrowHalfSSE42(const T* src, GBFloat16* dst, size_t n)
+		{
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+				storeBF16SSE42(dst + i, loadComputeSSE42(src + i));
+			narrowHalfScalar(src + i, dst + i, n - i);
+		}
+		template<typename T> G_TARGET_SSE42 inline void widenHalfSSE42(const GBFloat16* src, T* dst, size_t n)
+		{
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+				storeComputeSSE42(dst + i, loadBF16SSE42(src + i));
+			widenHalfScalar(src + i, dst + i, n - i);
+		}
+
+		// --- AVX2 + FMA (bfloat16) and F16C (IEEE half), 8 lanes ---
+		G_TARGET_AVX2 inline float reduceHalfAVX2(__m256 acc)
+		{
+			__m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+			s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			return _mm_cvtss_f32(s);
+		}
+		G_TARGET_AVX2 inline __m256 loadComputeAVX2(const float* x) { return _mm256_loadu_ps(x); }
+		G_TARGET_AVX2 inline __m256 loadComputeAVX2(const double* x)
+		{
+			return _mm256_set_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(x + 4)), _mm256_cvtpd_ps(_mm256_loadu_pd(x)));
+		}
+		G_TARGET_AVX2 inline void storeComputeAVX2(float* dst, __m256 v) { _mm256_storeu_ps(dst, v); }
+		G_TARGET_AVX2 inline void storeComputeAVX2(double* dst, __m256 v)
+		{
+			_mm256_storeu_pd(dst, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+			_mm256_storeu_pd(dst + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+		}
+		G_TARGET_AVX2 inline __m256 loadHalfAVX2(const GBFloat16* w)
+		{
+			return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w))), 16));
+		}
+		G_TARGET_F16C inline __m256 loadHalfAVX2(const GFloat16* w)
+		{
+			return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w)));
+		}
+		G_TARGET_AVX2 inline void storeHalfAVX2(GBFloat16* dst, __m256 v)
+		{
+			const __m256i bits = _mm256_castps_si256(v), upper = _mm256_srli_epi32(bits, 16);
+			__m256i r = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(bits, _mm256_set1_epi32(0x7FFF)),
+				_mm256_and_si256(upper, _mm256_set1_epi32(1))), 16);
+			r = _mm256_blendv_epi8(r, _mm256_or_si256(upper, _mm256_set1_epi32(0x40)), _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q)));
+			// packus works per 128-bit lane; gather the two low quadwords
+			r = _mm256_permute4x64_epi64(_mm256_packus_epi32(r, r), 0x08);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(r));
+		}
+		G_TARGET_F16C inline void storeHalfAVX2(GFloat16* dst, __m256 v)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+		}
+		// The generic bodies take the target with the most features they may need.
+		template<typename T, typename S> G_TARGET_F16C inline T dotHalfAVX2(const S* w, const T* x, size_t n)
+		{
+			__m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				acc0 = _mm256_fmadd_ps(loadHalfAVX2(w + i), loadComputeAVX2(x + i), acc0);
+				acc1 = _mm256_fmadd_ps(loadHalfAVX2(w + i + 8), loadComputeAVX2(x + i + 8), acc1);
+			}
+			for (; i + 8 <= n; i += 8)
+				acc0 = _mm256_fmadd_ps(loadHalfAVX2(w + i), loadComputeAVX2(x + i), acc0);
+			return T(reduceHalfAVX2(_mm256_add_ps(acc0, acc1))) + dotHalfScalar(w + i, x + i, n - i);
+		}
+		template<typename T, typename S> G_TARGET_F16C inline void narrowHalfAVX2(const T* src, S* dst, size_t n)
+		{
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8)
+				storeHalfAVX2(dst + i, loadComputeAVX2(src + i));
+			narrowHalfScalar(src + i, dst + i, n - i);
+		}
+		template<typename T, typename S> G_TARGET_F16C inline void widenHalfAVX2(const S* src, T* dst, size_t n)
+		{
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8)
+				storeComputeAVX2(dst + i, loadHalfAVX2(src + i));
+			widenHalfScalar(src + i, dst + i, n - i);
+		}
+
+		// --- AVX-512F, 16 lanes (vcvtph2ps/vcvtps2ph are part of AVX-512F) ---
+		G_TARGET_AVX512 inline __m512 loadComputeAVX512(const float* x) { return _mm512_loadu_ps(x); }
+		G_TARGET_AVX512 inline __m512 loadComputeAVX512(const double* x)
+		{
+			const __m256 lo = _mm512_cvtpd_ps(_mm512_loadu_pd(x)), hi = _mm512_cvtpd_ps(_mm512_loadu_pd(x + 8));
+			return _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_castps_pd(lo)), _mm256_castps_pd(hi), 1));
+		}
+		G_TARGET_AVX512 inline void storeComputeAVX512(float* dst, __m512 v) { _mm512_storeu_ps(dst, v); }
+		G_TARGET_AVX512 inline void storeComputeAVX512(double* dst, __m512 v)
+		{
+			_mm512_storeu_pd(dst, _mm512_cvtps_pd(_mm512_castps512_ps256(v)));
+			_mm512_storeu_pd(dst + 8, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1))));
+		}
+		G_TARGET_AVX512 inline __m512 loadHalfAVX512(const GBFloat16* w)
+		{
+			return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(w))), 16));
+		}
+		G_TARGET_AVX512 inline __m512 loadHalfAVX512(const GFloat16* w)
+		{
+			return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(w)));
+		}
+		G_TARGET_AVX512 inline void storeHalfAVX512(GBFloat16* dst, __m512 v)
+		{
+			const __m512i bits = _mm512_castps_si512(v), upper = _mm512_srli_epi32(bits, 16);
+			__m512i r = _mm512_srli_epi32(_mm512_add_epi32(_mm512_add_epi32(bits, _mm512_set1_epi32(0x7FFF)),
+				_mm512_and_si512(upper, _mm512_set1_epi32(1))), 16);
+			r = _mm512_mask_mov_epi32(r, _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q), _mm512_or_si512(upper, _mm512_set1_epi32(0x40)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm512_cvtepi32_epi16(r));
+		}
+		G_TARGET_AVX512 inline void storeHalfAVX512(GFloat16* dst, __m512 v)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+		}
+		template<typename T, typename S> G_TARGET_AVX512 inline T dotHalfAVX512(const S* w, const T* x, size_t n)
+		{
+			__m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+			size_t i = 0;
+			for (; i + 32 <= n; i += 32) {
+				acc0 = _mm512_fmadd_ps(loadHalfAVX512(w + i), loadComputeAVX512(x + i), acc0);
+				acc1 = _mm512_fmadd_ps(loadHalfAVX512(w + i + 16), loadComputeAVX512(x + i + 16), acc1);
+			}
+			for (; i + 16 <= n; i += 16)
+				acc0 = _mm512_fmadd_ps(loadHalfAVX512(w + i), loadComputeAVX512(x + i), acc0);
+			return T(_mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1))) + dotHalfScalar(w + i, x + i, n - i);
+		}
+		template<typename T, typename S> G_TARGET_AVX512 inline void narrowHalfAVX512(const T* src, S* dst, size_t n)
+		{
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16)
+				storeHalfAVX512(dst + i, loadComputeAVX512(src + i));
+			narrowHalfScalar(src + i, dst + i, n - i);
+		}
+		template<typename T, typename S> G_TARGET_AVX512 inline void widenHalfAVX512(const S* src, T* dst, size_t n)
+		{
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16)
+				storeComputeAVX512(dst + i, loadHalfAVX512(src + i));
+			widenHalfScalar(src + i, dst + i, n - i);
+		}
+		// AVX512-BF16 rounds in one instruction, but flushes denormal inputs to zero; a vector
+		// holding one goes through the AVX-512F rounding, so the copy matches narrowHalfScalar.
+		template<typename T> G_TARGET_AVX512BF16 inline void narrowHalfAVX512BF16(const T* src, GBFloat16* dst, size_t n)
+		{
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				const __m512 v = loadComputeAVX512(src + i);
+				const __m512i bits = _mm512_castps_si512(v);
+				if (_mm512_mask_test_epi32_mask(_mm512_testn_epi32_mask(bits, _mm512_set1_epi32(0x7F800000)), bits, _mm512_set1_epi32(0x007FFFFF)))
+					storeHalfAVX512(dst + i, v);
+				else
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), (__m256i)_mm512_cvtneps_pbh(v));
+			}
+			narrowHalfScalar(src + i, dst + i, n - i);
+		}
+
+		inline bool hasF16C()
+		{
+			static const bool f16c = [] {
+				unsigned r[4];
+				cpuid(1, 0, r);
+				return ((r[2] >> 29) & 1) != 0;
+			}();
+			return f16c;
+		}
+		inline bool hasAVX512BF16()
+		{
+			static const bool bf16 = [] {
+				unsigned r[4];
+				cpuid(0, 0, r);
+				if (r[0] < 7)
+					return false;
+				cpuid(7, 0, r);
+				if (r[0] < 1)
+					return false;
+				cpuid(7, 1, r);
+				return ((r[0] >> 5) & 1) != 0;
+			}();
+			return bf16;
+		}
+#endif // G_SIMD_X86
+
+		// Non-x86 builds use the scalar kernels at every level.
+		template<typename T, typename S> inline const GHalfKernelsT<T, S>& halfTable(ENUM_SIMD_LEVEL)
+		{
+			static const GHalfKernelsT<T, S> scalar = { "scalar", dotHalfScalar<T, S>, narrowHalfScalar<T, S>, widenHalfScalar<T, S> };
+			return scalar;
+		}
+#ifdef G_SIMD_X86
+		template<typename T> inline const GHalfKernelsT<T, GBFloat16>& halfTableBF16(ENUM_SIMD_LEVEL level)
+		{
+			static const GHalfKernelsT<T, GBFloat16> tables[] = {
+				{ "scalar", dotHalfScalar<T, GBFloat16>, narrowHalfScalar<T, GBFloat16>, widenHalfScalar<T, GBFloat16> },
+				{ "sse4.2", dotHalfSSE42<T>, narrowHalfSSE42<T>, widenHalfSSE42<T> },
+				{ "avx2+fma", dotHalfAVX2<T, GBFloat16>, narrowHalfAVX2<T, GBFloat16>, widenHalfAVX2<T, GBFloat16> },
+				{ "avx512f", dotHalfAVX512<T, GBFloat16>, narrowHalfAVX512<T, GBFloat16>, widenHalfAVX512<T, GBFloat16> },
+				{ "avx512bf16", dotHalfAVX512<T, GBFloat16>, narrowHalfAVX512BF16<T>, widenHalfAVX512<T, GBFloat16> },
+			};
+			return tables[level == SIMD_AVX512 && hasAVX512BF16() ? 4 : level];
+		}
+		template<typename T> inline const GHalfKernelsT<T, GFloat16>& halfTableFP16(ENUM_SIMD_LEVEL level)
+		{
+			static const GHalfKernelsT<T, GFloat16> tables[] = {
+				{ "scalar", dotHalfScalar<T, GFloat16>, narrowHalfScalar<T, GFloat16>, widenHalfScalar<T, GFloat16> },
+				{ "avx2+f16c", dotHalfAVX2<T, GFloat16>, narrowHalfAVX2<T, GFloat16>, widenHalfAVX2<T, GFloat16> },
+				{ "avx512f", dotHalfAVX512<T, GFloat16>, narrowHalfAVX512<T, GFloat16>, widenHalfAVX512<T, GFloat16> },
+			};
+			if (level == SIMD_AVX512) return tables[2];
+			return tables[level == SIMD_AVX2 && hasF16C() ? 1 : 0];
+		}
+		template<> inline const GHalfKernelsT<float, GBFloat16>& halfTable(ENUM_SIMD_LEVEL level) { return halfTableBF16<float>(level); }
+		template<> inline const GHalfKernelsT<double, GBFloat16>& halfTable(ENUM_SIMD_LEVEL level) { return halfTableBF16<double>(level); }
+		template<> inline const GHalfKernelsT<float, GFloat16>& halfTable(ENUM_SIMD_LEVEL level) { return halfTableFP16<float>(level); }
+		template<> inline const GHalfKernelsT<double, GFloat16>& halfTable(ENUM_SIMD_LEVEL level) { return halfTableFP16<double>(level); }
+#endif
+	}
+
+	// 16-bit weight kernels of the active level. Cheap enough to call once per pass or row.
+	template<typename T, typename S>
+	inline const GHalfKernelsT<T, S>& HalfKernels() { return detail::halfTable<T, S>(ActiveLevel()); }
+}
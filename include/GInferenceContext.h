@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+#include "GTypes.h"
+#include "GAlignedBuffer.h"
+
+/// <summary>
+/// Mutable activation rows of one inference call, kept apart from the network parameters so
+/// that one network can serve several threads: each thread owns a context and calls
+/// infer(ctx, input, output) on the shared, const network (GNeuralNetMatrixT or GFrozenNetT).
+/// Holds one padded row per layer, laid out like GLayerMatrix::outputs() (bias input set to
+/// 1, zero padding), in a single aligned block. A context fits every network of its topology.
+/// </summary>
+template<typename T>
+class GInferenceContextT
+{
+public:
+					GInferenceContextT() {}
+	explicit		GInferenceContextT(const Topology& topology) : m_topology(topology)
+	{
+		size_t total = 0;
+		for (size_t l = 0; l < topology.size(); ++l) {
+			m_offsets.push_back(total);
+			total += GPaddedCount<T>(topology[l] + 1);
+		}
+		m_rows.resize(total);
+		for (size_t l = 0; l < topology.size(); ++l)
+			m_rows[m_offsets[l] + topology[l]] = T(1);
+	}
+
+	// True if the context was built for 'topology'.
+	bool			matches(const Topology& topology) const { return m_topology == topology; }
+	const Topology&	getTopology() const { return m_topology; }
+	// Activation row of a layer (row 0 holds the inputs).
+	T*				row(size_t layer) { return m_rows.data() + m_offsets[layer]; }
+	const T*		row(size_t layer) const { return m_rows.data() + m_offsets[layer]; }
+	size_t			getMemoryFootprint() const
+	{
+		return sizeof(*this) + m_rows.bytes() + m_offsets.capacity() * sizeof(size_t) + m_topology.capacity() * sizeof(size_t);
+	}
+
+private:
+	Topology				m_topology;
+	std::vector<size_t>		m_offsets;		// first element of each layer row in m_rows
+	GAlignedBuffer<T>		m_rows;
+};
+typedef GInferenceContextT<double> GInferenceContext;
+typedef GInferenceContextT<float> GInferenceContextF;
@@ -0,0 +1,171 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "GSimdKernels.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define G_TARGET_AVX512VNNI
+#else
+#define G_TARGET_AVX512VNNI	__attribute__((target("avx512f,avx512bw,avx512vnni,avx2,fma")))
+#endif
+
+/// <summary>
+/// Integer dot products of the int8 inference network (GQuantizedNet): unsigned 8-bit
+/// activations against signed 8-bit weights, accumulated in int32. Every level returns the
+/// exact integer sum, so a quantized network gives bit-identical outputs at any level.
+/// GSimd::Int8Kernels() returns the set of the active level.
+/// </summary>
+/// <remarks>
+/// pmaddubsw adds two u8 x s8 products into a saturating int16, which overflows for full
+/// range operands (255 * 127 * 2 > 32767). The SSE4.2 / AVX2 kernels therefore widen both
+/// operands to int16 and use pmaddwd; AVX512-VNNI (vpdpbusd) accumulates four products
+/// straight into int32 without saturation.
+/// </remarks>
+struct GInt8Kernels
+{
+	const char*		name;
+	// out[r] = sum(x[i] * w[r * stride + i]) over i < stride, for 'rows' consecutive weight rows.
+	void			(*dotRows)(const int8_t* w, size_t stride, const uint8_t* x, int32_t* out, size_t rows);
+};
+
+namespace GSimd
+{
+	namespace detail
+	{
+		inline int32_t dotInt8Scalar(const int8_t* w, const uint8_t* x, size_t n)
+		{
+			int32_t sum = 0;
+			for (size_t i = 0; i < n; ++i)
+				sum += int32_t(x[i]) * int32_t(w[i]);
+			return sum;
+		}
+		inline void dotRowsInt8Scalar(const int8_t* w, size_t stride, const uint8_t* x, int32_t* out, size_t rows)
+		{
+			for (size_t r = 0; r < rows; ++r)
+				out[r] = dotInt8Scalar(w + r * stride, x, stride);
+		}
+
+#ifdef G_SIMD_X86
+		G_TARGET_SSE42 inline int32_t dotInt8SSE42(const int8_t* w, const uint8_t* x, size_t n)
+		{
+			__m128i acc = _mm_setzero_si128();
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				const __m128i xi = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + i)));
+				const __m128i wi = _mm_cvtepi8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(w + i)));
+				acc = _mm_add_epi32(acc, _mm_madd_epi16(xi, wi));
+			}
+			acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+			acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+			return _mm_cvtsi128_si32(acc) + dotInt8Scalar(w + i, x + i, n - i);
+		}
+		G_TARGET_SSE42 inline void dotRowsInt8SSE42(const int8_t* w, size_t stride, const uint8_t* x, int32_t* out, size_t rows)
+		{
+			for (size_t r = 0; r < rows; ++r)
+				out[r] = dotInt8SSE42(w + r * stride, x, stride);
+		}
+
+		G_TARGET_AVX2 inline int32_t hsumInt32AVX2(__m256i v)
+		{
+			__m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+			s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+			s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+			return _mm_cvtsi128_si32(s);
+		}
+		G_TARGET_AVX2 inline int32_t dotInt8AVX2(const int8_t* w, const uint8_t* x, size_t n)
+		{
+			__m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+			size_t i = 0;
+			for (; i + 32 <= n; i += 32) {
+				const __m256i x0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+				const __m256i x1 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i + 16)));
+				const __m256i w0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i)));
+				const __m256i w1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i + 16)));
+				acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(x0, w0));
+				acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(x1, w1));
+			}
+			return hsumInt32AVX2(_mm256_add_epi32(acc0, acc1)) + dotInt8Scalar(w + i, x + i, n - i);
+		}
+		// Four rows share each load of x.
+		G_TARGET_AVX2 inline void dotRowsInt8AVX2(const int8_t* w, size_t stride, const uint8_t* x, int32_t* out, size_t rows)
+		{
+			size_t r = 0;
+			for (; r + 4 <= rows; r += 4) {
+				const int8_t* w0 = w + r * stride;
+				__m256i acc[4] = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+				size_t i = 0;
+				for (; i + 16 <= stride; i += 16) {
+					const __m256i xi = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+					for (size_t k = 0; k < 4; ++k) {
+						const __m256i wi = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w0 + k * stride + i)));
+						acc[k] = _mm256_add_epi32(acc[k], _mm256_madd_epi16(xi, wi));
+					}
+				}
+				for (size_t k = 0; k < 4; ++k)
+					out[r + k] = hsumInt32AVX2(acc[k]) + dotInt8Scalar(w0 + k * stride + i, x + i, stride - i);
+			}
+			for (; r < rows; ++r)
+				out[r] = dotInt8AVX2(w + r * stride, x, stride);
+		}
+
+		G_TARGET_AVX512VNNI inline void dotRowsInt8VNNI(const int8_t* w, size_t stride, const uint8_t* x, int32_t* out, size_t rows)
+		{
+			size_t r = 0;
+			for (; r + 4 <= rows; r += 4) {
+				const int8_t* w0 = w + r * stride;
+				__m512i acc[4] = { _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512() };
+				size_t i = 0;
+				for (; i + 64 <= stride; i += 64) {
+					const __m512i xi = _mm512_loadu_si512(x + i);
+					for (size_t k = 0; k < 4; ++k)
+						acc[k] = _mm512_dpbusd_epi32(acc[k], xi, _mm512_loadu_si512(w0 + k * stride + i));
+				}
+				for (size_t k = 0; k < 4; ++k)
+					out[r + k] = _mm512_reduce_add_epi32(acc[k]) + dotInt8Scalar(w0 + k * stride + i, x + i, stride - i);
+			}
+			for (; r < rows; ++r) {
+				const int8_t* wr = w + r * stride;
+				__m512i acc = _mm512_setzero_si512();
+				size_t i = 0;
+				for (; i + 64 <= stride; i += 64)
+					acc = _mm512_dpbusd_epi32(acc, _mm512_loadu_si512(x + i), _mm512_loadu_si512(wr + i));
+				out[r] = _mm512_reduce_add_epi32(acc) + dotInt8Scalar(wr + i, x + i, stride - i);
+			}
+		}
+
+		inline bool hasAVX512VNNI()
+		{
+			static const bool vnni = [] {
+				unsigned r[4];
+				cpuid(0, 0, r);
+				if (r[0] < 7)
+					return false;
+				cpuid(7, 0, r);
+				return ((r[1] >> 30) & 1) != 0 && ((r[2] >> 11) & 1) != 0;		// AVX512BW, AVX512_VNNI
+			}();
+			return vnni;
+		}
+#endif // G_SIMD_X86
+
+		inline const GInt8Kernels& int8Table(ENUM_SIMD_LEVEL level)
+		{
+			static const GInt8Kernels tables[] = {
+				{ "scalar", dotRowsInt8Scalar },
+#ifdef G_SIMD_X86
+				{ "sse4.2", dotRowsInt8SSE42 },
+				{ "avx2", dotRowsInt8AVX2 },
+				{ "avx512vnni", dotRowsInt8VNNI },
+#endif
+			};
+#ifdef G_SIMD_X86
+			// Without VNNI, AVX-512F has no byte/word arithmetic; the AVX2 kernel is used.
+			if (level == SIMD_AVX512)
+				return tables[hasAVX512VNNI() ? 3 : 2];
+#endif
+			return tables[level];
+		}
+	}
+
+	// Int8 kernels of the active level. Cheap enough to call once per pass.
+	inline const GInt8Kernels& Int8Kernels() { return detail::int8Table(ActiveLevel()); }
+}
@@ -0,0 +1,202 @@
+#pragma once
+#include <cstddef>
+#include <cassert>
+#include <tuple>
+#include "GAlignedBuffer.h"
+#include "GHalf.h"
+#include "GTypes.h"
+
+/// <summary>
+/// Dense storage for one layer of the CPU backend, in double (GLayerMatrix) or float.
+/// Instead of a vector of GNeuron objects each owning a vector of GNeuralConnection,
+/// the layer keeps one row-major weight matrix [neurons x stride] where row n holds the
+/// input weights of neuron n (the last used column is the bias weight), plus separate
+/// aligned arrays for outputs, gradients, momentum deltas and optimizer moments.
+/// The moments are only allocated for the optimizers that use them (see reserveMoments).
+/// A bfloat16 or IEEE half copy of the weights, same layout, can be kept for the forward
+/// pass; the T weights then act as the master copy that the optimizer updates.
+/// </summary>
+/// <remarks>
+/// The output array carries the bias neuron (constant 1.0) after the real neurons and is
+/// zero padded up to the stride of the next layer, so a weight row and the previous layer's
+/// outputs can always be multiplied over the full padded width.
+/// </remarks>
+template<typename T>
+class GLayerMatrixT
+{
+public:
+					GLayerMatrixT() : m_numNeurons(0), m_numInputs(0), m_stride(0), m_batchCapacity(0) {}
+	// numInputs is the size of the previous layer without its bias neuron (0 for the input layer).
+					GLayerMatrixT(size_t numNeurons, size_t numInputs)
+						: m_numNeurons(numNeurons), m_numInputs(numInputs),
+						  m_stride(numInputs ? GPaddedCount<T>(numInputs + 1) : 0), m_batchCapacity(0)
+	{
+		m_outputs.resize(GPaddedCount<T>(numNeurons + 1));
+		m_outputs[numNeurons] = T(1);	// bias neuron
+		m_gradients.resize(GPaddedCount<T>(numNeurons + 1));
+		if (numInputs) {
+			m_weights.resize(numNeurons * m_stride);
+			m_deltaWeights.resize(numNeurons * m_stride);
+		}
+	}
+
+	// Number of real neurons (the bias neuron is not counted).
+	size_t			getNeuronCount() const { return m_numNeurons; }
+	// Number of inputs per neuron, excluding the bias input.
+	size_t			getInputCount() const { return m_numInputs; }
+	// Distance in elements between two consecutive weight rows.
+	size_t			getStride() const { return m_stride; }
+	// Length of one output/gradient row (neurons + bias, padded); equals the next layer's stride.
+	size_t			getOutputStride() const { return m_outputs.size(); }
+	// Number of used columns in a weight row (inputs + bias); 0 for the input layer.
+	size_t			getRowLength() const { return m_numInputs ? m_numInputs + 1 : 0; }
+
+	T*				weightRow(size_t neuron) { return m_weights.data() + neuron * m_stride; }
+	const T*		weightRow(size_t neuron) const { return m_weights.data() + neuron * m_stride; }
+	T&				weight(size_t neuron, size_t input) { return m_weights[neuron * m_stride + input]; }
+	T				weight(size_t neuron, size_t input) const { return m_weights[neuron * m_stride + input]; }
+	T&				deltaWeight(size_t neuron, size_t input) { return m_deltaWeights[neuron * m_stride + input]; }
+	T				deltaWeight(size_t neuron, size_t input) const { return m_deltaWeights[neuron * m_stride + input]; }
+
+	GAlignedBuffer<T>&				weights() { return m_weights; }
+	const GAlignedBuffer<T>&		weights() const { return m_weights; }
+	GAlignedBuffer<T>&				deltaWeights() { return m_deltaWeights; }
+	GAlignedBuffer<T>&				firstMoments() { return m_mt; }
+	GAlignedBuffer<T>&				secondMoments() { return m_vt; }
+	T*				firstMomentRow(size_t neuron) { return m_mt.data() + neuron * m_stride; }
+	T*				secondMomentRow(size_t neuron) { return m_vt.data() + neuron * m_stride; }
+	// Allocates the moments an optimizer needs (zeroed) and frees the ones it does not.
+	void			reserveMoments(bool first, bool second)
+	{
+		if (!first) m_mt.release();
+		else if (m_mt.size() != m_weights.size()) m_mt.resize(m_weights.size());
+		if (!second) m_vt.release();
+		else if (m_vt.size() != m_weights.size()) m_vt.resize(m_weights.size());
+	}
+	// 16-bit copy of the weights (S = GBFloat16 or GFloat16), empty unless the network uses it.
+	template<typename S>
+	GAlignedBuffer<S>&				compactWeights() { return std::get<GAlignedBuffer<S>>(m_compactWeights); }
+	template<typename S>
+	const S*		compactRow(size_t neuron) const { return std::get<GAlignedBuffer<S>>(m_compactWeights).data() + neuron * m_stride; }
+	template<typename S>
+	S*				compactRow(size_t neuron) { return compactWeights<S>().data() + neuron * m_stride; }
+	// Frees the master weights and everything only training needs; the layer then runs
+	// forward from its 16-bit copy alone.
+	void			releaseMasterWeights()
+	{
+		m_weights.release();
+		m_deltaWeights.release();
+		m_mt.release();
+		m_vt.release();
+		m_weightGradients.release();
+	}
+	GAlignedBuffer<T>&				outputs() { return m_outputs; }
+	const GAlignedBuffer<T>&		outputs() const { return m_outputs; }
+	GAlignedBuffer<T>&				gradients() { return m_gradients; }
+	const GAlignedBuffer<T>&		gradients() const { return m_gradients; }
+
+	// --- Mini-batch storage, allocated on first use ---
+	// Makes room for batchSize rows of outputs/gradients; each output row gets its bias column.
+	void			reserveBatch(size_t batchSize)
+	{
+		if (batchSize <= m_batchCapacity)
+			return;
+		const size_t rowLength = getOutputStride();
+		m_batchOutputs.resize(batchSize * rowLength);
+		m_batchGradients.resize(batchSize * rowLength);
+		for (size_t b = 0; b < batchSize; ++b)
+			m_batchOutputs[b * rowLength + m_numNeurons] = T(1);
+		if (m_numInputs && m_weightGradients.empty())
+			m_weightGradients.resize(m_weights.size());
+		m_batchCapacity = batchSize;
+	}
+	size_t			getBatchCapacity() const { return m_batchCapacity; }
+	T*				batchOutputRow(size_t b) { return m_batchOutputs.data() + b * getOutputStride(); }
+	const T*		batchOutputRow(size_t b) const { return m_batchOutputs.data() + b * getOutputStride(); }
+	T*				batchGradientRow(size_t b) { return m_batchGradients.data() + b * getOutputStride(); }
+	const T*		batchGradientRow(size_t b) const { return m_batchGradients.data() + b * getOutputStride(); }
+	// Gradient sums over a batch, same [neurons x stride] layout as the weights.
+	GAlignedBuffer<T>&				weightGradients() { return m_weightGradients; }
+	T*				weightGradientRow(size_t neuron) { return m_weightGradients.data() + neuron * m_stride; }
+
+	// Bytes held by this layer, used to compare against the object-per-connection layout.
+	size_t			getMemoryFootprint() const
+	{
+		return sizeof(*this) + m_weights.bytes() + m_deltaWeights.bytes() + m_mt.bytes() + m_vt.bytes()
+			+ m_outputs.bytes() + m_gradients.bytes()
+			+ m_batchOutputs.bytes() + m_batchGradients.bytes() + m_weightGradients.bytes()
+			+ std::get<0>(m_compactWeights).bytes() + std::get<1>(m_compactWeights).bytes();
+	}
+
+private:
+	size_t					m_numNeurons;
+	size_t					m_numInputs;
+	size_t					m_stride;
+
+	GAlignedBuffer<T>		m_weights;			// [neurons x stride], row = input weights of one neuron
+	GAlignedBuffer<T>		m_deltaWeights;		// previous update, for momentum
+	GAlignedBuffer<T>		m_mt;				// Adam first moment, empty unless used
+	GAlignedBuffer<T>		m_vt;				// Adam/RMSProp second moment, empty unless used
+	GAlignedBuffer<T>		m_outputs;			// neurons + bias, padded
+	GAlignedBuffer<T>		m_gradients;		// neurons + bias, padded
+	std::tuple<GAlignedBuffer<GBFloat16>, GAlignedBuffer<GFloat16>> m_compactWeights;	// [neurons x stride]
+
+	size_t					m_batchCapacity;
+	GAlignedBuffer<T>		m_batchOutputs;		// [batch x outputStride]
+	GAlignedBuffer<T>		m_batchGradients;	// [batch x outputStride]
+	GAlignedBuffer<T>		m_weightGradients;	// [neurons x stride], summed over the batch
+};
+typedef GLayerMatrixT<double> GLayerMatrix;
+
+/// <summary>
+/// Lightweight stand-in for a GNeuralConnection stored inside a GLayerMatrix.
+/// It refers to the weight from one neuron to one neuron of the next layer.
+/// </summary>
+template<typename T>
+class GConnectionViewT
+{
+public:
+					GConnectionViewT(GLayerMatrixT<T>& nextLayer, size_t toNeuron, size_t fromNeuron)
+						: m_layer(&nextLayer), m_to(toNeuron), m_from(fromNeuron) {}
+
+	double			getWeight(void) const { return m_layer->weight(m_to, m_from); }
+	double			getDeltaWeight(void) const { return m_layer->deltaWeight(m_to, m_from); }
+	void			setConnectionWeight(double weight) { m_layer->weight(m_to, m_from) = T(weight); }
+	void			setDeltaWeight(double delta) { m_layer->deltaWeight(m_to, m_from) = T(delta); }
+
+private:
+	GLayerMatrixT<T>*	m_layer;
+	size_t			m_to;
+	size_t			m_from;
+};
+typedef GConnectionViewT<double> GConnectionView;
+
+/// <summary>
+/// Lightweight stand-in for a GNeuron stored inside a GLayerMatrix.
+/// getConnection(i) follows the GNeuron convention: it is the output weight from this
+/// neuron to neuron i of the next layer.
+/// </summary>
+template<typename T>
+class GNeuronViewT
+{
+public:
+					GNeuronViewT(GLayerMatrixT<T>& layer, GLayerMatrixT<T>* nextLayer, size_t myIndex)
+						: m_layer(&layer), m_next(nextLayer), m_myIndex(myIndex) {}
+
+	double			getOutputVal(void) const { return m_layer->outputs()[m_myIndex]; }
+	void			setOutputVal(double val) { m_layer->outputs()[m_myIndex] = T(val); }
+	double			getGradient(void) const { return m_layer->gradients()[m_myIndex]; }
+	size_t			getConnectionCount(void) const { return m_next ? m_next->getNeuronCount() : 0; }
+	// Output-layer neurons have no connections (getConnectionCount() == 0).
+	GConnectionViewT<T> getConnection(size_t index) const
+	{
+		assert(m_next != nullptr && index < m_next->getNeuronCount());
+		return GConnectionViewT<T>(*m_next, index, m_myIndex);
+	}
+
+private:
+	GLayerMatrixT<T>*	m_layer;
+	GLayerMatrixT<T>*	m_next;
+	size_t			m_myIndex;
+};
+typedef GNeuronViewT<double> GNeuronView;
@@ -0,0 +1,232 @@
+#pragma once
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include "GTypes.h"
+#include "GSpan.h"
+#include "GDataset.h"
+#include "GAlignedBuffer.h"
+#include "GMappedFile.h"
+#include "GFileIO.h"
+#include "constants.h"
+
+/// <summary>
+/// Header of a binary dataset file (.gdc). The file is columnar: the [rows x inputCount]
+/// input matrix and the [rows x outputCount] target matrix are each stored contiguously,
+/// row-major, at 64-byte aligned offsets, so a memory mapping of the file is directly a
+/// GDatasetView.
+/// </summary>
+struct GDatasetFileHeader
+{
+	int32_t			type;			// defDatasetCache
+	int32_t			version;		// 1
+	int32_t			dtype;			// ENUM_SCALAR_TYPE of both matrices; SCALAR_FP64 is the only one written
+	int32_t			reserved;
+	uint64_t		rows;
+	uint64_t		inputCount;
+	uint64_t		outputCount;
+	uint64_t		inputOffset;	// byte offset of the input matrix
+	uint64_t		targetOffset;	// byte offset of the target matrix
+	uint64_t		padding;		// header is one cache line
+
+	static constexpr int32_t currentVersion = 1;
+
+	static uint64_t	alignUp(uint64_t bytes) { return (bytes + G_CACHE_LINE - 1) / G_CACHE_LINE * G_CACHE_LINE; }
+	// Header of an fp64 file with the sections right after it.
+	static GDatasetFileHeader make(uint64_t rows, uint64_t inputCount, uint64_t outputCount)
+	{
+		GDatasetFileHeader header = {};
+		header.type = defDatasetCache;
+		header.version = currentVersion;
+		header.dtype = SCALAR_FP64;
+		header.rows = rows;
+		header.inputCount = inputCount;
+		header.outputCount = outputCount;
+		header.inputOffset = alignUp(sizeof(GDatasetFileHeader));
+		header.targetOffset = alignUp(header.inputOffset + rows * inputCount * sizeof(double));
+		return header;
+	}
+	// Size of the file the header describes; only meaningful once valid() has accepted it.
+	uint64_t		fileBytes() const { return targetOffset + rows * outputCount * sizeof(double); }
+	// True if count items of itemBytes each fit between offset and limit, without overflowing.
+	static bool		fits(uint64_t offset, uint64_t count, uint64_t itemBytes, uint64_t limit)
+	{
+		return offset <= limit && (itemBytes == 0 || count <= (limit - offset) / itemBytes);
+	}
+	// True if the header describes an fp64 dataset whose sections fit in fileSize bytes, the
+	// target section after the input section. Every size is bounded by fileSize before it is
+	// multiplied, so a crafted header cannot wrap the offsets around.
+	bool			valid(uint64_t fileSize) const
+	{
+		if (type != defDatasetCache || version != currentVersion || dtype != SCALAR_FP64 || inputCount == 0
+			|| inputOffset % G_CACHE_LINE != 0 || targetOffset % G_CACHE_LINE != 0 || inputOffset < sizeof(GDatasetFileHeader)
+			|| inputCount > fileSize / sizeof(double) || outputCount > fileSize / sizeof(double)
+			|| !fits(inputOffset, rows, inputCount * sizeof(double), fileSize))
+			return false;
+		const uint64_t inputEnd = inputOffset + rows * inputCount * sizeof(double);
+		return targetOffset >= inputEnd && fits(targetOffset, rows, outputCount * sizeof(double), fileSize);
+	}
+};
+static_assert(sizeof(GDatasetFileHeader) == G_CACHE_LINE, "dataset header must be one cache line");
+
+/// <summary>
+/// Writes a dataset file sample by sample, for datasets that do not fit in memory. Inputs
+/// go straight to the file, targets to a side file appended at close(), when the row count
+/// and so the offset of the target section are known.
+/// </summary>
+class GDatasetFileWriter
+{
+public:
+					GDatasetFileWriter() {}
+					~GDatasetFileWriter() { if (m_inputs.is_open()) close(); }
+					GDatasetFileWriter(const GDatasetFileWriter&) = delete;
+	GDatasetFileWriter& operator=(const GDatasetFileWriter&) = delete;
+
+	bool			open(const std::string& file_name, size_t inputCount, size_t outputCount)
+	{
+		m_fileName = file_name;
+		m_inputCount = inputCount;
+		m_outputCount = outputCount;
+		m_rows = 0;
+		m_inputs.open(file_name, std::ios::binary | std::ios::trunc);
+		m_targets.open(targetsFile(), std::ios::binary | std::ios::trunc);
+		if (!m_inputs.is_open() || !m_targets.is_open()) {
+			std::cerr << "Error: Could not open file " << file_name << " for writing." << std::endl;
+			return false;
+		}
+		const GDatasetFileHeader header = GDatasetFileHeader::make(0, inputCount, outputCount);
+		writePadded(m_inputs, &header, sizeof(header));
+		return true;
+	}
+	void			addSample(GSpan<const double> inputs, GSpan<const double> targets)
+	{
+		m_inputs.write(reinterpret_cast<const char*>(inputs.data()), std::streamsize(m_inputCount * sizeof(double)));
+		m_targets.write(reinterpret_cast<const char*>(targets.data()), std::streamsize(m_outputCount * sizeof(double)));
+		++m_rows;
+	}
+	// Appends the target section and writes the final header.
+	bool			close()
+	{
+		const GDatasetFileHeader header = GDatasetFileHeader::make(m_rows, m_inputCount, m_outputCount);
+		m_targets.close();
+		bool ok = !m_targets.fail();
+		writePadded(m_inputs, nullptr, 0);
+		{
+			std::ifstream targets(targetsFile(), std::ios::binary);
+			if (m_rows > 0 && m_outputCount > 0)
+				m_inputs << targets.rdbuf();
+		}
+		std::remove(targetsFile().c_str());
+		m_inputs.seekp(0);
+		m_inputs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		m_inputs.close();
+		ok = ok && !m_inputs.fail();
+		if (!ok)
+			std::cerr << "Error: Failed to write " << m_fileName << "." << std::endl;
+		return ok;
+	}
+	size_t			size() const { return m_rows; }
+
+	// Writes bytes, then zeros up to the next 64-byte boundary of the file.
+	static void		writePadded(std::ofstream& out, const void* bytes, size_t count)
+	{
+		static const char zeros[G_CACHE_LINE] = {};
+		if (count)
+			out.write(static_cast<const char*>(bytes), std::streamsize(count));
+		const uint64_t position = uint64_t(out.tellp());
+		out.write(zeros, std::streamsize(GDatasetFileHeader::alignUp(position) - position));
+	}
+
+private:
+	std::string		targetsFile() const { return m_fileName + ".targets"; }
+
+	std::string		m_fileName;
+	std::ofstream	m_inputs;
+	std::ofstream	m_targets;
+	size_t			m_inputCount = 0;
+	size_t			m_outputCount = 0;
+	size_t			m_rows = 0;
+};
+
+/// <summary>
+/// Read-only memory mapping of a dataset file, for out-of-core training: view() points into
+/// the mapping, so the trainer reads its batches straight from the page cache with no load
+/// phase, and the operating system pages the rows in and out as the epoch goes. The access
+/// hint follows the trainer's shuffle mode: sequential read-ahead for in-order epochs,
+/// random access (no read-ahead) for shuffled ones, whose GBatchLoader gathers the rows.
+/// </summary>
+/// <remarks>
+/// The mapping is a GMappedFile (mmap + madvise, or MapViewOfFile with the matching
+/// FILE_FLAG hint on Windows). The view works with every InterfaceGNeuralNet backend through
+/// GTrainer::Run, and with the batch API of GNeuralNetMatrix, since both take plain row pointers.
+/// </remarks>
+class GMappedDataset
+{
+public:
+					GMappedDataset() {}
+
+	// Maps a dataset file; randomAccess selects the hint for shuffled training.
+	bool			open(const std::string& file_name, bool randomAccess = false)
+	{
+		close();
+		if (!m_file.open(file_name, randomAccess))
+			return false;
+		if (m_file.size() >= sizeof(GDatasetFileHeader))
+			m_header = *reinterpret_cast<const GDatasetFileHeader*>(m_file.data());
+		if (!m_header.valid(m_file.size())) {
+			std::cerr << "Error: " << file_name << " is not a dataset file." << std::endl;
+			close();
+			return false;
+		}
+		return true;
+	}
+	void			close() { m_file.close(); m_header = GDatasetFileHeader(); }
+	// Changes the access hint of an open mapping (POSIX only).
+	void			advise(bool randomAccess) { m_file.advise(randomAccess); }
+	bool			isOpen() const { return m_file.isOpen(); }
+
+	size_t			size() const { return size_t(m_header.rows); }
+	size_t			getInputCount() const { return size_t(m_header.inputCount); }
+	size_t			getOutputCount() const { return size_t(m_header.outputCount); }
+	GDatasetView	view() const
+	{
+		GDatasetView v;
+		if (!isOpen())
+			return v;
+		v.inputs = reinterpret_cast<const double*>(m_file.data() + m_header.inputOffset);
+		v.targets = reinterpret_cast<const double*>(m_file.data() + m_header.targetOffset);
+		v.samples = size();
+		v.inputCount = getInputCount();
+		v.outputCount = getOutputCount();
+		return v;
+	}
+
+	// Writes an in-memory dataset as a dataset file, one write per section.
+	static bool		Write(const std::string& file_name, const GDatasetView& data)
+	{
+		GFile outFile;
+		if (!outFile.open(file_name, true))
+			return false;
+		static const char zeros[G_CACHE_LINE] = {};
+		const GDatasetFileHeader header = GDatasetFileHeader::make(data.samples, data.inputCount, data.outputCount);
+		const size_t inputCount = data.samples * data.inputCount;
+		const size_t padding = size_t(header.targetOffset - header.inputOffset) - inputCount * sizeof(double);
+		bool ok = WriteBytes(outFile.handle(), &header, sizeof(header))
+			&& WriteBytes(outFile.handle(), zeros, size_t(header.inputOffset) - sizeof(header))
+			&& WriteDoubles(outFile.handle(), GSpan<const double>(data.inputs, inputCount))
+			&& WriteBytes(outFile.handle(), zeros, padding)
+			&& WriteDoubles(outFile.handle(), GSpan<const double>(data.targets, data.samples * data.outputCount));
+		ok = outFile.close() && ok;
+		if (!ok) {
+			std::cerr << "Error: Failed to write " << file_name << "." << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+private:
+	GMappedFile				m_file;
+	GDatasetFileHeader		m_header = {};
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include <string>
+#include <iostream>
+#include <cstddef>
+
+#if defined(_WIN32)
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+/// <summary>
+/// Read-only memory mapping of a whole file. The pages come from the page cache on first
+/// touch and are shared by every process that maps the same file.
+/// </summary>
+/// <remarks>
+/// POSIX uses mmap and madvise(MADV_SEQUENTIAL / MADV_RANDOM); Windows maps the file with
+/// MapViewOfFile and passes FILE_FLAG_SEQUENTIAL_SCAN / FILE_FLAG_RANDOM_ACCESS when opening
+/// it, so there the access hint is fixed by open().
+/// </remarks>
+class GMappedFile
+{
+public:
+					GMappedFile() {}
+					~GMappedFile() { close(); }
+					GMappedFile(const GMappedFile&) = delete;
+	GMappedFile&	operator=(const GMappedFile&) = delete;
+
+	// Maps file_name; randomAccess disables read-ahead. Empty files cannot be mapped.
+	bool			open(const std::string& file_name, bool randomAccess = false);
+	void			close();
+	// Changes the access hint of the mapping (POSIX only).
+	void			advise(bool randomAccess);
+	bool			isOpen() const { return m_base != nullptr; }
+	const unsigned char* data() const { return m_base; }
+	size_t			size() const { return m_bytes; }
+
+private:
+	const unsigned char*	m_base = nullptr;
+	size_t					m_bytes = 0;
+#if defined(_WIN32)
+	HANDLE					m_file = INVALID_HANDLE_VALUE;
+	HANDLE					m_mapping = nullptr;
+#else
+	int						m_fd = -1;
+#endif
+};
+
+inline bool GMappedFile::open(const std::string& file_name, bool randomAccess)
+{
+	close();
+#if defined(_WIN32)
+	m_file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		randomAccess ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER fileSize = {};
+	if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &fileSize)) {
+		std::cerr << "Error: Could not open file " << file_name << " for reading." << std::endl;
+		close();
+		return false;
+	}
+	m_bytes = size_t(fileSize.QuadPart);
+	if (m_bytes > 0) {
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping)
+			m_base = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+#else
+	m_fd = ::open(file_name.c_str(), O_RDONLY);
+	struct stat status;
+	if (m_fd < 0 || fstat(m_fd, &status) != 0) {
+		std::cerr << "Error: Could not open file " << file_name << " for reading." << std::endl;
+		close();
+		return false;
+	}
+	m_bytes = size_t(status.st_size);
+	if (m_bytes > 0) {
+		void* base = mmap(nullptr, m_bytes, PROT_READ, MAP_SHARED, m_fd, 0);
+		if (base != MAP_FAILED)
+			m_base = static_cast<const unsigned char*>(base);
+	}
+#endif
+	if (!m_base) {
+		std::cerr << "Error: Could not map " << file_name << "." << std::endl;
+		close();
+		return false;
+	}
+	advise(randomAccess);
+	return true;
+}
+
+inline void GMappedFile::advise(bool randomAccess)
+{
+#if defined(_WIN32)
+	(void)randomAccess;		// fixed by the CreateFile flags
+#else
+	if (m_base)
+		madvise(const_cast<unsigned char*>(m_base), m_bytes, randomAccess ? MADV_RANDOM : MADV_SEQUENTIAL);
+#endif
+}
+
+inline void GMappedFile::close()
+{
+#if defined(_WIN32)
+	if (m_base)
+		UnmapViewOfFile(m_base);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_base)
+		munmap(const_cast<unsigned char*>(m_base), m_bytes);
+	if (m_fd >= 0)
+		::close(m_fd);
+	m_fd = -1;
+#endif
+	m_base = nullptr;
+	m_bytes = 0;
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <type_traits>
+#include <algorithm>
+#include "GTypes.h"
+#include "GAlignedBuffer.h"
+#include "GSpan.h"
+#include "GFileIO.h"
+#include "constants.h"
+
+/// <summary>
+/// Header of a version 2 network file (.nnw v2). It is backend neutral: only the topology,
+/// the activation, output layer and weight dtype, followed by one weight section per layer.
+/// </summary>
+/// <remarks>
+/// Layout: this 64-byte header, uint64_t topology[layers], uint64_t sections[layers - 1] (byte
+/// offset of the weight section of layers 1..L-1), zero padding to 64 bytes, then the weight
+/// sections. A section is the [neurons x stride] matrix of its layer in the file dtype, laid
+/// out like GLayerMatrix rows: the inputs' weights, the bias weight, then zeros up to
+/// stride = GPaddedCount(inputs + 1). Every section starts on a 64-byte boundary, so an
+/// inference network can memory-map the file and read the weights in place
+/// (GFrozenNetT::load). Version 1 files (defNetMatrix: per-neuron rows of doubles, no
+/// padding) are still read by GNeuralNetMatrixT::loadNetwork.
+/// </remarks>
+struct GNetworkFileHeader
+{
+	int32_t			magic;			// defNetFileV2
+	int32_t			version;		// 2
+	int32_t			dtype;			// ENUM_SCALAR_TYPE of the weights
+	int32_t			activation;		// ENUM_ACTIVATION of the hidden layers (and of the output layer)
+	int32_t			precision;		// ENUM_ACTIVATION_PRECISION
+	int32_t			outputLayer;	// ENUM_OUTPUT_LAYER
+	uint64_t		layers;
+	uint64_t		topologyOffset;	// byte offset of topology[]
+	uint64_t		sectionsOffset;	// byte offset of sections[]
+	uint64_t		fileBytes;		// size of the whole file
+	uint64_t		reserved;
+
+	static constexpr int32_t currentVersion = 2;
+};
+static_assert(sizeof(GNetworkFileHeader) == G_CACHE_LINE, "network file header must be one cache line");
+
+namespace GNetworkFile
+{
+	template<typename T>
+	constexpr ENUM_SCALAR_TYPE ScalarTypeOf() { return std::is_same<T, float>::value ? SCALAR_FP32 : SCALAR_FP64; }
+
+	inline size_t	ScalarSize(int32_t dtype) { return dtype == SCALAR_FP32 ? sizeof(float) : sizeof(double); }
+
+	// Padded row length of a layer with 'inputs' inputs (bias excluded) in a file of dtype.
+	inline size_t	Stride(int32_t dtype, size_t inputs)
+	{
+		return dtype == SCALAR_FP32 ? GPaddedCount<float>(inputs + 1) : GPaddedCount<double>(inputs + 1);
+	}
+
+	inline uint64_t	AlignUp(uint64_t bytes) { return (bytes + G_CACHE_LINE - 1) / G_CACHE_LINE * G_CACHE_LINE; }
+
+	/// <summary>
+	/// Header and section offsets of a file holding 'topology' in dtype.
+	/// </summary>
+	inline GNetworkFileHeader Layout(const Topology& topology, int32_t dtype, std::vector<uint64_t>& sections)
+	{
+		GNetworkFileHeader header = {};
+		header.magic = defNetFileV2;
+		header.version = GNetworkFileHeader::currentVersion;
+		header.dtype = dtype;
+		header.layers = topology.size();
+		header.topologyOffset = sizeof(GNetworkFileHeader);
+		header.sectionsOffset = header.topologyOffset + topology.size() * sizeof(uint64_t);
+		uint64_t offset = AlignUp(header.sectionsOffset + (topology.size() - 1) * sizeof(uint64_t));
+		sections.clear();
+		for (size_t l = 1; l < topology.size(); ++l) {
+			sections.push_back(offset);
+			offset = AlignUp(offset + topology[l] * Stride(dtype, topology[l - 1]) * ScalarSize(dtype));
+		}
+		header.fileBytes = offset;
+		return header;
+	}
+
+	// True if count items of itemBytes bytes starting at offset end within limit bytes, without
+	// overflowing: every term is checked against limit before it is added or multiplied.
+	inline bool		Fits(uint64_t offset, uint64_t count, uint64_t itemBytes, uint64_t limit)
+	{
+		return offset <= limit && count <= (limit - offset) / itemBytes;
+	}
+
+	/// <summary>
+	/// Checks a header read from a file of fileBytes bytes and reads its topology and section
+	/// offsets from 'bytes' (the whole file, or at least everything before the first section).
+	/// </summary>
+	/// <remarks>
+	/// Every field comes from the file, so none is trusted in arithmetic before it has been
+	/// bounded by the file size: a crafted header must fail here, not wrap into a small bound.
+	/// </remarks>
+	inline bool		Parse(const GNetworkFileHeader& header, const unsigned char* bytes, uint64_t available, uint64_t fileBytes,
+						Topology& topology, std::vector<uint64_t>& sections)
+	{
+		if (header.magic != defNetFileV2 || header.version != GNetworkFileHeader::currentVersion
+			|| (header.dtype != SCALAR_FP64 && header.dtype != SCALAR_FP32) || header.layers < 2 || header.layers > 4096
+			|| header.topologyOffset < sizeof(GNetworkFileHeader) || header.sectionsOffset < sizeof(GNetworkFileHeader)
+			|| header.topologyOffset % sizeof(uint64_t) != 0 || header.sectionsOffset % sizeof(uint64_t) != 0
+			|| available > fileBytes || header.fileBytes > fileBytes
+			|| !Fits(header.topologyOffset, header.layers, sizeof(uint64_t), available)
+			|| !Fits(header.sectionsOffset, header.layers - 1, sizeof(uint64_t), available))
+			return false;
+		const uint64_t* stored = reinterpret_cast<const uint64_t*>(bytes + header.topologyOffset);
+		topology.assign(stored, stored + header.layers);
+		const uint64_t* offsets = reinterpret_cast<const uint64_t*>(bytes + header.sectionsOffset);
+		sections.assign(offsets, offsets + header.layers - 1);
+		const size_t scalarSize = ScalarSize(header.dtype);
+		for (size_t l = 1; l < topology.size(); ++l) {
+			// Each of the topology[l] rows holds topology[l - 1] weights, so a layer fed by more
+			// inputs than the file has scalars cannot fit; past this, the stride cannot wrap.
+			if (topology[l - 1] == 0 || topology[l - 1] >= fileBytes / scalarSize || topology[l] == 0)
+				return false;
+			const uint64_t rowBytes = Stride(header.dtype, size_t(topology[l - 1])) * scalarSize;
+			if (sections[l - 1] % G_CACHE_LINE != 0 || !Fits(sections[l - 1], topology[l], rowBytes, fileBytes))
+				return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Reads the header, topology and section offsets of a v2 file.
+	/// </summary>
+	inline bool		ReadHeader(const GFile& inFile, GNetworkFileHeader& header, Topology& topology, std::vector<uint64_t>& sections)
+	{
+		const uint64_t fileBytes = inFile.size();
+		if (!ReadBytesAt(inFile.handle(), &header, sizeof(header), 0) || header.magic != defNetFileV2 || header.layers < 2 || header.layers > 4096
+			|| !Fits(header.topologyOffset, header.layers, sizeof(uint64_t), fileBytes)
+			|| !Fits(header.sectionsOffset, header.layers - 1, sizeof(uint64_t), fileBytes))
+			return false;
+		// Both arrays end within the file, so neither sum below can wrap.
+		const uint64_t prefixBytes = std::max(header.sectionsOffset + (header.layers - 1) * sizeof(uint64_t),
+			header.topologyOffset + header.layers * sizeof(uint64_t));
+		if (prefixBytes < sizeof(header) || prefixBytes > size_t(-1))
+			return false;
+		std::vector<unsigned char> prefix(static_cast<size_t>(prefixBytes));
+		return ReadBytesAt(inFile.handle(), prefix.data(), prefix.size(), 0)
+			&& Parse(header, prefix.data(), prefix.size(), fileBytes, topology, sections);
+	}
+
+	/// <summary>
+	/// Writes the header of a version 1 (defNetMatrix) file in one call: type, layer count,
+	/// topology and activation. The per-layer rows of doubles follow it.
+	/// </summary>
+	inline bool		WriteVersion1Header(GFileHandle file, GSpan<const size_t> topology, int activation)
+	{
+		const int type = defNetMatrix;
+		const size_t layers = topology.size();
+		std::string header;
+		header.reserve(sizeof(type) + sizeof(layers) + layers * sizeof(size_t) + sizeof(activation));
+		header.append(reinterpret_cast<const char*>(&type), sizeof(type));
+		header.append(reinterpret_cast<const char*>(&layers), sizeof(layers));
+		header.append(reinterpret_cast<const char*>(topology.data()), layers * sizeof(size_t));
+		header.append(reinterpret_cast<const char*>(&activation), sizeof(activation));
+		return WriteBytes(file, header.data(), header.size());
+	}
+
+	// True if the file starts with the v2 magic.
+	inline bool		IsVersion2(const std::string& file_name)
+	{
+		std::ifstream inFile(file_name, std::ios::binary);
+		int32_t magic = 0;
+		inFile.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+		return inFile && magic == defNetFileV2;
+	}
+}
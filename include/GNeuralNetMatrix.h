@@ -0,0 +1,998 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cstdlib>
+#include <cassert>
+#include <memory>
+#include <algorithm>
+#include "constants.h"
+#include "GTypes.h"
+#include "GLayerMatrix.h"
+#include "GSimdKernels.h"
+#include "GGemm.h"
+#include "GHalfKernels.h"
+#include "GThreadPool.h"
+#include "GTrainingContext.h"
+#include "GInferenceContext.h"
+#include "GFrozenNet.h"
+#include "GFileIO.h"
+#include "InterfaceGNeuralNet.h"
+#include "GTrainer.h"
+
+/// <summary>
+/// CPU network that keeps every layer as a contiguous, aligned, row-major weight matrix
+/// (see GLayerMatrix) instead of vector&lt;GNeuron&gt; holding vector&lt;GNeuralConnection&gt;.
+/// It trains exactly like GNeuralNet (bias neuron per layer, eta/alpha momentum update,
+/// smoothed recent average error) and exposes GNeuron-like views for compatibility.
+/// The row loops run through the runtime-dispatched kernels of GSimdKernels.h and, once
+/// SetThreadCount() is above 1, each layer large enough to pay for it is split by neurons
+/// (or by gradient columns) across a thread pool owned by the network. In PARALLEL_DATA mode
+/// the batch methods instead give every thread a shard of the mini-batch and a private
+/// gradient buffer, tree-reduce the buffers and apply a single weight update. In
+/// PARALLEL_HOGWILD mode backPropagateBatch() runs per-sample SGD on every thread at once:
+/// each thread has its own activation/gradient scratch and writes the shared weights
+/// without locks (Hogwild!). Those races are deliberate; concurrent updates to the same
+/// weight may overwrite each other, which SGD tolerates.
+/// Besides eta/alpha momentum, the update runs fused SIMD Adam, AdamW, RMSProp and Nesterov
+/// kernels (SetOptimizer); their moments are only allocated while that optimizer is selected.
+/// T is the storage and compute type: GNeuralNetMatrix (double) or GNeuralNetMatrixF (float,
+/// half the memory traffic and twice the SIMD lanes). The public interface stays double;
+/// inputs, targets and results are converted at the boundary, and the files hold doubles.
+/// SetWeightStorage(STORAGE_BF16 / STORAGE_FP16) makes the forward passes read a 16-bit copy
+/// of the weights (accumulating in T); training keeps updating the T master weights and
+/// refreshes the copy row by row. ReleaseMasterWeights() drops the masters for inference.
+/// </summary>
+template<typename T>
+class GNeuralNetMatrixT : public InterfaceGNeuralNet
+{
+public:
+		// Default constructor: Initializes an empty network object.
+					GNeuralNetMatrixT() {}
+		// Constructor that builds the network from a given topology.
+					GNeuralNetMatrixT(const Topology& topology, const std::string& file_name = "")
+						: m_file_name(file_name) { build(topology); }
+
+		// Get the type ID for runtime type identification.
+		int			GetTypeID() const { return defNetMatrix; }
+		// Main feedforward method to process input values through the network.
+		void		feedForward(const VectorDouble& inputVals) override;
+		// Backpropagation method to adjust weights based on target values.
+		void		backPropagate(const VectorDouble& targetVals) override;
+		// Retrieves the results from the output layer after a feedforward pass.
+		void		getResults(VectorDouble& resultVals) const override;
+		// Span overloads over caller-owned buffers; they read and write the layers directly
+		// and never allocate. getResults() needs exactly the output count.
+		void		feedForward(GSpan<const double> inputVals);
+		void		backPropagate(GSpan<const double> targetVals);
+		void		getResults(GSpan<double> resultVals) const;
+		// Smoothed error of the recent training samples.
+		double		getRecentAverageError(void) const { return m_recentAverageError; }
+		// Save network topology & weights to a binary file (.nnw version 1; freeze().save() writes
+		// the mappable version 2).
+		bool		saveNetwork(const std::string& file_name) const override;
+		// Load network topology & weights from a binary file (.nnw version 1 or 2).
+		bool		loadNetwork(const std::string& file_name) override;
+		// Set the training parameters for the network.
+		void		SetTrainingParameters(double learningRate, double momentum,
+									GNeuronOpenCL::OptimizerType optimizer = GNeuronOpenCL::OptimizerType::Momentum,
+									int activationType = 1, double adam_b1 = 0.9, double adam_b2 = 0.999) override;
+		// Weight update, including AdamW, RMSProp and Nesterov, which only the matrix networks
+		// implement; SetTrainingParameters() selects Momentum or Adam. Keeps the other parameters.
+		void		SetOptimizer(ENUM_OPTIMIZER optimizer) { m_context.optimizer = optimizer; prepareOptimizer(); }
+		ENUM_OPTIMIZER GetOptimizer() const { return m_context.optimizer; }
+		// Set the activation type for the neurons in the network.
+		void		SetActivationType(ENUM_ACTIVATION activationType) override { m_context.activation = activationType; }
+		// Set the learning rate (Eta) for the network.
+		void		SetLearningRate(double learning_rate) override { m_context.learningRate = learning_rate; }
+		// Set the momentum (Alpha) for the network.
+		void		SetMomentum(double momentum) override { m_context.momentum = momentum; }
+		// Retrieves the learning rate value for the network.
+		double		GetLearningRate(void) const override { return m_context.learningRate; }
+		// Retrieves the momentum value for the network.
+		double		GetMomentum(void) const override { return m_context.momentum; }
+		// Exact (libm) or fast polynomial tanh/sigmoid for this network.
+		void		SetActivationPrecision(ENUM_ACTIVATION_PRECISION precision) { m_context.precision = precision; }
+		ENUM_ACTIVATION_PRECISION GetActivationPrecision() const { return m_context.precision; }
+		// Output layer: the network activation trained on squared error, or softmax trained on
+		// cross-entropy with a fused gradient. With softmax the error is the cross-entropy.
+		void		SetOutputLayer(ENUM_OUTPUT_LAYER outputLayer) { m_context.outputLayer = outputLayer; }
+		ENUM_OUTPUT_LAYER GetOutputLayer() const { return m_context.outputLayer; }
+		// Hyperparameters and activation of this network, used by every pass.
+		const GTrainingContext& GetTrainingContext() const { return m_context; }
+		void		SetTrainingContext(const GTrainingContext& context) { m_context = context; prepareOptimizer(); }
+		// Displays the network structure or current state.
+		void		Display(const std::string& title) const override;
+		// Mini-batch API of the header-only backend. It is not part of InterfaceGNeuralNet: the
+		// DLL builds GNeuralNet / GNeuralNetOCL against that interface, so it gets no new virtuals.
+		// Feeds a row-major [batchSize x inputs] mini-batch through the network, layer by layer.
+		// In PARALLEL_HOGWILD mode the following backPropagateBatch() runs each row forward again.
+		void		feedForwardBatch(const double* inputs, size_t batchSize);
+		// Accumulates the gradients of the whole batch and applies one weight update.
+		void		backPropagateBatch(const double* targets, size_t batchSize);
+		// Outputs of the last batch, row-major [batchSize x outputs].
+		void		getBatchResults(VectorDouble& resultVals) const;
+		// Returns the topology of the network.
+		Topology	getTopology() override { return m_topology; }
+
+		// Number of layers, including the input layer.
+		size_t		getLayerCount() const { return m_layers.size(); }
+		// Direct access to the dense storage of one layer.
+		GLayerMatrixT<T>&		getLayer(size_t index) { return m_layers[index]; }
+		const GLayerMatrixT<T>&	getLayer(size_t index) const { return m_layers[index]; }
+		// GNeuron compatible view of one neuron; getConnection(i) addresses the next layer.
+		GNeuronViewT<T> getNeuron(size_t layer, size_t index)
+		{
+			return GNeuronViewT<T>(m_layers[layer], layer + 1 < m_layers.size() ? &m_layers[layer + 1] : nullptr, index);
+		}
+		// Number of threads used inside each layer (1 = serial, the default).
+		void		SetThreadCount(unsigned threads)
+		{
+			if (threads <= 1) m_threadPool.reset();
+			else if (!m_threadPool || m_threadPool->getThreadCount() != threads) m_threadPool.reset(new GThreadPool(threads));
+		}
+		unsigned	GetThreadCount() const { return m_threadPool ? m_threadPool->getThreadCount() : 1; }
+		// How the batch methods use the threads: split each layer, or shard the mini-batch.
+		void		SetParallelMode(ENUM_PARALLEL_MODE mode) { m_parallelMode = mode; }
+		ENUM_PARALLEL_MODE GetParallelMode() const { return m_parallelMode; }
+		// Multiply-adds a layer needs before it is split across threads; keeps gate nets serial.
+		void		SetParallelThreshold(size_t work) { m_parallelThreshold = work; }
+		size_t		GetParallelThreshold() const { return m_parallelThreshold; }
+		// Weights read by the forward passes: the T weights, or a bfloat16 / IEEE half copy of
+		// them. Call again after editing weights through getLayer() or getNeuron().
+		void		SetWeightStorage(ENUM_WEIGHT_STORAGE storage);
+		ENUM_WEIGHT_STORAGE GetWeightStorage() const { return m_storage; }
+		// Inference only: frees the master weights and the optimizer state, keeping just the
+		// 16-bit copy. Training is not possible afterwards; saving and loading still work.
+		void		ReleaseMasterWeights();
+		bool		HasMasterWeights() const { return m_hasMasters; }
+		// Forward pass that writes only to ctx, never to the layers, so several threads may run
+		// it on one network at once (each with its own context) while nobody trains or edits it.
+		// Serial within the call; the activation is the one set on the network.
+		void		infer(GInferenceContextT<T>& ctx, GSpan<const double> inputVals, GSpan<double> resultVals) const;
+		// Activation rows for one thread of infer().
+		GInferenceContextT<T> createContext() const { return GInferenceContextT<T>(m_topology); }
+		// Immutable inference copy of the current weights (see GFrozenNetT). The network
+		// itself is unchanged and may be destroyed afterwards.
+		GFrozenNetT<T> freeze() const;
+
+		// Total bytes held by the layer storage.
+		size_t		getMemoryFootprint() const
+		{
+			size_t total = sizeof(*this);
+			for (const GLayerMatrixT<T>& layer : m_layers)
+				total += layer.getMemoryFootprint();
+			for (const std::vector<GAlignedBuffer<T>>& shard : m_shardGradients)
+				for (const GAlignedBuffer<T>& buffer : shard)
+					total += buffer.bytes();
+			return total;
+		}
+
+private:
+		Topology					m_topology;
+		std::vector<GLayerMatrixT<T>>	m_layers;
+		GTrainingContext			m_context;		// per-network eta/alpha/activation/optimizer
+		// Optimizer whose state (moments) the layers currently hold, and the updates it has made
+		ENUM_OPTIMIZER				m_preparedOptimizer = OPTIMIZER_MOMENTUM;
+		size_t						m_updateCount = 0;
+
+		double			m_error = 0.0;
+		double			m_recentAverageError = 0.0;
+		double			m_recentAverageSmoothingFactor = 100.0;
+		size_t			m_batchSize = 0;		// rows held by the last feedForwardBatch()
+		// Intra-layer threading
+		std::unique_ptr<GThreadPool> m_threadPool;
+		size_t			m_parallelThreshold = 32768;
+		ENUM_PARALLEL_MODE m_parallelMode = PARALLEL_LAYER;
+		// 16-bit weight copy read by the forward passes
+		ENUM_WEIGHT_STORAGE m_storage = STORAGE_FULL;
+		bool			m_hasMasters = true;
+		// Data-parallel weight gradients of shards 1..N-1, [shard][layer]; shard 0 uses the layer's own buffer
+		std::vector<std::vector<GAlignedBuffer<T>>> m_shardGradients;
+		// Per-sample outputs/gradients, one pointer per layer. The network's own buffers
+		// are used by feedForward()/backPropagate(), private copies by Hogwild threads.
+		struct SampleScratch
+		{
+			std::vector<GAlignedBuffer<T>>	outputs;
+			std::vector<GAlignedBuffer<T>>	gradients;
+			std::vector<T*>						outputRows;
+			std::vector<T*>						gradientRows;
+		};
+		SampleScratch				m_sample;
+		std::vector<SampleScratch>	m_hogwildScratch;
+		VectorDouble				m_sampleErrors;
+		// File name for saving/loading the network
+		std::string		m_file_name;
+
+		// Helper function to build the network layers based on the topology
+		void			build(const Topology& topology);
+		// Runs fn(begin, end) over [0, count), split across the pool when count * workPerItem
+		// reaches the parallel threshold, inline otherwise.
+		template<typename F>
+		void			forEachChunk(size_t count, size_t workPerItem, F&& fn)
+		{
+			if (!m_threadPool || count * workPerItem < m_parallelThreshold) {
+				fn(size_t(0), count);
+				return;
+			}
+			const size_t minChunkWork = 4096;
+			m_threadPool->parallelFor(count, std::max<size_t>(1, minChunkWork / std::max<size_t>(workPerItem, 1)), fn);
+		}
+		// Number of data-parallel shards for a batch (0 when the batch is not sharded).
+		size_t			shardCount(size_t batchSize) const
+		{
+			if (m_parallelMode != PARALLEL_DATA || !m_threadPool || batchSize < 2)
+				return 0;
+			return std::min<size_t>(m_threadPool->getThreadCount(), batchSize);
+		}
+		T*				shardGradient(size_t shard, size_t layer)
+		{
+			return shard ? m_shardGradients[shard - 1][layer].data() : m_layers[layer].weightGradients().data();
+		}
+		// Kernels specialized for the context's activation and precision, picked once per pass.
+		static const GLayerKernelsT<T>&	layerKernels(const GTrainingContext& ctx)
+		{
+			return GSimd::Kernels<T>().forActivation(ctx.activation, ctx.precision);
+		}
+		// Single-sample passes over the given per-layer output/gradient rows.
+		void			forwardSample(const GTrainingContext& ctx, T* const* outputs);
+		double			backwardSample(const GTrainingContext& ctx, const double* targets, T* const* outputs, T* const* gradients);
+		void			updateSample(const GTrainingContext& ctx, const GOptimizerStep& step, T* const* outputs, T* const* gradients);
+		void			addRecentError(double error)
+		{
+			m_error = error;
+			m_recentAverageError = (m_recentAverageError * m_recentAverageSmoothingFactor + m_error)
+				/ (m_recentAverageSmoothingFactor + 1.0);
+		}
+		// Hogwild! training on the batch rows already held by the input layer.
+		void			trainHogwild(const GTrainingContext& ctx, const double* targets, size_t batchSize);
+		// Batch passes over the rows [b0, b0 + rows) of the batch buffers.
+		void			forwardRows(const GTrainingContext& ctx, size_t b0, size_t rows);
+		void			hiddenGradientRows(const GTrainingContext& ctx, size_t b0, size_t rows);
+		void			weightGradientRows(size_t layer, size_t b0, size_t rows, T* weightGradients);
+		// rows x [begin, end) of a layer's batch outputs = previous outputs * W^T, over W of type W.
+		template<typename W>
+		void			forwardGemm(const W* weights, size_t l, size_t b0, size_t rows, size_t begin, size_t end);
+		// out[n - begin] = dot(compact row n, x) for n in [begin, end), before the activation.
+		template<typename S>
+		void			compactDots(const GLayerMatrixT<T>& layer, const T* x, T* out, size_t begin, size_t end) const
+		{
+			const GHalfKernelsT<T, S>& H = GSimd::HalfKernels<T, S>();
+			for (size_t n = begin; n < end; ++n)
+				out[n - begin] = H.dot(layer.template compactRow<S>(n), x, layer.getStride());
+		}
+		// out[n - begin] = dot(row n, x) for n in [begin, end) over the weights the forward passes read.
+		void			layerDots(const GLayerMatrixT<T>& layer, const T* x, T* out, size_t begin, size_t end) const
+		{
+			if (m_storage == STORAGE_BF16)
+				compactDots<GBFloat16>(layer, x, out, begin, end);
+			else if (m_storage == STORAGE_FP16)
+				compactDots<GFloat16>(layer, x, out, begin, end);
+			else {
+				const GSimdKernelsT<T>& K = GSimd::Kernels<T>();
+				for (size_t n = begin; n < end; ++n)
+					out[n - begin] = K.dot(layer.weightRow(n), x, layer.getStride());
+			}
+		}
+		// A softmax output layer takes the raw dot products and is normalized as a whole.
+		bool			isSoftmaxLayer(const GTrainingContext& ctx, size_t l) const
+		{
+			return ctx.outputLayer == OUTPUT_SOFTMAX && l + 1 == m_layers.size();
+		}
+		// Output gradients of one sample (target minus output); returns its error: the RMS of the
+		// differences, or the cross-entropy for a softmax output layer.
+		double			outputGradients(const GTrainingContext& ctx, const double* targets, const T* out, T* grad) const
+		{
+			const size_t numOutputs = m_layers.back().getNeuronCount();
+			if (ctx.outputLayer == OUTPUT_SOFTMAX)
+				return GSimd::SoftmaxCrossEntropy(out, targets, grad, numOutputs);
+			double error = 0.0;
+			for (size_t n = 0; n < numOutputs; ++n) {
+				const T delta = T(targets[n]) - out[n];
+				error += double(delta) * delta;
+				grad[n] = delta;
+			}
+			layerKernels(ctx).multiplyDerivative(out, grad, numOutputs);
+			return sqrt(error / numOutputs);
+		}
+		// Copies master row n into the 16-bit copy after an update.
+		void			narrowRow(GLayerMatrixT<T>& layer, size_t n)
+		{
+			if (m_storage == STORAGE_BF16)
+				GSimd::HalfKernels<T, GBFloat16>().narrow(layer.weightRow(n), layer.template compactRow<GBFloat16>(n), layer.getStride());
+			else if (m_storage == STORAGE_FP16)
+				GSimd::HalfKernels<T, GFloat16>().narrow(layer.weightRow(n), layer.template compactRow<GFloat16>(n), layer.getStride());
+		}
+		// Momentum update of one layer from gradients summed over the batch.
+		void			applyWeightGradients(const GTrainingContext& ctx, const GOptimizerStep& step, size_t layer,
+										const T* weightGradients, double scale);
+		// Allocates the moments of the selected optimizer and frees the others; resets the step count.
+		void			prepareOptimizer();
+		// Constants of update number t (1-based) for the fused optimizer kernels.
+		static GOptimizerStep optimizerStep(const GTrainingContext& ctx, size_t t);
+		// Applies one optimizer step to weight row n of a layer with the direction scale * x.
+		void			updateRow(const GSimdKernelsT<T>& K, const GTrainingContext& ctx, const GOptimizerStep& step,
+								GLayerMatrixT<T>& layer, size_t n, const T* x, double scale)
+		{
+			const size_t stride = layer.getStride();
+			const T s = T(scale);
+			switch (ctx.optimizer) {
+			case OPTIMIZER_ADAM:
+			case OPTIMIZER_ADAMW:
+				K.adamUpdate(layer.weightRow(n), layer.firstMomentRow(n), layer.secondMomentRow(n), x, s, step, stride);
+				break;
+			case OPTIMIZER_RMSPROP:
+				K.rmspropUpdate(layer.weightRow(n), layer.secondMomentRow(n), x, s, step, stride);
+				break;
+			case OPTIMIZER_NESTEROV:
+				K.nesterovUpdate(layer.weightRow(n), layer.deltaWeights().data() + n * stride, x, s, step, stride);
+				break;
+			default:
+				K.momentumUpdate(layer.weightRow(n), layer.deltaWeights().data() + n * stride, x, T(step.rate * scale), T(step.beta1), stride);
+				break;
+			}
+			narrowRow(layer, n);
+		}
+		static double	randomWeight(void) { return rand() / double(RAND_MAX); }
+};
+typedef GNeuralNetMatrixT<double> GNeuralNetMatrix;
+typedef GNeuralNetMatrixT<float> GNeuralNetMatrixF;
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::build(const Topology& topology)
+{
+	assert(topology.size() >= 2);
+	m_topology = topology;
+	m_layers.clear();
+	m_layers.reserve(topology.size());
+	for (size_t l = 0; l < topology.size(); ++l) {
+		m_layers.emplace_back(topology[l], l == 0 ? 0 : topology[l - 1]);
+		GLayerMatrixT<T>& layer = m_layers.back();
+		for (size_t n = 0; n < layer.getNeuronCount(); ++n)
+			for (size_t i = 0; i < layer.getRowLength(); ++i)
+				layer.weight(n, i) = T(randomWeight());
+	}
+	m_sample.outputRows.clear();
+	m_sample.gradientRows.clear();
+	for (GLayerMatrixT<T>& layer : m_layers) {
+		m_sample.outputRows.push_back(layer.outputs().data());
+		m_sample.gradientRows.push_back(layer.gradients().data());
+	}
+	m_hogwildScratch.clear();
+	// Fresh layers hold no moments, which is the Momentum state
+	m_preparedOptimizer = OPTIMIZER_MOMENTUM;
+	m_updateCount = 0;
+	prepareOptimizer();
+	m_hasMasters = true;
+	SetWeightStorage(m_storage);
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::SetWeightStorage(ENUM_WEIGHT_STORAGE storage)
+{
+	assert(m_hasMasters);
+	m_storage = storage;
+	for (size_t l = 1; l < m_layers.size(); ++l) {
+		GLayerMatrixT<T>& layer = m_layers[l];
+		GAlignedBuffer<GBFloat16>& bf16 = layer.template compactWeights<GBFloat16>();
+		GAlignedBuffer<GFloat16>& fp16 = layer.template compactWeights<GFloat16>();
+		if (storage == STORAGE_BF16) {
+			bf16.resize(layer.weights().size());
+			GSimd::HalfKernels<T, GBFloat16>().narrow(layer.weights().data(), bf16.data(), bf16.size());
+		}
+		else
+			bf16.release();
+		if (storage == STORAGE_FP16) {
+			fp16.resize(layer.weights().size());
+			GSimd::HalfKernels<T, GFloat16>().narrow(layer.weights().data(), fp16.data(), fp16.size());
+		}
+		else
+			fp16.release();
+	}
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::ReleaseMasterWeights()
+{
+	assert(m_storage != STORAGE_FULL);
+	for (GLayerMatrixT<T>& layer : m_layers)
+		layer.releaseMasterWeights();
+	m_shardGradients.clear();
+	m_hasMasters = false;
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::infer(GInferenceContextT<T>& ctx, GSpan<const double> inputVals, GSpan<double> resultVals) const
+{
+	assert(ctx.matches(m_topology));
+	assert(inputVals.size() == m_topology.front() && resultVals.size() == m_topology.back());
+	const GLayerKernelsT<T>& A = layerKernels(m_context);
+	T* in = ctx.row(0);
+	for (size_t i = 0; i < inputVals.size(); ++i)
+		in[i] = T(inputVals[i]);
+	for (size_t l = 1; l < m_layers.size(); ++l) {
+		const GLayerMatrixT<T>& layer = m_layers[l];
+		const T* prev = ctx.row(l - 1);
+		T* out = ctx.row(l);
+		const size_t neurons = layer.getNeuronCount();
+		if (isSoftmaxLayer(m_context, l)) {
+			layerDots(layer, prev, out, 0, neurons);
+			GSimd::Softmax(out, neurons, m_context.precision);
+		}
+		else if (m_storage == STORAGE_FULL)
+			A.forwardLayer(layer.weightRow(0), layer.getStride(), prev, out, neurons);
+		else {
+			layerDots(layer, prev, out, 0, neurons);
+			A.activate(out, neurons);
+		}
+	}
+	const T* out = ctx.row(m_layers.size() - 1);
+	for (size_t n = 0; n < resultVals.size(); ++n)
+		resultVals[n] = double(out[n]);
+}
+
+template<typename T>
+inline GFrozenNetT<T> GNeuralNetMatrixT<T>::freeze() const
+{
+	GFrozenNetT<T> frozen;
+	frozen.allocate(m_topology, m_context.activation, m_context.precision, m_context.outputLayer);
+	for (size_t l = 1; l < m_layers.size(); ++l) {
+		const GLayerMatrixT<T>& layer = m_layers[l];
+		for (size_t n = 0; n < layer.getNeuronCount(); ++n) {
+			T* row = frozen.weightRow(l - 1, n);
+			if (m_hasMasters)
+				std::copy(layer.weightRow(n), layer.weightRow(n) + layer.getRowLength(), row);
+			else if (m_storage == STORAGE_BF16)
+				GSimd::HalfKernels<T, GBFloat16>().widen(layer.template compactRow<GBFloat16>(n), row, layer.getRowLength());
+			else
+				GSimd::HalfKernels<T, GFloat16>().widen(layer.template compactRow<GFloat16>(n), row, layer.getRowLength());
+		}
+	}
+	return frozen;
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::prepareOptimizer()
+{
+	if (m_preparedOptimizer == m_context.optimizer)
+		return;
+	const bool adam = m_context.optimizer == OPTIMIZER_ADAM || m_context.optimizer == OPTIMIZER_ADAMW;
+	const bool rms = m_context.optimizer == OPTIMIZER_RMSPROP;
+	for (size_t l = 1; l < m_layers.size(); ++l) {
+		GLayerMatrixT<T>& layer = m_layers[l];
+		layer.reserveMoments(adam, adam || rms);
+		layer.firstMoments().fill(T(0));
+		layer.secondMoments().fill(T(0));
+	}
+	m_preparedOptimizer = m_context.optimizer;
+	m_updateCount = 0;
+}
+
+template<typename T>
+inline GOptimizerStep GNeuralNetMatrixT<T>::optimizerStep(const GTrainingContext& ctx, size_t t)
+{
+	GOptimizerStep step = { ctx.learningRate, ctx.momentum, ctx.adam_b2, ctx.epsilon, 0.0 };
+	switch (ctx.optimizer) {
+	case OPTIMIZER_ADAMW:
+		step.decay = ctx.learningRate * ctx.weightDecay;
+		// fall through
+	case OPTIMIZER_ADAM:
+		step.beta1 = ctx.adam_b1;
+		step.rate = ctx.learningRate * sqrt(1.0 - pow(ctx.adam_b2, double(t))) / (1.0 - pow(ctx.adam_b1, double(t)));
+		break;
+	case OPTIMIZER_RMSPROP:
+		step.beta2 = ctx.rmsDecay;
+		break;
+	default:
+		break;
+	}
+	return step;
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::feedForward(const VectorDouble& inputVals)
+{
+	feedForward(GSpan<const double>(inputVals));
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::feedForward(GSpan<const double> inputVals)
+{
+	GLayerMatrixT<T>& inputLayer = m_layers.front();
+	assert(inputVals.size() == inputLayer.getNeuronCount());
+	T* in = inputLayer.outputs().data();
+	for (size_t i = 0; i < inputVals.size(); ++i)
+		in[i] = T(inputVals[i]);
+	forwardSample(m_context, m_sample.outputRows.data());
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::backPropagate(const VectorDouble& targetVals)
+{
+	backPropagate(GSpan<const double>(targetVals));
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::backPropagate(GSpan<const double> targetVals)
+{
+	assert(targetVals.size() == m_layers.back().getNeuronCount());
+	assert(m_hasMasters);
+	addRecentError(backwardSample(m_context, targetVals.data(), m_sample.outputRows.data(), m_sample.gradientRows.data()));
+	updateSample(m_context, optimizerStep(m_context, ++m_updateCount), m_sample.outputRows.data(), m_sample.gradientRows.data());
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::forwardSample(const GTrainingContext& ctx, T* const* outputs)
+{
+	const GLayerKernelsT<T>& A = layerKernels(ctx);
+	for (size_t l = 1; l < m_layers.size(); ++l) {
+		const T* prev = outputs[l - 1];
+		const GLayerMatrixT<T>& layer = m_layers[l];
+		T* out = outputs[l];
+		// Rows and the previous outputs are zero padded, so the full stride can be used
+		const size_t stride = layer.getStride();
+		const bool softmax = isSoftmaxLayer(ctx, l);
+		forEachChunk(layer.getNeuronCount(), stride, [&](size_t begin, size_t end) {
+			if (m_storage == STORAGE_FULL && !softmax) {
+				A.forwardLayer(layer.weightRow(begin), stride, prev, out + begin, end - begin);
+				return;
+			}
+			layerDots(layer, prev, out + begin, begin, end);
+			if (!softmax)
+				A.activate(out + begin, end - begin);
+		});
+		if (softmax)
+			GSimd::Softmax(out, layer.getNeuronCount(), ctx.precision);
+	}
+}
+
+template<typename T>
+inline double GNeuralNetMatrixT<T>::backwardSample(const GTrainingContext& ctx, const double* targets, T* const* outputs, T* const* gradients)
+{
+	const GSimdKernelsT<T>& K = GSimd::Kernels<T>();
+	const GLayerKernelsT<T>& A = layerKernels(ctx);
+	// Overall net error (RMS of output neuron errors, or the cross-entropy)
+	const double error = outputGradients(ctx, targets, outputs[m_layers.size() - 1], gradients[m_layers.size() - 1]);
+
+	// Hidden layer gradients: sum of the next layer's column weighted by its gradients.
+	// Split by cache-line sized column blocks so threads never share a line of hGrad.
+	const size_t lineElements = G_CACHE_LINE / sizeof(T);
+	for (size_t l = m_layers.size() - 2; l > 0; --l) {
+		const GLayerMatrixT<T>& hidden = m_layers[l];
+		const GLayerMatrixT<T>& next = m_layers[l + 1];
+		const T* nextGrad = gradients[l + 1];
+		const T* hOut = outputs[l];
+		T* hGrad = gradients[l];
+		const size_t columns = hidden.getNeuronCount() + 1;
+		forEachChunk(next.getStride() / lineElements, next.getNeuronCount() * lineElements, [&](size_t begin, size_t end) {
+			const size_t j0 = begin * lineElements, j1 = end * lineElements;
+			for (size_t j = j0; j < j1; ++j)
+				hGrad[j] = T(0);
+			for (size_t k = 0; k < next.getNeuronCount(); ++k)
+				K.axpy(nextGrad[k], next.weightRow(k) + j0, hGrad + j0, j1 - j0);
+			if (j0 < columns)
+				A.multiplyDerivative(hOut + j0, hGrad + j0, std::min(j1, columns) - j0);
+		});
+	}
+	return error;
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::updateSample(const GTrainingContext& ctx, const GOptimizerStep& step, T* const* outputs, T* const* gradients)
+{
+	const GSimdKernelsT<T>& K = GSimd::Kernels<T>();
+	// Update the input weights of every neuron, output layer first
+	for (size_t l = m_layers.size() - 1; l > 0; --l) {
+		GLayerMatrixT<T>& layer = m_layers[l];
+		const T* prev = outputs[l - 1];
+		const T* g = gradients[l];
+		forEachChunk(layer.getNeuronCount(), layer.getStride(), [&](size_t begin, size_t end) {
+			for (size_t n = begin; n < end; ++n)
+				updateRow(K, ctx, step, layer, n, prev, g[n]);
+		});
+	}
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::trainHogwild(const GTrainingContext& ctx, const double* targets, size_t batchSize)
+{
+	const unsigned threads = m_threadPool->getThreadCount();
+	const size_t numInputs = m_layers.front().getNeuronCount();
+	const size_t numOutputs = m_layers.back().getNeuronCount();
+	// Private activation/gradient rows for every thread, allocated once
+	if (m_hogwildScratch.size() != threads) {
+		m_hogwildScratch.assign(threads, SampleScratch());
+		for (SampleScratch& scratch : m_hogwildScratch) {
+			for (const GLayerMatrixT<T>& layer : m_layers) {
+				scratch.outputs.emplace_back(layer.getOutputStride());
+				scratch.outputs.back()[layer.getNeuronCount()] = T(1);	// bias neuron
+				scratch.gradients.emplace_back(layer.getOutputStride());
+			}
+			for (size_t l = 0; l < m_layers.size(); ++l) {
+				scratch.outputRows.push_back(scratch.outputs[l].data());
+				scratch.gradientRows.push_back(scratch.gradients[l].data());
+			}
+		}
+	}
+	m_sampleErrors.resize(batchSize);
+	const size_t firstStep = m_updateCount + 1;
+	m_updateCount += batchSize;
+	// Thread t takes samples t, t + threads, ...; no barrier until the batch is done
+	m_threadPool->parallelFor(threads, 1, [&](size_t begin, size_t end) {
+		for (size_t t = begin; t < end; ++t) {
+			SampleScratch& scratch = m_hogwildScratch[t];
+			for (size_t b = t; b < batchSize; b += threads) {
+				std::copy(m_layers.front().batchOutputRow(b), m_layers.front().batchOutputRow(b) + numInputs, scratch.outputRows[0]);
+				forwardSample(ctx, scratch.outputRows.data());
+				m_sampleErrors[b] = backwardSample(ctx, targets + b * numOutputs, scratch.outputRows.data(), scratch.gradientRows.data());
+				updateSample(ctx, optimizerStep(ctx, firstStep + b), scratch.outputRows.data(), scratch.gradientRows.data());
+			}
+		}
+	});
+	for (size_t b = 0; b < batchSize; ++b)
+		addRecentError(m_sampleErrors[b]);
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::getResults(VectorDouble& resultVals) const
+{
+	const GLayerMatrixT<T>& outputLayer = m_layers.back();
+	const T* out = outputLayer.outputs().data();
+	resultVals.assign(out, out + outputLayer.getNeuronCount());
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::getResults(GSpan<double> resultVals) const
+{
+	const GLayerMatrixT<T>& outputLayer = m_layers.back();
+	assert(resultVals.size() == outputLayer.getNeuronCount());
+	const T* out = outputLayer.outputs().data();
+	for (size_t n = 0; n < resultVals.size(); ++n)
+		resultVals[n] = double(out[n]);
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::feedForwardBatch(const double* inputs, size_t batchSize)
+{
+	const size_t numInputs = m_layers.front().getNeuronCount();
+	for (GLayerMatrixT<T>& layer : m_layers)
+		layer.reserveBatch(batchSize);
+	m_batchSize = batchSize;
+
+	for (size_t b = 0; b < batchSize; ++b) {
+		T* in = m_layers.front().batchOutputRow(b);
+		for (size_t i = 0; i < numInputs; ++i)
+			in[i] = T(inputs[b * numInputs + i]);
+	}
+	const size_t shards = shardCount(batchSize);
+	if (!shards) {
+		forwardRows(m_context, 0, batchSize);
+		return;
+	}
+	const size_t rowsPerShard = (batchSize + shards - 1) / shards;
+	m_threadPool->parallelFor(shards, 1, [&](size_t begin, size_t end) {
+		for (size_t s = begin; s < end && s * rowsPerShard < batchSize; ++s)
+			forwardRows(m_context, s * rowsPerShard, std::min(rowsPerShard, batchSize - s * rowsPerShard));
+	});
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::backPropagateBatch(const double* targets, size_t batchSize)
+{
+	assert(batchSize == m_batchSize);
+	assert(m_hasMasters);
+	const GTrainingContext& ctx = m_context;
+	if (m_parallelMode == PARALLEL_HOGWILD && m_threadPool) {
+		trainHogwild(ctx, targets, batchSize);
+		return;
+	}
+	const GSimdKernelsT<T>& K = GSimd::Kernels<T>();
+	GLayerMatrixT<T>& outputLayer = m_layers.back();
+	const size_t numOutputs = outputLayer.getNeuronCount();
+
+	// Output gradients for every sample; the recent average error advances once per sample
+	for (size_t b = 0; b < batchSize; ++b)
+		addRecentError(outputGradients(ctx, targets + b * numOutputs, outputLayer.batchOutputRow(b), outputLayer.batchGradientRow(b)));
+
+	const double scale = 1.0 / static_cast<double>(batchSize);
+	const GOptimizerStep step = optimizerStep(ctx, ++m_updateCount);
+	const size_t shards = shardCount(batchSize);
+	if (!shards) {
+		hiddenGradientRows(ctx, 0, batchSize);
+		for (size_t l = m_layers.size() - 1; l > 0; --l) {
+			weightGradientRows(l, 0, batchSize, m_layers[l].weightGradients().data());
+			applyWeightGradients(ctx, step, l, m_layers[l].weightGradients().data(), scale);
+		}
+		return;
+	}
+
+	// Data parallel: every shard back-propagates its rows into its own gradient buffers
+	m_shardGradients.resize(shards - 1);
+	for (std::vector<GAlignedBuffer<T>>& shard : m_shardGradients) {
+		shard.resize(m_layers.size());
+		for (size_t l = 1; l < m_layers.size(); ++l)
+			if (shard[l].size() != m_layers[l].weights().size())
+				shard[l].resize(m_layers[l].weights().size());
+	}
+	const size_t rowsPerShard = (batchSize + shards - 1) / shards;
+	m_threadPool->parallelFor(shards, 1, [&](size_t begin, size_t end) {
+		for (size_t s = begin; s < end; ++s) {
+			const size_t b0 = std::min(s * rowsPerShard, batchSize);
+			const size_t rows = std::min(rowsPerShard, batchSize - b0);
+			hiddenGradientRows(ctx, b0, rows);
+			for (size_t l = 1; l < m_layers.size(); ++l)
+				weightGradientRows(l, b0, rows, shardGradient(s, l));
+		}
+	});
+	// Pairwise tree reduction into shard 0, log2(shards) rounds
+	for (size_t step = 1; step < shards; step *= 2) {
+		m_threadPool->parallelFor(shards, 1, [&](size_t begin, size_t end) {
+			for (size_t s = begin; s < end; ++s) {
+				if (s % (2 * step) != 0 || s + step >= shards)
+					continue;
+				for (size_t l = 1; l < m_layers.size(); ++l)
+					K.axpy(T(1), shardGradient(s + step, l), shardGradient(s, l), m_layers[l].weights().size());
+			}
+		});
+	}
+	for (size_t l = m_layers.size() - 1; l > 0; --l)
+		applyWeightGradients(ctx, step, l, shardGradient(0, l), scale);
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::forwardRows(const GTrainingContext& ctx, size_t b0, size_t rows)
+{
+	const GLayerKernelsT<T>& A = layerKernels(ctx);
+	// [rows x neurons] = [rows x stride] * W^T
+	for (size_t l = 1; l < m_layers.size(); ++l) {
+		GLayerMatrixT<T>& layer = m_layers[l];
+		const bool softmax = isSoftmaxLayer(ctx, l);
+		// Each thread owns a range of neurons, i.e. a column block of the output
+		forEachChunk(layer.getNeuronCount(), rows * layer.getRowLength(), [&](size_t begin, size_t end) {
+			if (m_storage == STORAGE_BF16)
+				forwardGemm(layer.template compactWeights<GBFloat16>().data(), l, b0, rows, begin, end);
+			else if (m_storage == STORAGE_FP16)
+				forwardGemm(layer.template compactWeights<GFloat16>().data(), l, b0, rows, begin, end);
+			else
+				forwardGemm(layer.weights().data(), l, b0, rows, begin, end);
+			if (softmax)
+				return;
+			for (size_t b = b0; b < b0 + rows; ++b)
+				A.activate(layer.batchOutputRow(b) + begin, end - begin);
+		});
+		if (softmax)
+			for (size_t b = b0; b < b0 + rows; ++b)
+				GSimd::Softmax(layer.batchOutputRow(b), layer.getNeuronCount(), ctx.precision);
+	}
+}
+
+template<typename T>
+template<typename W>
+inline void GNeuralNetMatrixT<T>::forwardGemm(const W* weights, size_t l, size_t b0, size_t rows, size_t begin, size_t end)
+{
+	const GLayerMatrixT<T>& prev = m_layers[l - 1];
+	GLayerMatrixT<T>& layer = m_layers[l];
+	GGemm::gemm(GGemm::NoTrans, GGemm::Trans, rows, end - begin, layer.getRowLength(),
+		1.0, prev.batchOutputRow(b0), prev.getOutputStride(), weights + begin * layer.getStride(), layer.getStride(),
+		0.0, layer.batchOutputRow(b0) + begin, layer.getOutputStride());
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::hiddenGradientRows(const GTrainingContext& ctx, size_t b0, size_t rows)
+{
+	const GLayerKernelsT<T>& A = layerKernels(ctx);
+	const size_t lineElements = G_CACHE_LINE / sizeof(T);
+	// [rows x hidden] = [rows x next] * W_next
+	for (size_t l = m_layers.size() - 2; l > 0; --l) {
+		GLayerMatrixT<T>& hidden = m_layers[l];
+		const GLayerMatrixT<T>& next = m_layers[l + 1];
+		const size_t columns = next.getRowLength();
+		forEachChunk((columns + lineElements - 1) / lineElements, rows * next.getNeuronCount() * lineElements,
+			[&](size_t begin, size_t end) {
+			const size_t j0 = begin * lineElements, j1 = std::min(end * lineElements, columns);
+			GGemm::gemm(GGemm::NoTrans, GGemm::NoTrans, rows, j1 - j0, next.getNeuronCount(),
+				1.0, next.batchGradientRow(b0), next.getOutputStride(), next.weightRow(0) + j0, next.getStride(),
+				0.0, hidden.batchGradientRow(b0) + j0, hidden.getOutputStride());
+			for (size_t b = b0; b < b0 + rows; ++b)
+				A.multiplyDerivative(hidden.batchOutputRow(b) + j0, hidden.batchGradientRow(b) + j0, j1 - j0);
+		});
+	}
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::weightGradientRows(size_t l, size_t b0, size_t rows, T* weightGradients)
+{
+	GLayerMatrixT<T>& layer = m_layers[l];
+	const GLayerMatrixT<T>& prev = m_layers[l - 1];
+	const size_t stride = layer.getStride();
+	// [neurons x stride] = G^T * X over the rows
+	forEachChunk(layer.getNeuronCount(), rows * layer.getRowLength(), [&](size_t begin, size_t end) {
+		GGemm::gemm(GGemm::Trans, GGemm::NoTrans, end - begin, layer.getRowLength(), rows,
+			1.0, layer.batchGradientRow(b0) + begin, layer.getOutputStride(), prev.batchOutputRow(b0), prev.getOutputStride(),
+			0.0, weightGradients + begin * stride, stride);
+	});
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::applyWeightGradients(const GTrainingContext& ctx, const GOptimizerStep& step, size_t l,
+	const T* weightGradients, double scale)
+{
+	const GSimdKernelsT<T>& K = GSimd::Kernels<T>();
+	GLayerMatrixT<T>& layer = m_layers[l];
+	const size_t stride = layer.getStride();
+	forEachChunk(layer.getNeuronCount(), stride, [&](size_t begin, size_t end) {
+		for (size_t n = begin; n < end; ++n)
+			updateRow(K, ctx, step, layer, n, weightGradients + n * stride, scale);
+	});
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::getBatchResults(VectorDouble& resultVals) const
+{
+	const GLayerMatrixT<T>& outputLayer = m_layers.back();
+	const size_t numOutputs = outputLayer.getNeuronCount();
+	resultVals.resize(m_batchSize * numOutputs);
+	for (size_t b = 0; b < m_batchSize; ++b) {
+		const T* out = outputLayer.batchOutputRow(b);
+		std::copy(out, out + numOutputs, resultVals.begin() + b * numOutputs);
+	}
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::SetTrainingParameters(double learningRate, double momentum,
+	GNeuronOpenCL::OptimizerType optimizer, int activationType, double adam_b1, double adam_b2)
+{
+	m_context.learningRate = learningRate;
+	m_context.momentum = momentum;
+	m_context.optimizer = optimizer == GNeuronOpenCL::OptimizerType::Adam ? OPTIMIZER_ADAM : OPTIMIZER_MOMENTUM;
+	m_context.activation = static_cast<ENUM_ACTIVATION>(activationType);
+	m_context.adam_b1 = adam_b1;
+	m_context.adam_b2 = adam_b2;
+	prepareOptimizer();
+}
+
+template<typename T>
+inline bool GNeuralNetMatrixT<T>::saveNetwork(const std::string& file_name) const
+{
+	GFile outFile;
+	if (!outFile.open(file_name, true))
+		return false;
+	const int activation = m_context.activation | (m_context.outputLayer == OUTPUT_SOFTMAX ? defOutputSoftmax : 0);
+	bool ok = GNetworkFile::WriteVersion1Header(outFile.handle(), m_topology, activation);
+	// One write per layer: its unpadded rows back to back, as doubles
+	VectorDouble block;
+	std::vector<T> wide;
+	for (size_t l = 1; ok && l < m_layers.size(); ++l) {
+		const GLayerMatrixT<T>& layer = m_layers[l];
+		const size_t rowLength = layer.getRowLength();
+		block.resize(layer.getNeuronCount() * rowLength);
+		wide.resize(rowLength);
+		for (size_t n = 0; n < layer.getNeuronCount(); ++n) {
+			const T* w = layer.weightRow(n);
+			if (!m_hasMasters) {
+				// Without masters the 16-bit copy is all there is
+				if (m_storage == STORAGE_BF16)
+					GSimd::HalfKernels<T, GBFloat16>().widen(layer.template compactRow<GBFloat16>(n), wide.data(), wide.size());
+				else
+					GSimd::HalfKernels<T, GFloat16>().widen(layer.template compactRow<GFloat16>(n), wide.data(), wide.size());
+				w = wide.data();
+			}
+			std::copy(w, w + rowLength, block.begin() + n * rowLength);
+		}
+		ok = WriteDoubles(outFile.handle(), block);
+	}
+	ok = outFile.close() && ok;
+	if (!ok)
+		std::cerr << "Error: Failed to write " << file_name << "." << std::endl;
+	return ok;
+}
+
+template<typename T>
+inline bool GNeuralNetMatrixT<T>::loadNetwork(const std::string& file_name)
+{
+	GFile inFile;
+	if (!inFile.open(file_name))
+		return false;
+	int type = 0;
+	size_t layers = 0;
+	int activation = 0;
+	const bool hasType = ReadBytes(inFile.handle(), &type, sizeof(type));
+	if (hasType && type == defNetFileV2) {
+		// Version 2: read through a frozen network, then copy its rows into the layer matrices
+		inFile.close();
+		GFrozenNetT<T> frozen;
+		if (!frozen.load(file_name))
+			return false;
+		build(frozen.getTopology());
+		m_context.activation = frozen.GetActivationType();
+		m_context.precision = frozen.GetActivationPrecision();
+		m_context.outputLayer = frozen.GetOutputLayer();
+		for (size_t l = 1; l < m_layers.size(); ++l) {
+			GLayerMatrixT<T>& layer = m_layers[l];
+			const typename GFrozenNetT<T>::LayerInfo& info = frozen.m_layers[l - 1];
+			for (size_t n = 0; n < layer.getNeuronCount(); ++n) {
+				const T* w = frozen.weights() + info.offset + n * info.stride;
+				std::copy(w, w + layer.getRowLength(), layer.weightRow(n));
+			}
+		}
+		SetWeightStorage(m_storage);
+		m_file_name = file_name;
+		return true;
+	}
+	if (!hasType || type != defNetMatrix || !ReadBytes(inFile.handle(), &layers, sizeof(layers)) || layers < 2 || layers > 4096) {
+		std::cerr << "Error: " << file_name << " is not a matrix network file." << std::endl;
+		return false;
+	}
+	Topology topology(layers);
+	if (!ReadBytes(inFile.handle(), topology.data(), layers * sizeof(size_t))
+		|| !ReadBytes(inFile.handle(), &activation, sizeof(activation)))
+		return false;
+	// The topology comes from the file: every layer's rows must fit in what is left of it
+	// before any size derived from it is allocated. Each row holds topology[l - 1] weights
+	// plus the bias, so an input count past the remaining doubles cannot fit either.
+	const uint64_t headerBytes = sizeof(type) + sizeof(layers) + layers * sizeof(size_t) + sizeof(activation);
+	const uint64_t fileBytes = inFile.size();
+	uint64_t weightBytes = 0;
+	bool valid = fileBytes >= headerBytes;
+	for (size_t l = 1; valid && l < layers; ++l) {
+		const uint64_t remaining = fileBytes - headerBytes - weightBytes;
+		valid = topology[l - 1] > 0 && topology[l] > 0 && topology[l - 1] < remaining / sizeof(double)
+			&& GNetworkFile::Fits(0, topology[l], (topology[l - 1] + 1) * sizeof(double), remaining);
+		if (valid)
+			weightBytes += topology[l] * (topology[l - 1] + 1) * sizeof(double);
+	}
+	if (!valid) {
+		std::cerr << "Error: " << file_name << " has a topology that does not fit the file." << std::endl;
+		return false;
+	}
+	// One read per layer into staging blocks; the network is only rebuilt once all of them are in
+	std::vector<VectorDouble> blocks(layers);
+	for (size_t l = 1; l < layers; ++l) {
+		blocks[l].resize(topology[l] * (topology[l - 1] + 1));
+		if (!ReadDoubles(inFile.handle(), blocks[l]))
+			return false;
+	}
+	build(topology);
+	m_context.activation = static_cast<ENUM_ACTIVATION>(activation & ~defOutputSoftmax);
+	m_context.outputLayer = (activation & defOutputSoftmax) ? OUTPUT_SOFTMAX : OUTPUT_ACTIVATION;
+	// The rows go to their padded place in the matrix
+	for (size_t l = 1; l < m_layers.size(); ++l) {
+		GLayerMatrixT<T>& layer = m_layers[l];
+		const size_t rowLength = layer.getRowLength();
+		for (size_t n = 0; n < layer.getNeuronCount(); ++n)
+			std::copy(blocks[l].begin() + n * rowLength, blocks[l].begin() + (n + 1) * rowLength, layer.weightRow(n));
+	}
+	SetWeightStorage(m_storage);
+	m_file_name = file_name;
+	return true;
+}
+
+template<typename T>
+inline void GNeuralNetMatrixT<T>::Display(const std::string& title) const
+{
+	std::cout << "--- " << title << " ---" << std::endl;
+	for (size_t l = 0; l < m_layers.size(); ++l) {
+		const GLayerMatrixT<T>& layer = m_layers[l];
+		std::cout << "Layer " << l << " (" << layer.getNeuronCount() << " neurons) outputs: [ ";
+		for (size_t n = 0; n < layer.getNeuronCount(); ++n)
+			std::cout << std::fixed << std::setprecision(4) << layer.outputs()[n] << " ";
+		std::cout << "]" << std::endl;
+	}
+	std::cout << "Recent average error: " << m_recentAverageError << std::endl;
+}
+
+namespace GTrainer
+{
+	// Declared in GTrainer.h.
+	inline GTrainResult Run(InterfaceGNeuralNet& net, const GDatasetView& data, const GTrainOptions& options)
+	{
+		if (GNeuralNetMatrix* matrix = dynamic_cast<GNeuralNetMatrix*>(&net))
+			return Run(*matrix, data, options);
+		if (GNeuralNetMatrixF* matrix = dynamic_cast<GNeuralNetMatrixF*>(&net))
+			return Run(*matrix, data, options);
+		return RunPerSample(net, data, options);
+	}
+}
@@ -37,6 +37,8 @@ public:
 	const			std::vector<GNeuralConnection>& getOutputWeights() const { return m_outputWeights; }
 	double			getGradient(void) const { return m_gradient; }
 
+	// Process-wide: shared by every GNeuralNet in the process. Networks that must train
+	// concurrently with their own rates should use GNeuralNetMatrix (see GTrainingContext.h).
 	static void		setEta(double val) { eta = val; }
 	static void		setAlpha(double val) { alpha = val; }
 
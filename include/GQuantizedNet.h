@@ -0,0 +1,293 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <cstdint>
+#include "GTypes.h"
+#include "GAlignedBuffer.h"
+#include "GInt8Kernels.h"
+#include "GNeuralNetMatrix.h"
+
+/// <summary>
+/// Accuracy of a quantized network against the network it was built from, on one dataset.
+/// An output counts as correct when it is within 0.5 of its target (one output) or when
+/// the largest output is the target's largest (several outputs).
+/// </summary>
+struct GQuantizationReport
+{
+	size_t			samples = 0;
+	double			maxAbsDiff = 0.0;			// largest |int8 output - reference output|
+	double			meanAbsDiff = 0.0;
+	double			referenceError = 0.0;		// RMS error against the targets
+	double			quantizedError = 0.0;
+	double			referenceAccuracy = 0.0;	// fraction of samples classified correctly
+	double			quantizedAccuracy = 0.0;
+	double			agreement = 0.0;			// fraction where both networks give the same class
+};
+
+/// <summary>
+/// Inference-only int8 copy of a trained CPU matrix network (post-training quantization).
+/// Weights are symmetric int8 with one scale per row or per layer. The inputs of every
+/// layer are affine uint8 (scale and zero point) over the range seen while running a
+/// calibration set through the source network. A neuron accumulates u8 x s8 products in
+/// int32 (GInt8Kernels.h), subtracts the zero point term in integer arithmetic, and is then
+/// requantized once to float: acc * (inputScale * weightScale) + bias. The bias is kept in
+/// float and the activation runs on the float value, so tanh/sigmoid never see an
+/// intermediate rounding; only the result is quantized again for the next layer.
+/// </summary>
+class GQuantizedNet
+{
+public:
+					GQuantizedNet() {}
+
+		// Builds the int8 network from 'net'. 'samples' is row-major [count x inputs]; every
+		// layer's input range is calibrated by running them through 'net'.
+		template<typename T>
+		bool		quantize(GNeuralNetMatrixT<T>& net, const double* samples, size_t count,
+							ENUM_QUANT_GRANULARITY granularity = QUANT_PER_ROW);
+		// Same for a matrix network held through the interface (NetworkFactory::CreateMatrixNetwork).
+		// GNeuralNet and GNeuralNetOCL, which LoadNetworkFromFile returns, do not expose their
+		// weights; they are reported and refused.
+		bool		quantize(InterfaceGNeuralNet& net, const double* samples, size_t count,
+							ENUM_QUANT_GRANULARITY granularity = QUANT_PER_ROW);
+
+		// Runs one sample through the int8 layers.
+		void		feedForward(const VectorDouble& inputVals);
+		// Outputs of the last feedForward().
+		void		getResults(VectorDouble& resultVals) const;
+		// Runs [count x inputs] through both networks and compares them with each other and
+		// with the [count x outputs] targets.
+		GQuantizationReport compare(InterfaceGNeuralNet& reference, const double* inputs, const double* targets, size_t count);
+
+		bool		isQuantized() const { return !m_layers.empty(); }
+		Topology	getTopology() const { return m_topology; }
+		ENUM_QUANT_GRANULARITY GetGranularity() const { return m_granularity; }
+		// Total bytes held by the int8 layers.
+		size_t		getMemoryFootprint() const
+		{
+			size_t total = sizeof(*this) + m_outputs.bytes();
+			for (const Layer& layer : m_layers)
+				total += sizeof(layer) + layer.weights.bytes() + layer.scales.bytes() + layer.biases.bytes()
+					+ layer.zeroTerms.bytes() + layer.inputs.bytes() + layer.sums.bytes();
+			return total;
+		}
+
+private:
+		// One quantized layer and the uint8 copy of its input row.
+		struct Layer
+		{
+			size_t						numNeurons = 0;
+			size_t						numInputs = 0;
+			size_t						stride = 0;			// padded row length (inputs only, no bias)
+			float						inputScale = 1.0f;	// input = (q - inputZero) * inputScale
+			int32_t						inputZero = 0;
+			GAlignedBuffer<int8_t>		weights;			// [neurons x stride], zero padded
+			GAlignedBuffer<float>		scales;				// inputScale * weight scale of the row
+			GAlignedBuffer<float>		biases;				// bias weights, not quantized
+			GAlignedBuffer<int32_t>		zeroTerms;			// inputZero * sum of the row's int8 weights
+			GAlignedBuffer<uint8_t>		inputs;				// quantized input row, stride long
+			GAlignedBuffer<int32_t>		sums;				// integer net inputs, one per neuron
+		};
+
+		Topology					m_topology;
+		std::vector<Layer>			m_layers;			// layers 1..L-1 of the source network
+		GAlignedBuffer<float>		m_outputs;			// inputs, then the activated outputs of each layer
+		ENUM_ACTIVATION				m_activation = TANH;
+		ENUM_ACTIVATION_PRECISION	m_precision = ACTIVATION_EXACT;
+		ENUM_OUTPUT_LAYER			m_outputLayer = OUTPUT_ACTIVATION;
+		ENUM_QUANT_GRANULARITY		m_granularity = QUANT_PER_ROW;
+
+		// q = round(v / scale) + zero, clamped to [0, 255]. The value is clamped first, so
+		// rounding is a truncating add of 0.5 and the loop vectorizes.
+		static void	quantizeRow(const float* v, size_t n, float scale, int32_t zero, uint8_t* q)
+		{
+			const float inverse = 1.0f / scale, offset = float(zero) + 0.5f;
+			for (size_t i = 0; i < n; ++i)
+				q[i] = static_cast<uint8_t>(static_cast<int32_t>(std::min(std::max(v[i] * inverse + offset, 0.0f), 255.0f)));
+		}
+		// Index of the largest value, the class of a multi-output sample.
+		static size_t argMax(const double* v, size_t n) { return std::max_element(v, v + n) - v; }
+		// Affine uint8 parameters covering [lo, hi]; the range always holds 0 so that exactly
+		// representable zeros stay zeros.
+		static void	rangeToAffine(double lo, double hi, float& scale, int32_t& zero)
+		{
+			lo = std::min(lo, 0.0);
+			hi = std::max(hi, 0.0);
+			scale = hi > lo ? float((hi - lo) / 255.0) : 1.0f;
+			zero = static_cast<int32_t>(std::min(std::max(std::lround(-lo / scale), 0L), 255L));
+		}
+};
+
+template<typename T>
+inline bool GQuantizedNet::quantize(GNeuralNetMatrixT<T>& net, const double* samples, size_t count,
+	ENUM_QUANT_GRANULARITY granularity)
+{
+	const size_t numLayers = net.getLayerCount();
+	if (numLayers < 2 || !count) {
+		std::cerr << "Error: quantization needs a built network and at least one calibration sample." << std::endl;
+		return false;
+	}
+	if (!net.HasMasterWeights()) {
+		std::cerr << "Error: the network has released its master weights; quantize it before ReleaseMasterWeights()." << std::endl;
+		return false;
+	}
+	// Calibration: range of every layer output that feeds a next layer
+	const size_t numInputs = net.getLayer(0).getNeuronCount();
+	std::vector<double> lo(numLayers - 1, 0.0), hi(numLayers - 1, 0.0);
+	VectorDouble row(numInputs);
+	for (size_t s = 0; s < count; ++s) {
+		row.assign(samples + s * numInputs, samples + (s + 1) * numInputs);
+		net.feedForward(row);
+		for (size_t l = 0; l + 1 < numLayers; ++l) {
+			const GLayerMatrixT<T>& layer = net.getLayer(l);
+			for (size_t n = 0; n < layer.getNeuronCount(); ++n) {
+				lo[l] = std::min(lo[l], double(layer.outputs()[n]));
+				hi[l] = std::max(hi[l], double(layer.outputs()[n]));
+			}
+		}
+	}
+
+	m_topology = net.getTopology();
+	m_activation = net.GetTrainingContext().activation;
+	m_precision = net.GetActivationPrecision();
+	m_outputLayer = net.GetOutputLayer();
+	m_granularity = granularity;
+	m_layers.clear();
+	m_layers.resize(numLayers - 1);
+	size_t widest = numInputs;
+	for (size_t l = 1; l < numLayers; ++l) {
+		const GLayerMatrixT<T>& source = net.getLayer(l);
+		Layer& layer = m_layers[l - 1];
+		layer.numNeurons = source.getNeuronCount();
+		layer.numInputs = source.getInputCount();
+		layer.stride = GPaddedCount<int8_t>(layer.numInputs);
+		rangeToAffine(lo[l - 1], hi[l - 1], layer.inputScale, layer.inputZero);
+		layer.weights.resize(layer.numNeurons * layer.stride);
+		layer.scales.resize(layer.numNeurons);
+		layer.biases.resize(layer.numNeurons);
+		layer.zeroTerms.resize(layer.numNeurons);
+		layer.inputs.resize(layer.stride);
+		layer.sums.resize(layer.numNeurons);
+		widest = std::max(widest, layer.numNeurons);
+
+		double layerMax = 0.0;
+		for (size_t n = 0; n < layer.numNeurons; ++n)
+			for (size_t i = 0; i < layer.numInputs; ++i)
+				layerMax = std::max(layerMax, std::fabs(double(source.weight(n, i))));
+		for (size_t n = 0; n < layer.numNeurons; ++n) {
+			const T* w = source.weightRow(n);
+			double rowMax = layerMax;
+			if (granularity == QUANT_PER_ROW) {
+				rowMax = 0.0;
+				for (size_t i = 0; i < layer.numInputs; ++i)
+					rowMax = std::max(rowMax, std::fabs(double(w[i])));
+			}
+			const double weightScale = rowMax > 0.0 ? rowMax / 127.0 : 1.0;
+			int8_t* q = layer.weights.data() + n * layer.stride;
+			int32_t rowSum = 0;
+			for (size_t i = 0; i < layer.numInputs; ++i) {
+				q[i] = static_cast<int8_t>(std::max(-127L, std::min(127L, std::lround(double(w[i]) / weightScale))));
+				rowSum += q[i];
+			}
+			layer.scales[n] = float(double(layer.inputScale) * weightScale);
+			layer.biases[n] = float(w[layer.numInputs]);
+			layer.zeroTerms[n] = layer.inputZero * rowSum;
+		}
+	}
+	m_outputs.resize(GPaddedCount<float>(widest));
+	return true;
+}
+
+inline bool GQuantizedNet::quantize(InterfaceGNeuralNet& net, const double* samples, size_t count,
+	ENUM_QUANT_GRANULARITY granularity)
+{
+	if (GNeuralNetMatrix* matrix = dynamic_cast<GNeuralNetMatrix*>(&net))
+		return quantize(*matrix, samples, count, granularity);
+	if (GNeuralNetMatrixF* matrix = dynamic_cast<GNeuralNetMatrixF*>(&net))
+		return quantize(*matrix, samples, count, granularity);
+	std::cerr << "Error: only CPU matrix networks (GNeuralNetMatrix) can be quantized; "
+		"load the .nnw file into one, or save the network from one." << std::endl;
+	return false;
+}
+
+inline void GQuantizedNet::feedForward(const VectorDouble& inputVals)
+{
+	assert(isQuantized() && inputVals.size() == m_topology.front());
+	const GInt8Kernels& K = GSimd::Int8Kernels();
+	const GLayerKernelsT<float>& A = GSimd::Kernels<float>().forActivation(m_activation, m_precision);
+	float* out = m_outputs.data();
+	for (size_t i = 0; i < inputVals.size(); ++i)
+		out[i] = float(inputVals[i]);
+	quantizeRow(out, inputVals.size(), m_layers.front().inputScale, m_layers.front().inputZero, m_layers.front().inputs.data());
+
+	for (size_t l = 0; l < m_layers.size(); ++l) {
+		Layer& layer = m_layers[l];
+		K.dotRows(layer.weights.data(), layer.stride, layer.inputs.data(), layer.sums.data(), layer.numNeurons);
+		// Exact integer zero point correction, then one rounding to float
+		for (size_t n = 0; n < layer.numNeurons; ++n)
+			out[n] = float(layer.sums[n] - layer.zeroTerms[n]) * layer.scales[n] + layer.biases[n];
+		if (m_outputLayer == OUTPUT_SOFTMAX && l + 1 == m_layers.size())
+			GSimd::Softmax(out, layer.numNeurons, m_precision);
+		else
+			A.activate(out, layer.numNeurons);
+		if (l + 1 < m_layers.size())
+			quantizeRow(out, layer.numNeurons, m_layers[l + 1].inputScale, m_layers[l + 1].inputZero, m_layers[l + 1].inputs.data());
+	}
+}
+
+inline void GQuantizedNet::getResults(VectorDouble& resultVals) const
+{
+	assert(isQuantized());
+	resultVals.assign(m_outputs.data(), m_outputs.data() + m_layers.back().numNeurons);
+}
+
+inline GQuantizationReport GQuantizedNet::compare(InterfaceGNeuralNet& reference, const double* inputs, const double* targets, size_t count)
+{
+	assert(isQuantized());
+	const size_t numInputs = m_topology.front(), numOutputs = m_topology.back();
+	GQuantizationReport report;
+	report.samples = count;
+	if (!count)
+		return report;
+	VectorDouble row(numInputs), expected, actual;
+	double sumDiff = 0.0, referenceSq = 0.0, quantizedSq = 0.0;
+	size_t referenceHits = 0, quantizedHits = 0, agreeing = 0;
+	for (size_t s = 0; s < count; ++s) {
+		row.assign(inputs + s * numInputs, inputs + (s + 1) * numInputs);
+		reference.feedForward(row);
+		reference.getResults(expected);
+		feedForward(row);
+		getResults(actual);
+		const double* target = targets + s * numOutputs;
+		for (size_t o = 0; o < numOutputs; ++o) {
+			const double diff = std::fabs(actual[o] - expected[o]);
+			report.maxAbsDiff = std::max(report.maxAbsDiff, diff);
+			sumDiff += diff;
+			referenceSq += (expected[o] - target[o]) * (expected[o] - target[o]);
+			quantizedSq += (actual[o] - target[o]) * (actual[o] - target[o]);
+		}
+		if (numOutputs == 1) {
+			referenceHits += std::fabs(expected[0] - target[0]) < 0.5;
+			quantizedHits += std::fabs(actual[0] - target[0]) < 0.5;
+			agreeing += (std::fabs(expected[0] - target[0]) < 0.5) == (std::fabs(actual[0] - target[0]) < 0.5);
+		}
+		else {
+			const size_t want = argMax(target, numOutputs);
+			const size_t gotReference = argMax(expected.data(), numOutputs), gotQuantized = argMax(actual.data(), numOutputs);
+			referenceHits += gotReference == want;
+			quantizedHits += gotQuantized == want;
+			agreeing += gotReference == gotQuantized;
+		}
+	}
+	const double values = double(count * numOutputs);
+	report.meanAbsDiff = sumDiff / values;
+	report.referenceError = std::sqrt(referenceSq / values);
+	report.quantizedError = std::sqrt(quantizedSq / values);
+	report.referenceAccuracy = double(referenceHits) / count;
+	report.quantizedAccuracy = double(quantizedHits) / count;
+	report.agreement = double(agreeing) / count;
+	return report;
+}
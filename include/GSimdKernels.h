@@ -0,0 +1,1107 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include "GTypes.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define G_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC lets any function use any intrinsic; GCC/Clang need the ISA enabled per function.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define G_TARGET_SSE42
+#define G_TARGET_AVX2
+#define G_TARGET_AVX512
+#else
+#define G_TARGET_SSE42	__attribute__((target("sse4.2")))
+#define G_TARGET_AVX2	__attribute__((target("avx2,fma")))
+#define G_TARGET_AVX512	__attribute__((target("avx512f,avx2,fma")))
+#endif
+
+typedef enum
+{
+	SIMD_SCALAR = 0,
+	SIMD_SSE42 = 1,
+	SIMD_AVX2 = 2,		// AVX2 + FMA
+	SIMD_AVX512 = 3		// AVX-512F
+} ENUM_SIMD_LEVEL;
+
+/// <summary>
+/// Per-step constants of the adaptive optimizers. Adam's bias correction is already folded
+/// into 'rate', so the kernels stay a single pass over the weight row.
+/// </summary>
+struct GOptimizerStep
+{
+	double	rate;		// step size; Adam: lr * sqrt(1 - b2^t) / (1 - b1^t)
+	double	beta1;		// first moment decay; Nesterov: momentum
+	double	beta2;		// second moment decay; RMSProp: rho
+	double	epsilon;
+	double	decay;		// decoupled weight decay lr * wd (AdamW), 0 otherwise
+};
+
+/// <summary>
+/// Layer kernels compiled for one activation function. Nothing inside them switches on the
+/// activation or calls through a pointer per neuron, so a pass selects one set per layer and
+/// the per-neuron work is a straight loop.
+/// </summary>
+template<typename T>
+struct GLayerKernelsT
+{
+	// v[i] = f(v[i]) for a whole layer output array.
+	// ACTIVATION_FAST builds tanh/sigmoid on a vectorized polynomial exp; max abs error against
+	// libm over [-40, 40]: sigmoid 1.7e-9, tanh 3.4e-9 (RELU is exact).
+	void			(*activate)(T* v, size_t n);
+	// grad[i] *= f'(out[i]) with the derivative expressed through the neuron output.
+	void			(*multiplyDerivative)(const T* out, T* grad, size_t n);
+	// out[r] = f(dot(w + r * stride, x, stride)) for 'rows' consecutive weight rows.
+	void			(*forwardLayer)(const T* w, size_t stride, const T* x, T* out, size_t rows);
+};
+typedef GLayerKernelsT<double> GLayerKernels;
+
+/// <summary>
+/// Table of the vectorized kernels used by the CPU backend hot loops, for one scalar type
+/// (double or float). One table exists per type and instruction set level;
+/// GSimd::Kernels&lt;T&gt;() returns the active one.
+/// </summary>
+template<typename T>
+struct GSimdKernelsT
+{
+	ENUM_SIMD_LEVEL	level;
+	const char*		name;
+	// Returns sum(a[i] * b[i]) : one neuron's net input.
+	T				(*dot)(const T* a, const T* b, size_t n);
+	// y[i] += alpha * x[i] : accumulates one weight row into the hidden gradient sums (sumDOW).
+	void			(*axpy)(T alpha, const T* x, T* y, size_t n);
+	// dw[i] = eg * x[i] + alpha * dw[i]; w[i] += dw[i] : one row of the outer-product weight update.
+	void			(*momentumUpdate)(T* w, T* dw, const T* x, T eg, T alpha, size_t n);
+	// Optimizer row updates. The step direction is G[i] = scale * x[i] (the repo's gradient
+	// sign: positive G increases w). Each weight, moment and input is read and written once.
+	// Adam/AdamW: m = b1 m + (1-b1) G; v = b2 v + (1-b2) G^2; w = w (1 - decay) + rate m / (sqrt(v) + eps)
+	void			(*adamUpdate)(T* w, T* m, T* v, const T* x, T scale, const GOptimizerStep& step, size_t n);
+	// RMSProp: v = b2 v + (1-b2) G^2; w += rate G / (sqrt(v) + eps)
+	void			(*rmspropUpdate)(T* w, T* v, const T* x, T scale, const GOptimizerStep& step, size_t n);
+	// Nesterov: dw = b1 dw + rate G; w += b1 dw + rate G
+	void			(*nesterovUpdate)(T* w, T* dw, const T* x, T scale, const GOptimizerStep& step, size_t n);
+	// Activation kernels specialized per activation and precision, indexed [precision][activation].
+	GLayerKernelsT<T>	layers[2][3];
+
+	// Picks the specialized set once, outside the per-neuron loops. Unknown activation values
+	// fall back to SIGMOID, as the switch-based kernels did.
+	const GLayerKernelsT<T>&	forActivation(ENUM_ACTIVATION activation, ENUM_ACTIVATION_PRECISION precision) const
+	{
+		return layers[precision == ACTIVATION_FAST][activation == TANH || activation == RELU ? activation : SIGMOID];
+	}
+};
+typedef GSimdKernelsT<double> GSimdKernels;
+
+namespace GSimd
+{
+	namespace detail
+	{
+		// --- Scalar reference kernels, also used for tails and for non-x86 builds ---
+		// Templated on the scalar type; the float instantiations back GNeuralNetMatrixT<float>.
+		template<typename T> inline T dotScalar(const T* a, const T* b, size_t n)
+		{
+			T sum = T(0);
+			for (size_t i = 0; i < n; ++i)
+				sum += a[i] * b[i];
+			return sum;
+		}
+		template<typename T> inline void axpyScalar(T alpha, const T* x, T* y, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i)
+				y[i] += alpha * x[i];
+		}
+		template<typename T> inline void momentumUpdateScalar(T* w, T* dw, const T* x, T eg, T alpha, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i) {
+				dw[i] = eg * x[i] + alpha * dw[i];
+				w[i] += dw[i];
+			}
+		}
+		template<typename T> inline void adamUpdateScalar(T* w, T* m, T* v, const T* x, T scale, const GOptimizerStep& step, size_t n)
+		{
+			const T b1 = T(step.beta1), c1 = T(1.0 - step.beta1), b2 = T(step.beta2), c2 = T(1.0 - step.beta2);
+			const T rate = T(step.rate), eps = T(step.epsilon), keep = T(1.0 - step.decay);
+			for (size_t i = 0; i < n; ++i) {
+				const T g = scale * x[i];
+				m[i] = b1 * m[i] + c1 * g;
+				v[i] = b2 * v[i] + c2 * g * g;
+				w[i] = w[i] * keep + rate * m[i] / (std::sqrt(v[i]) + eps);
+			}
+		}
+		template<typename T> inline void rmspropUpdateScalar(T* w, T* v, const T* x, T scale, const GOptimizerStep& step, size_t n)
+		{
+			const T b2 = T(step.beta2), c2 = T(1.0 - step.beta2), rate = T(step.rate), eps = T(step.epsilon);
+			for (size_t i = 0; i < n; ++i) {
+				const T g = scale * x[i];
+				v[i] = b2 * v[i] + c2 * g * g;
+				w[i] += rate * g / (std::sqrt(v[i]) + eps);
+			}
+		}
+		template<typename T> inline void nesterovUpdateScalar(T* w, T* dw, const T* x, T scale, const GOptimizerStep& step, size_t n)
+		{
+			const T mu = T(step.beta1), rs = T(step.rate) * scale;
+			for (size_t i = 0; i < n; ++i) {
+				const T g = rs * x[i];
+				dw[i] = mu * dw[i] + g;
+				w[i] += mu * dw[i] + g;
+			}
+		}
+		// exp(x) = 2^k * p(r), x = k ln2 + r with |r| <= ln2/2; p is the degree-7 Taylor
+		// polynomial (relative error below 1e-8, 7e-9 at |r| = ln2/2). x is clamped to +-708,
+		// the double range.
+		constexpr double kExpLimit = 708.0;
+		constexpr double kLog2e = 1.4426950408889634;
+		constexpr double kLn2Hi = 0.693145751953125;
+		constexpr double kLn2Lo = 1.42860682030941723212e-6;
+		constexpr double kExpPoly[] = { 1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0, 1.0 / 6.0, 0.5, 1.0, 1.0 };
+		// Single precision: clamped to +-87 so 2^k stays a normal float; ln2 split for float.
+		constexpr float kExpLimitF = 87.0f;
+		constexpr float kLn2HiF = 0.693359375f;
+		constexpr float kLn2LoF = -2.12194440e-4f;
+		inline double expFastScalar(double x)
+		{
+			x = x < -kExpLimit ? -kExpLimit : (x > kExpLimit ? kExpLimit : x);
+			const double k = std::nearbyint(x * kLog2e);
+			const double r = (x - k * kLn2Hi) - k * kLn2Lo;
+			double p = kExpPoly[0];
+			for (size_t c = 1; c < sizeof(kExpPoly) / sizeof(kExpPoly[0]); ++c)
+				p = p * r + kExpPoly[c];
+			const long long bits = (static_cast<long long>(k) + 1023) << 52;
+			double scale;
+			memcpy(&scale, &bits, sizeof(scale));
+			return p * scale;
+		}
+		inline float expFastScalar(float x) { return static_cast<float>(expFastScalar(static_cast<double>(x))); }
+		// Activation kernels are templated on the activation (and on the exp flavour), so each
+		// instantiation is one straight loop: the A/Fast tests are compile-time constants.
+		template<ENUM_ACTIVATION A, bool Fast, typename T> inline T activateOne(T x)
+		{
+			if (A == RELU)	return x > T(0) ? x : T(0);
+			if (A == TANH)	return Fast ? T(1) - T(2) / (expFastScalar(T(2) * x) + T(1)) : std::tanh(x);
+			return T(1) / (T(1) + (Fast ? expFastScalar(-x) : std::exp(-x)));
+		}
+		template<ENUM_ACTIVATION A, typename T> inline T derivativeOne(T out, T grad)
+		{
+			if (A == RELU)	return out > T(0) ? grad : T(0);
+			if (A == TANH)	return grad * (T(1) - out * out);
+			return grad * (out * (T(1) - out));
+		}
+		template<ENUM_ACTIVATION A, bool Fast, typename T> inline void activateScalar(T* v, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i) v[i] = activateOne<A, Fast>(v[i]);
+		}
+		template<ENUM_ACTIVATION A, typename T> inline void multiplyDerivativeScalar(const T* out, T* grad, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i) grad[i] = derivativeOne<A>(out[i], grad[i]);
+		}
+		template<ENUM_ACTIVATION A, bool Fast, typename T> inline void forwardLayerScalar(const T* w, size_t stride, const T* x, T* out, size_t rows)
+		{
+			for (size_t r = 0; r < rows; ++r)
+				out[r] = dotScalar(w + r * stride, x, stride);
+			activateScalar<A, Fast>(out, rows);
+		}
+
+#ifdef G_SIMD_X86
+		// --- SSE4.2 (2 x double) ---
+		G_TARGET_SSE42 inline double dotSSE42(const double* a, const double* b, size_t n)
+		{
+			__m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+				acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+			}
+			acc0 = _mm_add_pd(acc0, acc1);
+			double sum = _mm_cvtsd_f64(_mm_add_sd(acc0, _mm_unpackhi_pd(acc0, acc0)));
+			return sum + dotScalar(a + i, b + i, n - i);
+		}
+		G_TARGET_SSE42 inline void axpySSE42(double alpha, const double* x, double* y, size_t n)
+		{
+			const __m128d va = _mm_set1_pd(alpha);
+			size_t i = 0;
+			for (; i + 2 <= n; i += 2)
+				_mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(va, _mm_loadu_pd(x + i))));
+			axpyScalar(alpha, x + i, y + i, n - i);
+		}
+		G_TARGET_SSE42 inline void momentumUpdateSSE42(double* w, double* dw, const double* x, double eg, double alpha, size_t n)
+		{
+			const __m128d veg = _mm_set1_pd(eg), valpha = _mm_set1_pd(alpha);
+			size_t i = 0;
+			for (; i + 2 <= n; i += 2) {
+				__m128d d = _mm_add_pd(_mm_mul_pd(veg, _mm_loadu_pd(x + i)), _mm_mul_pd(valpha, _mm_loadu_pd(dw + i)));
+				_mm_storeu_pd(dw + i, d);
+				_mm_storeu_pd(w + i, _mm_add_pd(_mm_loadu_pd(w + i), d));
+			}
+			momentumUpdateScalar(w + i, dw + i, x + i, eg, alpha, n - i);
+		}
+		G_TARGET_SSE42 inline void adamUpdateSSE42(double* w, double* m, double* v, const double* x, double scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m128d vs = _mm_set1_pd(scale), b1 = _mm_set1_pd(step.beta1), c1 = _mm_set1_pd(1.0 - step.beta1);
+			const __m128d b2 = _mm_set1_pd(step.beta2), c2 = _mm_set1_pd(1.0 - step.beta2);
+			const __m128d rate = _mm_set1_pd(step.rate), eps = _mm_set1_pd(step.epsilon), keep = _mm_set1_pd(1.0 - step.decay);
+			size_t i = 0;
+			for (; i + 2 <= n; i += 2) {
+				const __m128d g = _mm_mul_pd(vs, _mm_loadu_pd(x + i));
+				const __m128d mi = _mm_add_pd(_mm_mul_pd(b1, _mm_loadu_pd(m + i)), _mm_mul_pd(c1, g));
+				const __m128d vi = _mm_add_pd(_mm_mul_pd(b2, _mm_loadu_pd(v + i)), _mm_mul_pd(c2, _mm_mul_pd(g, g)));
+				const __m128d u = _mm_div_pd(_mm_mul_pd(rate, mi), _mm_add_pd(_mm_sqrt_pd(vi), eps));
+				_mm_storeu_pd(m + i, mi);
+				_mm_storeu_pd(v + i, vi);
+				_mm_storeu_pd(w + i, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(w + i), keep), u));
+			}
+			adamUpdateScalar(w + i, m + i, v + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_SSE42 inline void rmspropUpdateSSE42(double* w, double* v, const double* x, double scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m128d vs = _mm_set1_pd(scale), b2 = _mm_set1_pd(step.beta2), c2 = _mm_set1_pd(1.0 - step.beta2);
+			const __m128d rate = _mm_set1_pd(step.rate), eps = _mm_set1_pd(step.epsilon);
+			size_t i = 0;
+			for (; i + 2 <= n; i += 2) {
+				const __m128d g = _mm_mul_pd(vs, _mm_loadu_pd(x + i));
+				const __m128d vi = _mm_add_pd(_mm_mul_pd(b2, _mm_loadu_pd(v + i)), _mm_mul_pd(c2, _mm_mul_pd(g, g)));
+				_mm_storeu_pd(v + i, vi);
+				_mm_storeu_pd(w + i, _mm_add_pd(_mm_loadu_pd(w + i), _mm_div_pd(_mm_mul_pd(rate, g), _mm_add_pd(_mm_sqrt_pd(vi), eps))));
+			}
+			rmspropUpdateScalar(w + i, v + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_SSE42 inline void nesterovUpdateSSE42(double* w, double* dw, const double* x, double scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m128d rs = _mm_set1_pd(step.rate * scale), mu = _mm_set1_pd(step.beta1);
+			size_t i = 0;
+			for (; i + 2 <= n; i += 2) {
+				const __m128d g = _mm_mul_pd(rs, _mm_loadu_pd(x + i));
+				const __m128d d = _mm_add_pd(_mm_mul_pd(mu, _mm_loadu_pd(dw + i)), g);
+				_mm_storeu_pd(dw + i, d);
+				_mm_storeu_pd(w + i, _mm_add_pd(_mm_loadu_pd(w + i), _mm_add_pd(_mm_mul_pd(mu, d), g)));
+			}
+			nesterovUpdateScalar(w + i, dw + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_SSE42 inline __m128d expFastSSE42(__m128d x)
+		{
+			x = _mm_min_pd(_mm_max_pd(x, _mm_set1_pd(-kExpLimit)), _mm_set1_pd(kExpLimit));
+			const __m128d k = _mm_round_pd(_mm_mul_pd(x, _mm_set1_pd(kLog2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			const __m128d r = _mm_sub_pd(_mm_sub_pd(x, _mm_mul_pd(k, _mm_set1_pd(kLn2Hi))), _mm_mul_pd(k, _mm_set1_pd(kLn2Lo)));
+			__m128d p = _mm_set1_pd(kExpPoly[0]);
+			for (size_t c = 1; c < sizeof(kExpPoly) / sizeof(kExpPoly[0]); ++c)
+				p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(kExpPoly[c]));
+			const __m128i e = _mm_slli_epi64(_mm_add_epi64(_mm_cvtepi32_epi64(_mm_cvtpd_epi32(k)), _mm_set1_epi64x(1023)), 52);
+			return _mm_mul_pd(p, _mm_castsi128_pd(e));
+		}
+		template<ENUM_ACTIVATION A, bool Fast> G_TARGET_SSE42 inline void activateSSE42(double* v, size_t n)
+		{
+			const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1.0), two = _mm_set1_pd(2.0);
+			size_t i = 0;
+			// Exact tanh/sigmoid go through libm, one element at a time
+			if (A == RELU || Fast) {
+				for (; i + 2 <= n; i += 2) {
+					const __m128d x = _mm_loadu_pd(v + i);
+					__m128d y;
+					if (A == RELU)		y = _mm_max_pd(x, zero);
+					else if (A == TANH)	y = _mm_sub_pd(one, _mm_div_pd(two, _mm_add_pd(expFastSSE42(_mm_mul_pd(two, x)), one)));
+					else				y = _mm_div_pd(one, _mm_add_pd(one, expFastSSE42(_mm_sub_pd(zero, x))));
+					_mm_storeu_pd(v + i, y);
+				}
+			}
+			activateScalar<A, Fast>(v + i, n - i);
+		}
+		template<ENUM_ACTIVATION A> G_TARGET_SSE42 inline void multiplyDerivativeSSE42(const double* out, double* grad, size_t n)
+		{
+			const __m128d one = _mm_set1_pd(1.0), zero = _mm_setzero_pd();
+			size_t i = 0;
+			for (; i + 2 <= n; i += 2) {
+				__m128d o = _mm_loadu_pd(out + i), g = _mm_loadu_pd(grad + i), d;
+				if (A == TANH)		d = _mm_sub_pd(one, _mm_mul_pd(o, o));
+				else if (A == RELU)	d = _mm_and_pd(_mm_cmpgt_pd(o, zero), one);
+				else				d = _mm_mul_pd(o, _mm_sub_pd(one, o));
+				_mm_storeu_pd(grad + i, _mm_mul_pd(g, d));
+			}
+			multiplyDerivativeScalar<A>(out + i, grad + i, n - i);
+		}
+
+		// --- SSE4.2, single precision (4 x float) ---
+		G_TARGET_SSE42 inline float dotSSE42(const float* a, const float* b, size_t n)
+		{
+			__m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+				acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+			}
+			acc0 = _mm_add_ps(acc0, acc1);
+			acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+			acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+			return _mm_cvtss_f32(acc0) + dotScalar(a + i, b + i, n - i);
+		}
+		G_TARGET_SSE42 inline void axpySSE42(float alpha, const float* x, float* y, size_t n)
+		{
+			const __m128 va = _mm_set1_ps(alpha);
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+				_mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+			axpyScalar(alpha, x + i, y + i, n - i);
+		}
+		G_TARGET_SSE42 inline void momentumUpdateSSE42(float* w, float* dw, const float* x, float eg, float alpha, size_t n)
+		{
+			const __m128 veg = _mm_set1_ps(eg), valpha = _mm_set1_ps(alpha);
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				__m128 d = _mm_add_ps(_mm_mul_ps(veg, _mm_loadu_ps(x + i)), _mm_mul_ps(valpha, _mm_loadu_ps(dw + i)));
+				_mm_storeu_ps(dw + i, d);
+				_mm_storeu_ps(w + i, _mm_add_ps(_mm_loadu_ps(w + i), d));
+			}
+			momentumUpdateScalar(w + i, dw + i, x + i, eg, alpha, n - i);
+		}
+		G_TARGET_SSE42 inline void adamUpdateSSE42(float* w, float* m, float* v, const float* x, float scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m128 vs = _mm_set1_ps(scale), b1 = _mm_set1_ps(float(step.beta1)), c1 = _mm_set1_ps(float(1.0 - step.beta1));
+			const __m128 b2 = _mm_set1_ps(float(step.beta2)), c2 = _mm_set1_ps(float(1.0 - step.beta2));
+			const __m128 rate = _mm_set1_ps(float(step.rate)), eps = _mm_set1_ps(float(step.epsilon)), keep = _mm_set1_ps(float(1.0 - step.decay));
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				const __m128 g = _mm_mul_ps(vs, _mm_loadu_ps(x + i));
+				const __m128 mi = _mm_add_ps(_mm_mul_ps(b1, _mm_loadu_ps(m + i)), _mm_mul_ps(c1, g));
+				const __m128 vi = _mm_add_ps(_mm_mul_ps(b2, _mm_loadu_ps(v + i)), _mm_mul_ps(c2, _mm_mul_ps(g, g)));
+				const __m128 u = _mm_div_ps(_mm_mul_ps(rate, mi), _mm_add_ps(_mm_sqrt_ps(vi), eps));
+				_mm_storeu_ps(m + i, mi);
+				_mm_storeu_ps(v + i, vi);
+				_mm_storeu_ps(w + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(w + i), keep), u));
+			}
+			adamUpdateScalar(w + i, m + i, v + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_SSE42 inline void rmspropUpdateSSE42(float* w, float* v, const float* x, float scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m128 vs = _mm_set1_ps(scale), b2 = _mm_set1_ps(float(step.beta2)), c2 = _mm_set1_ps(float(1.0 - step.beta2));
+			const __m128 rate = _mm_set1_ps(float(step.rate)), eps = _mm_set1_ps(float(step.epsilon));
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				const __m128 g = _mm_mul_ps(vs, _mm_loadu_ps(x + i));
+				const __m128 vi = _mm_add_ps(_mm_mul_ps(b2, _mm_loadu_ps(v + i)), _mm_mul_ps(c2, _mm_mul_ps(g, g)));
+				_mm_storeu_ps(v + i, vi);
+				_mm_storeu_ps(w + i, _mm_add_ps(_mm_loadu_ps(w + i), _mm_div_ps(_mm_mul_ps(rate, g), _mm_add_ps(_mm_sqrt_ps(vi), eps))));
+			}
+			rmspropUpdateScalar(w + i, v + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_SSE42 inline void nesterovUpdateSSE42(float* w, float* dw, const float* x, float scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m128 rs = _mm_set1_ps(float(step.rate) * scale), mu = _mm_set1_ps(float(step.beta1));
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				const __m128 g = _mm_mul_ps(rs, _mm_loadu_ps(x + i));
+				const __m128 d = _mm_add_ps(_mm_mul_ps(mu, _mm_loadu_ps(dw + i)), g);
+				_mm_storeu_ps(dw + i, d);
+				_mm_storeu_ps(w + i, _mm_add_ps(_mm_loadu_ps(w + i), _mm_add_ps(_mm_mul_ps(mu, d), g)));
+			}
+			nesterovUpdateScalar(w + i, dw + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_SSE42 inline __m128 expFastSSE42(__m128 x)
+		{
+			x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-kExpLimitF)), _mm_set1_ps(kExpLimitF));
+			const __m128 k = _mm_round_ps(_mm_mul_ps(x, _mm_set1_ps(float(kLog2e))), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			const __m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(kLn2HiF))), _mm_mul_ps(k, _mm_set1_ps(kLn2LoF)));
+			__m128 p = _mm_set1_ps(float(kExpPoly[0]));
+			for (size_t c = 1; c < sizeof(kExpPoly) / sizeof(kExpPoly[0]); ++c)
+				p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(float(kExpPoly[c])));
+			const __m128i e = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(k), _mm_set1_epi32(127)), 23);
+			return _mm_mul_ps(p, _mm_castsi128_ps(e));
+		}
+		template<ENUM_ACTIVATION A, bool Fast> G_TARGET_SSE42 inline void activateSSE42(float* v, size_t n)
+		{
+			const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+			size_t i = 0;
+			if (A == RELU || Fast) {
+				for (; i + 4 <= n; i += 4) {
+					const __m128 x = _mm_loadu_ps(v + i);
+					__m128 y;
+					if (A == RELU)		y = _mm_max_ps(x, zero);
+					else if (A == TANH)	y = _mm_sub_ps(one, _mm_div_ps(two, _mm_add_ps(expFastSSE42(_mm_mul_ps(two, x)), one)));
+					else				y = _mm_div_ps(one, _mm_add_ps(one, expFastSSE42(_mm_sub_ps(zero, x))));
+					_mm_storeu_ps(v + i, y);
+				}
+			}
+			activateScalar<A, Fast>(v + i, n - i);
+		}
+		template<ENUM_ACTIVATION A> G_TARGET_SSE42 inline void multiplyDerivativeSSE42(const float* out, float* grad, size_t n)
+		{
+			const __m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				__m128 o = _mm_loadu_ps(out + i), g = _mm_loadu_ps(grad + i), d;
+				if (A == TANH)		d = _mm_sub_ps(one, _mm_mul_ps(o, o));
+				else if (A == RELU)	d = _mm_and_ps(_mm_cmpgt_ps(o, zero), one);
+				else				d = _mm_mul_ps(o, _mm_sub_ps(one, o));
+				_mm_storeu_ps(grad + i, _mm_mul_ps(g, d));
+			}
+			multiplyDerivativeScalar<A>(out + i, grad + i, n - i);
+		}
+		// Shared by both precisions; the row dot is called directly so it inlines.
+		template<ENUM_ACTIVATION A, bool Fast, typename T> G_TARGET_SSE42 inline void forwardLayerSSE42(const T* w, size_t stride, const T* x, T* out, size_t rows)
+		{
+			for (size_t r = 0; r < rows; ++r)
+				out[r] = dotSSE42(w + r * stride, x, stride);
+			activateSSE42<A, Fast>(out, rows);
+		}
+
+		// --- AVX2 + FMA (4 x double) ---
+		G_TARGET_AVX2 inline double dotAVX2(const double* a, const double* b, size_t n)
+		{
+			__m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+				acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+			}
+			for (; i + 4 <= n; i += 4)
+				acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+			acc0 = _mm256_add_pd(acc0, acc1);
+			__m128d s = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+			double sum = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+			return sum + dotScalar(a + i, b + i, n - i);
+		}
+		G_TARGET_AVX2 inline void axpyAVX2(double alpha, const double* x, double* y, size_t n)
+		{
+			const __m256d va = _mm256_set1_pd(alpha);
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+				_mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+			axpyScalar(alpha, x + i, y + i, n - i);
+		}
+		G_TARGET_AVX2 inline void momentumUpdateAVX2(double* w, double* dw, const double* x, double eg, double alpha, size_t n)
+		{
+			const __m256d veg = _mm256_set1_pd(eg), valpha = _mm256_set1_pd(alpha);
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				__m256d d = _mm256_fmadd_pd(veg, _mm256_loadu_pd(x + i), _mm256_mul_pd(valpha, _mm256_loadu_pd(dw + i)));
+				_mm256_storeu_pd(dw + i, d);
+				_mm256_storeu_pd(w + i, _mm256_add_pd(_mm256_loadu_pd(w + i), d));
+			}
+			momentumUpdateScalar(w + i, dw + i, x + i, eg, alpha, n - i);
+		}
+		G_TARGET_AVX2 inline void adamUpdateAVX2(double* w, double* m, double* v, const double* x, double scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m256d vs = _mm256_set1_pd(scale), b1 = _mm256_set1_pd(step.beta1), c1 = _mm256_set1_pd(1.0 - step.beta1);
+			const __m256d b2 = _mm256_set1_pd(step.beta2), c2 = _mm256_set1_pd(1.0 - step.beta2);
+			const __m256d rate = _mm256_set1_pd(step.rate), eps = _mm256_set1_pd(step.epsilon), keep = _mm256_set1_pd(1.0 - step.decay);
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				const __m256d g = _mm256_mul_pd(vs, _mm256_loadu_pd(x + i));
+				const __m256d mi = _mm256_fmadd_pd(b1, _mm256_loadu_pd(m + i), _mm256_mul_pd(c1, g));
+				const __m256d vi = _mm256_fmadd_pd(b2, _mm256_loadu_pd(v + i), _mm256_mul_pd(c2, _mm256_mul_pd(g, g)));
+				const __m256d u = _mm256_div_pd(_mm256_mul_pd(rate, mi), _mm256_add_pd(_mm256_sqrt_pd(vi), eps));
+				_mm256_storeu_pd(m + i, mi);
+				_mm256_storeu_pd(v + i, vi);
+				_mm256_storeu_pd(w + i, _mm256_fmadd_pd(_mm256_loadu_pd(w + i), keep, u));
+			}
+			adamUpdateScalar(w + i, m + i, v + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_AVX2 inline void rmspropUpdateAVX2(double* w, double* v, const double* x, double scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m256d vs = _mm256_set1_pd(scale), b2 = _mm256_set1_pd(step.beta2), c2 = _mm256_set1_pd(1.0 - step.beta2);
+			const __m256d rate = _mm256_set1_pd(step.rate), eps = _mm256_set1_pd(step.epsilon);
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				const __m256d g = _mm256_mul_pd(vs, _mm256_loadu_pd(x + i));
+				const __m256d vi = _mm256_fmadd_pd(b2, _mm256_loadu_pd(v + i), _mm256_mul_pd(c2, _mm256_mul_pd(g, g)));
+				_mm256_storeu_pd(v + i, vi);
+				_mm256_storeu_pd(w + i, _mm256_add_pd(_mm256_loadu_pd(w + i),
+					_mm256_div_pd(_mm256_mul_pd(rate, g), _mm256_add_pd(_mm256_sqrt_pd(vi), eps))));
+			}
+			rmspropUpdateScalar(w + i, v + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_AVX2 inline void nesterovUpdateAVX2(double* w, double* dw, const double* x, double scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m256d rs = _mm256_set1_pd(step.rate * scale), mu = _mm256_set1_pd(step.beta1);
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				const __m256d g = _mm256_mul_pd(rs, _mm256_loadu_pd(x + i));
+				const __m256d d = _mm256_fmadd_pd(mu, _mm256_loadu_pd(dw + i), g);
+				_mm256_storeu_pd(dw + i, d);
+				_mm256_storeu_pd(w + i, _mm256_add_pd(_mm256_loadu_pd(w + i), _mm256_fmadd_pd(mu, d, g)));
+			}
+			nesterovUpdateScalar(w + i, dw + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_AVX2 inline __m256d expFastAVX2(__m256d x)
+		{
+			x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(-kExpLimit)), _mm256_set1_pd(kExpLimit));
+			const __m256d k = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(kLog2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			const __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(kLn2Lo), _mm256_fnmadd_pd(k, _mm256_set1_pd(kLn2Hi), x));
+			__m256d p = _mm256_set1_pd(kExpPoly[0]);
+			for (size_t c = 1; c < sizeof(kExpPoly) / sizeof(kExpPoly[0]); ++c)
+				p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(kExpPoly[c]));
+			const __m256i e = _mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k)), _mm256_set1_epi64x(1023)), 52);
+			return _mm256_mul_pd(p, _mm256_castsi256_pd(e));
+		}
+		template<ENUM_ACTIVATION A, bool Fast> G_TARGET_AVX2 inline void activateAVX2(double* v, size_t n)
+		{
+			const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0), two = _mm256_set1_pd(2.0);
+			size_t i = 0;
+			if (A == RELU || Fast) {
+				for (; i + 4 <= n; i += 4) {
+					const __m256d x = _mm256_loadu_pd(v + i);
+					__m256d y;
+					if (A == RELU)		y = _mm256_max_pd(x, zero);
+					else if (A == TANH)	y = _mm256_sub_pd(one, _mm256_div_pd(two, _mm256_add_pd(expFastAVX2(_mm256_mul_pd(two, x)), one)));
+					else				y = _mm256_div_pd(one, _mm256_add_pd(one, expFastAVX2(_mm256_sub_pd(zero, x))));
+					_mm256_storeu_pd(v + i, y);
+				}
+			}
+			activateScalar<A, Fast>(v + i, n - i);
+		}
+		template<ENUM_ACTIVATION A> G_TARGET_AVX2 inline void multiplyDerivativeAVX2(const double* out, double* grad, size_t n)
+		{
+			const __m256d one = _mm256_set1_pd(1.0), zero = _mm256_setzero_pd();
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				__m256d o = _mm256_loadu_pd(out + i), g = _mm256_loadu_pd(grad + i), d;
+				if (A == TANH)		d = _mm256_fnmadd_pd(o, o, one);
+				else if (A == RELU)	d = _mm256_and_pd(_mm256_cmp_pd(o, zero, _CMP_GT_OQ), one);
+				else				d = _mm256_mul_pd(o, _mm256_sub_pd(one, o));
+				_mm256_storeu_pd(grad + i, _mm256_mul_pd(g, d));
+			}
+			multiplyDerivativeScalar<A>(out + i, grad + i, n - i);
+		}
+
+		// --- AVX2 + FMA, single precision (8 x float) ---
+		G_TARGET_AVX2 inline float dotAVX2(const float* a, const float* b, size_t n)
+		{
+			__m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+				acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+			}
+			for (; i + 8 <= n; i += 8)
+				acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+			acc0 = _mm256_add_ps(acc0, acc1);
+			__m128 s = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+			s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			return _mm_cvtss_f32(s) + dotScalar(a + i, b + i, n - i);
+		}
+		G_TARGET_AVX2 inline void axpyAVX2(float alpha, const float* x, float* y, size_t n)
+		{
+			const __m256 va = _mm256_set1_ps(alpha);
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8)
+				_mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+			axpyScalar(alpha, x + i, y + i, n - i);
+		}
+		G_TARGET_AVX2 inline void momentumUpdateAVX2(float* w, float* dw, const float* x, float eg, float alpha, size_t n)
+		{
+			const __m256 veg = _mm256_set1_ps(eg), valpha = _mm256_set1_ps(alpha);
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				__m256 d = _mm256_fmadd_ps(veg, _mm256_loadu_ps(x + i), _mm256_mul_ps(valpha, _mm256_loadu_ps(dw + i)));
+				_mm256_storeu_ps(dw + i, d);
+				_mm256_storeu_ps(w + i, _mm256_add_ps(_mm256_loadu_ps(w + i), d));
+			}
+			momentumUpdateScalar(w + i, dw + i, x + i, eg, alpha, n - i);
+		}
+		G_TARGET_AVX2 inline void adamUpdateAVX2(float* w, float* m, float* v, const float* x, float scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m256 vs = _mm256_set1_ps(scale), b1 = _mm256_set1_ps(float(step.beta1)), c1 = _mm256_set1_ps(float(1.0 - step.beta1));
+			const __m256 b2 = _mm256_set1_ps(float(step.beta2)), c2 = _mm256_set1_ps(float(1.0 - step.beta2));
+			const __m256 rate = _mm256_set1_ps(float(step.rate)), eps = _mm256_set1_ps(float(step.epsilon)), keep = _mm256_set1_ps(float(1.0 - step.decay));
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				const __m256 g = _mm256_mul_ps(vs, _mm256_loadu_ps(x + i));
+				const __m256 mi = _mm256_fmadd_ps(b1, _mm256_loadu_ps(m + i), _mm256_mul_ps(c1, g));
+				const __m256 vi = _mm256_fmadd_ps(b2, _mm256_loadu_ps(v + i), _mm256_mul_ps(c2, _mm256_mul_ps(g, g)));
+				const __m256 u = _mm256_div_ps(_mm256_mul_ps(rate, mi), _mm256_add_ps(_mm256_sqrt_ps(vi), eps));
+				_mm256_storeu_ps(m + i, mi);
+				_mm256_storeu_ps(v + i, vi);
+				_mm256_storeu_ps(w + i, _mm256_fmadd_ps(_mm256_loadu_ps(w + i), keep, u));
+			}
+			adamUpdateScalar(w + i, m + i, v + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_AVX2 inline void rmspropUpdateAVX2(float* w, float* v, const float* x, float scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m256 vs = _mm256_set1_ps(scale), b2 = _mm256_set1_ps(float(step.beta2)), c2 = _mm256_set1_ps(float(1.0 - step.beta2));
+			const __m256 rate = _mm256_set1_ps(float(step.rate)), eps = _mm256_set1_ps(float(step.epsilon));
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				const __m256 g = _mm256_mul_ps(vs, _mm256_loadu_ps(x + i));
+				const __m256 vi = _mm256_fmadd_ps(b2, _mm256_loadu_ps(v + i), _mm256_mul_ps(c2, _mm256_mul_ps(g, g)));
+				_mm256_storeu_ps(v + i, vi);
+				_mm256_storeu_ps(w + i, _mm256_add_ps(_mm256_loadu_ps(w + i),
+					_mm256_div_ps(_mm256_mul_ps(rate, g), _mm256_add_ps(_mm256_sqrt_ps(vi), eps))));
+			}
+			rmspropUpdateScalar(w + i, v + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_AVX2 inline void nesterovUpdateAVX2(float* w, float* dw, const float* x, float scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m256 rs = _mm256_set1_ps(float(step.rate) * scale), mu = _mm256_set1_ps(float(step.beta1));
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				const __m256 g = _mm256_mul_ps(rs, _mm256_loadu_ps(x + i));
+				const __m256 d = _mm256_fmadd_ps(mu, _mm256_loadu_ps(dw + i), g);
+				_mm256_storeu_ps(dw + i, d);
+				_mm256_storeu_ps(w + i, _mm256_add_ps(_mm256_loadu_ps(w + i), _mm256_fmadd_ps(mu, d, g)));
+			}
+			nesterovUpdateScalar(w + i, dw + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_AVX2 inline __m256 expFastAVX2(__m256 x)
+		{
+			x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-kExpLimitF)), _mm256_set1_ps(kExpLimitF));
+			const __m256 k = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(float(kLog2e))), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			const __m256 r = _mm256_fnmadd_ps(k, _mm256_set1_ps(kLn2LoF), _mm256_fnmadd_ps(k, _mm256_set1_ps(kLn2HiF), x));
+			__m256 p = _mm256_set1_ps(float(kExpPoly[0]));
+			for (size_t c = 1; c < sizeof(kExpPoly) / sizeof(kExpPoly[0]); ++c)
+				p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(float(kExpPoly[c])));
+			const __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(k), _mm256_set1_epi32(127)), 23);
+			return _mm256_mul_ps(p, _mm256_castsi256_ps(e));
+		}
+		template<ENUM_ACTIVATION A, bool Fast> G_TARGET_AVX2 inline void activateAVX2(float* v, size_t n)
+		{
+			const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f);
+			size_t i = 0;
+			if (A == RELU || Fast) {
+				for (; i + 8 <= n; i += 8) {
+					const __m256 x = _mm256_loadu_ps(v + i);
+					__m256 y;
+					if (A == RELU)		y = _mm256_max_ps(x, zero);
+					else if (A == TANH)	y = _mm256_sub_ps(one, _mm256_div_ps(two, _mm256_add_ps(expFastAVX2(_mm256_mul_ps(two, x)), one)));
+					else				y = _mm256_div_ps(one, _mm256_add_ps(one, expFastAVX2(_mm256_sub_ps(zero, x))));
+					_mm256_storeu_ps(v + i, y);
+				}
+			}
+			activateScalar<A, Fast>(v + i, n - i);
+		}
+		template<ENUM_ACTIVATION A> G_TARGET_AVX2 inline void multiplyDerivativeAVX2(const float* out, float* grad, size_t n)
+		{
+			const __m256 one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps();
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				__m256 o = _mm256_loadu_ps(out + i), g = _mm256_loadu_ps(grad + i), d;
+				if (A == TANH)		d = _mm256_fnmadd_ps(o, o, one);
+				else if (A == RELU)	d = _mm256_and_ps(_mm256_cmp_ps(o, zero, _CMP_GT_OQ), one);
+				else				d = _mm256_mul_ps(o, _mm256_sub_ps(one, o));
+				_mm256_storeu_ps(grad + i, _mm256_mul_ps(g, d));
+			}
+			multiplyDerivativeScalar<A>(out + i, grad + i, n - i);
+		}
+		template<ENUM_ACTIVATION A, bool Fast, typename T> G_TARGET_AVX2 inline void forwardLayerAVX2(const T* w, size_t stride, const T* x, T* out, size_t rows)
+		{
+			for (size_t r = 0; r < rows; ++r)
+				out[r] = dotAVX2(w + r * stride, x, stride);
+			activateAVX2<A, Fast>(out, rows);
+		}
+
+		// --- AVX-512F (8 x double) ---
+		G_TARGET_AVX512 inline double dotAVX512(const double* a, const double* b, size_t n)
+		{
+			__m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+				acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), acc1);
+			}
+			for (; i + 8 <= n; i += 8)
+				acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+			double sum = _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+			return sum + dotScalar(a + i, b + i, n - i);
+		}
+		G_TARGET_AVX512 inline void axpyAVX512(double alpha, const double* x, double* y, size_t n)
+		{
+			const __m512d va = _mm512_set1_pd(alpha);
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8)
+				_mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+			axpyScalar(alpha, x + i, y + i, n - i);
+		}
+		G_TARGET_AVX512 inline void momentumUpdateAVX512(double* w, double* dw, const double* x, double eg, double alpha, size_t n)
+		{
+			const __m512d veg = _mm512_set1_pd(eg), valpha = _mm512_set1_pd(alpha);
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				__m512d d = _mm512_fmadd_pd(veg, _mm512_loadu_pd(x + i), _mm512_mul_pd(valpha, _mm512_loadu_pd(dw + i)));
+				_mm512_storeu_pd(dw + i, d);
+				_mm512_storeu_pd(w + i, _mm512_add_pd(_mm512_loadu_pd(w + i), d));
+			}
+			momentumUpdateScalar(w + i, dw + i, x + i, eg, alpha, n - i);
+		}
+		G_TARGET_AVX512 inline void adamUpdateAVX512(double* w, double* m, double* v, const double* x, double scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m512d vs = _mm512_set1_pd(scale), b1 = _mm512_set1_pd(step.beta1), c1 = _mm512_set1_pd(1.0 - step.beta1);
+			const __m512d b2 = _mm512_set1_pd(step.beta2), c2 = _mm512_set1_pd(1.0 - step.beta2);
+			const __m512d rate = _mm512_set1_pd(step.rate), eps = _mm512_set1_pd(step.epsilon), keep = _mm512_set1_pd(1.0 - step.decay);
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				const __m512d g = _mm512_mul_pd(vs, _mm512_loadu_pd(x + i));
+				const __m512d mi = _mm512_fmadd_pd(b1, _mm512_loadu_pd(m + i), _mm512_mul_pd(c1, g));
+				const __m512d vi = _mm512_fmadd_pd(b2, _mm512_loadu_pd(v + i), _mm512_mul_pd(c2, _mm512_mul_pd(g, g)));
+				const __m512d u = _mm512_div_pd(_mm512_mul_pd(rate, mi), _mm512_add_pd(_mm512_sqrt_pd(vi), eps));
+				_mm512_storeu_pd(m + i, mi);
+				_mm512_storeu_pd(v + i, vi);
+				_mm512_storeu_pd(w + i, _mm512_fmadd_pd(_mm512_loadu_pd(w + i), keep, u));
+			}
+			adamUpdateScalar(w + i, m + i, v + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_AVX512 inline void rmspropUpdateAVX512(double* w, double* v, const double* x, double scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m512d vs = _mm512_set1_pd(scale), b2 = _mm512_set1_pd(step.beta2), c2 = _mm512_set1_pd(1.0 - step.beta2);
+			const __m512d rate = _mm512_set1_pd(step.rate), eps = _mm512_set1_pd(step.epsilon);
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				const __m512d g = _mm512_mul_pd(vs, _mm512_loadu_pd(x + i));
+				const __m512d vi = _mm512_fmadd_pd(b2, _mm512_loadu_pd(v + i), _mm512_mul_pd(c2, _mm512_mul_pd(g, g)));
+				_mm512_storeu_pd(v + i, vi);
+				_mm512_storeu_pd(w + i, _mm512_add_pd(_mm512_loadu_pd(w + i),
+					_mm512_div_pd(_mm512_mul_pd(rate, g), _mm512_add_pd(_mm512_sqrt_pd(vi), eps))));
+			}
+			rmspropUpdateScalar(w + i, v + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_AVX512 inline void nesterovUpdateAVX512(double* w, double* dw, const double* x, double scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m512d rs = _mm512_set1_pd(step.rate * scale), mu = _mm512_set1_pd(step.beta1);
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				const __m512d g = _mm512_mul_pd(rs, _mm512_loadu_pd(x + i));
+				const __m512d d = _mm512_fmadd_pd(mu, _mm512_loadu_pd(dw + i), g);
+				_mm512_storeu_pd(dw + i, d);
+				_mm512_storeu_pd(w + i, _mm512_add_pd(_mm512_loadu_pd(w + i), _mm512_fmadd_pd(mu, d, g)));
+			}
+			nesterovUpdateScalar(w + i, dw + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_AVX512 inline __m512d expFastAVX512(__m512d x)
+		{
+			x = _mm512_min_pd(_mm512_max_pd(x, _mm512_set1_pd(-kExpLimit)), _mm512_set1_pd(kExpLimit));
+			const __m512d k = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(kLog2e)), _MM_FROUND_TO_NEAREST_INT);
+			const __m512d r = _mm512_fnmadd_pd(k, _mm512_set1_pd(kLn2Lo), _mm512_fnmadd_pd(k, _mm512_set1_pd(kLn2Hi), x));
+			__m512d p = _mm512_set1_pd(kExpPoly[0]);
+			for (size_t c = 1; c < sizeof(kExpPoly) / sizeof(kExpPoly[0]); ++c)
+				p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(kExpPoly[c]));
+			return _mm512_scalef_pd(p, k);
+		}
+		template<ENUM_ACTIVATION A, bool Fast> G_TARGET_AVX512 inline void activateAVX512(double* v, size_t n)
+		{
+			const __m512d zero = _mm512_setzero_pd(), one = _mm512_set1_pd(1.0), two = _mm512_set1_pd(2.0);
+			size_t i = 0;
+			if (A == RELU || Fast) {
+				for (; i + 8 <= n; i += 8) {
+					const __m512d x = _mm512_loadu_pd(v + i);
+					__m512d y;
+					if (A == RELU)		y = _mm512_max_pd(x, zero);
+					else if (A == TANH)	y = _mm512_sub_pd(one, _mm512_div_pd(two, _mm512_add_pd(expFastAVX512(_mm512_mul_pd(two, x)), one)));
+					else				y = _mm512_div_pd(one, _mm512_add_pd(one, expFastAVX512(_mm512_sub_pd(zero, x))));
+					_mm512_storeu_pd(v + i, y);
+				}
+			}
+			activateScalar<A, Fast>(v + i, n - i);
+		}
+		template<ENUM_ACTIVATION A> G_TARGET_AVX512 inline void multiplyDerivativeAVX512(const double* out, double* grad, size_t n)
+		{
+			const __m512d one = _mm512_set1_pd(1.0), zero = _mm512_setzero_pd();
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				__m512d o = _mm512_loadu_pd(out + i), g = _mm512_loadu_pd(grad + i);
+				if (A == TANH)		g = _mm512_mul_pd(g, _mm512_fnmadd_pd(o, o, one));
+				else if (A == RELU)	g = _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(o, zero, _CMP_GT_OQ), g);
+				else				g = _mm512_mul_pd(g, _mm512_mul_pd(o, _mm512_sub_pd(one, o)));
+				_mm512_storeu_pd(grad + i, g);
+			}
+			multiplyDerivativeScalar<A>(out + i, grad + i, n - i);
+		}
+
+		// --- AVX-512F, single precision (16 x float) ---
+		G_TARGET_AVX512 inline float dotAVX512(const float* a, const float* b, size_t n)
+		{
+			__m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+			size_t i = 0;
+			for (; i + 32 <= n; i += 32) {
+				acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+				acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+			}
+			for (; i + 16 <= n; i += 16)
+				acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+			float sum = _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+			return sum + dotScalar(a + i, b + i, n - i);
+		}
+		G_TARGET_AVX512 inline void axpyAVX512(float alpha, const float* x, float* y, size_t n)
+		{
+			const __m512 va = _mm512_set1_ps(alpha);
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16)
+				_mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+			axpyScalar(alpha, x + i, y + i, n - i);
+		}
+		G_TARGET_AVX512 inline void momentumUpdateAVX512(float* w, float* dw, const float* x, float eg, float alpha, size_t n)
+		{
+			const __m512 veg = _mm512_set1_ps(eg), valpha = _mm512_set1_ps(alpha);
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				__m512 d = _mm512_fmadd_ps(veg, _mm512_loadu_ps(x + i), _mm512_mul_ps(valpha, _mm512_loadu_ps(dw + i)));
+				_mm512_storeu_ps(dw + i, d);
+				_mm512_storeu_ps(w + i, _mm512_add_ps(_mm512_loadu_ps(w + i), d));
+			}
+			momentumUpdateScalar(w + i, dw + i, x + i, eg, alpha, n - i);
+		}
+		G_TARGET_AVX512 inline void adamUpdateAVX512(float* w, float* m, float* v, const float* x, float scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m512 vs = _mm512_set1_ps(scale), b1 = _mm512_set1_ps(float(step.beta1)), c1 = _mm512_set1_ps(float(1.0 - step.beta1));
+			const __m512 b2 = _mm512_set1_ps(float(step.beta2)), c2 = _mm512_set1_ps(float(1.0 - step.beta2));
+			const __m512 rate = _mm512_set1_ps(float(step.rate)), eps = _mm512_set1_ps(float(step.epsilon)), keep = _mm512_set1_ps(float(1.0 - step.decay));
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				const __m512 g = _mm512_mul_ps(vs, _mm512_loadu_ps(x + i));
+				const __m512 mi = _mm512_fmadd_ps(b1, _mm512_loadu_ps(m + i), _mm512_mul_ps(c1, g));
+				const __m512 vi = _mm512_fmadd_ps(b2, _mm512_loadu_ps(v + i), _mm512_mul_ps(c2, _mm512_mul_ps(g, g)));
+				const __m512 u = _mm512_div_ps(_mm512_mul_ps(rate, mi), _mm512_add_ps(_mm512_sqrt_ps(vi), eps));
+				_mm512_storeu_ps(m + i, mi);
+				_mm512_storeu_ps(v + i, vi);
+				_mm512_storeu_ps(w + i, _mm512_fmadd_ps(_mm512_loadu_ps(w + i), keep, u));
+			}
+			adamUpdateScalar(w + i, m + i, v + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_AVX512 inline void rmspropUpdateAVX512(float* w, float* v, const float* x, float scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m512 vs = _mm512_set1_ps(scale), b2 = _mm512_set1_ps(float(step.beta2)), c2 = _mm512_set1_ps(float(1.0 - step.beta2));
+			const __m512 rate = _mm512_set1_ps(float(step.rate)), eps = _mm512_set1_ps(float(step.epsilon));
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				const __m512 g = _mm512_mul_ps(vs, _mm512_loadu_ps(x + i));
+				const __m512 vi = _mm512_fmadd_ps(b2, _mm512_loadu_ps(v + i), _mm512_mul_ps(c2, _mm512_mul_ps(g, g)));
+				_mm512_storeu_ps(v + i, vi);
+				_mm512_storeu_ps(w + i, _mm512_add_ps(_mm512_loadu_ps(w + i),
+					_mm512_div_ps(_mm512_mul_ps(rate, g), _mm512_add_ps(_mm512_sqrt_ps(vi), eps))));
+			}
+			rmspropUpdateScalar(w + i, v + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_AVX512 inline void nesterovUpdateAVX512(float* w, float* dw, const float* x, float scale, const GOptimizerStep& step, size_t n)
+		{
+			const __m512 rs = _mm512_set1_ps(float(step.rate) * scale), mu = _mm512_set1_ps(float(step.beta1));
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				const __m512 g = _mm512_mul_ps(rs, _mm512_loadu_ps(x + i));
+				const __m512 d = _mm512_fmadd_ps(mu, _mm512_loadu_ps(dw + i), g);
+				_mm512_storeu_ps(dw + i, d);
+				_mm512_storeu_ps(w + i, _mm512_add_ps(_mm512_loadu_ps(w + i), _mm512_fmadd_ps(mu, d, g)));
+			}
+			nesterovUpdateScalar(w + i, dw + i, x + i, scale, step, n - i);
+		}
+		G_TARGET_AVX512 inline __m512 expFastAVX512(__m512 x)
+		{
+			x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(-kExpLimitF)), _mm512_set1_ps(kExpLimitF));
+			const __m512 k = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(float(kLog2e))), _MM_FROUND_TO_NEAREST_INT);
+			const __m512 r = _mm512_fnmadd_ps(k, _mm512_set1_ps(kLn2LoF), _mm512_fnmadd_ps(k, _mm512_set1_ps(kLn2HiF), x));
+			__m512 p = _mm512_set1_ps(float(kExpPoly[0]));
+			for (size_t c = 1; c < sizeof(kExpPoly) / sizeof(kExpPoly[0]); ++c)
+				p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(float(kExpPoly[c])));
+			return _mm512_scalef_ps(p, k);
+		}
+		template<ENUM_ACTIVATION A, bool Fast> G_TARGET_AVX512 inline void activateAVX512(float* v, size_t n)
+		{
+			const __m512 zero = _mm512_setzero_ps(), one = _mm512_set1_ps(1.0f), two = _mm512_set1_ps(2.0f);
+			size_t i = 0;
+			if (A == RELU || Fast) {
+				for (; i + 16 <= n; i += 16) {
+					const __m512 x = _mm512_loadu_ps(v + i);
+					__m512 y;
+					if (A == RELU)		y = _mm512_max_ps(x, zero);
+					else if (A == TANH)	y = _mm512_sub_ps(one, _mm512_div_ps(two, _mm512_add_ps(expFastAVX512(_mm512_mul_ps(two, x)), one)));
+					else				y = _mm512_div_ps(one, _mm512_add_ps(one, expFastAVX512(_mm512_sub_ps(zero, x))));
+					_mm512_storeu_ps(v + i, y);
+				}
+			}
+			activateScalar<A, Fast>(v + i, n - i);
+		}
+		template<ENUM_ACTIVATION A> G_TARGET_AVX512 inline void multiplyDerivativeAVX512(const float* out, float* grad, size_t n)
+		{
+			const __m512 one = _mm512_set1_ps(1.0f), zero = _mm512_setzero_ps();
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				__m512 o = _mm512_loadu_ps(out + i), g = _mm512_loadu_ps(grad + i);
+				if (A == TANH)		g = _mm512_mul_ps(g, _mm512_fnmadd_ps(o, o, one));
+				else if (A == RELU)	g = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(o, zero, _CMP_GT_OQ), g);
+				else				g = _mm512_mul_ps(g, _mm512_mul_ps(o, _mm512_sub_ps(one, o)));
+				_mm512_storeu_ps(grad + i, g);
+			}
+			multiplyDerivativeScalar<A>(out + i, grad + i, n - i);
+		}
+		template<ENUM_ACTIVATION A, bool Fast, typename T> G_TARGET_AVX512 inline void forwardLayerAVX512(const T* w, size_t stride, const T* x, T* out, size_t rows)
+		{
+			for (size_t r = 0; r < rows; ++r)
+				out[r] = dotAVX512(w + r * stride, x, stride);
+			activateAVX512<A, Fast>(out, rows);
+		}
+
+		inline void cpuid(int leaf, int subleaf, unsigned regs[4])
+		{
+#if defined(_MSC_VER)
+			int r[4];
+			__cpuidex(r, leaf, subleaf);
+			for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned>(r[i]);
+#else
+			__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+		}
+		inline unsigned long long xgetbv0()
+		{
+#if defined(_MSC_VER)
+			return _xgetbv(0);
+#else
+			unsigned eax, edx;
+			__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+		}
+#endif // G_SIMD_X86
+
+		// One GLayerKernels entry of a level, and its [precision][activation] block.
+#define G_LAYER_KERNELS(L, A, F)	{ activate##L<A, F>, multiplyDerivative##L<A>, forwardLayer##L<A, F> }
+#define G_LAYER_TABLE(L)	{ { G_LAYER_KERNELS(L, TANH, false), G_LAYER_KERNELS(L, SIGMOID, false), G_LAYER_KERNELS(L, RELU, false) }, \
+							  { G_LAYER_KERNELS(L, TANH, true), G_LAYER_KERNELS(L, SIGMOID, true), G_LAYER_KERNELS(L, RELU, true) } }
+		// The kernel names are overloaded on double/float; the member types pick the precision.
+		template<typename T> inline const GSimdKernelsT<T>& table(ENUM_SIMD_LEVEL level)
+		{
+			static const GSimdKernelsT<T> tables[] = {
+				{ SIMD_SCALAR, "scalar", dotScalar, axpyScalar, momentumUpdateScalar,
+					adamUpdateScalar, rmspropUpdateScalar, nesterovUpdateScalar, G_LAYER_TABLE(Scalar) },
+#ifdef G_SIMD_X86
+				{ SIMD_SSE42, "sse4.2", dotSSE42, axpySSE42, momentumUpdateSSE42,
+					adamUpdateSSE42, rmspropUpdateSSE42, nesterovUpdateSSE42, G_LAYER_TABLE(SSE42) },
+				{ SIMD_AVX2, "avx2+fma", dotAVX2, axpyAVX2, momentumUpdateAVX2,
+					adamUpdateAVX2, rmspropUpdateAVX2, nesterovUpdateAVX2, G_LAYER_TABLE(AVX2) },
+				{ SIMD_AVX512, "avx512f", dotAVX512, axpyAVX512, momentumUpdateAVX512,
+					adamUpdateAVX512, rmspropUpdateAVX512, nesterovUpdateAVX512, G_LAYER_TABLE(AVX512) },
+#endif
+			};
+			return tables[level];
+		}
+#undef G_LAYER_TABLE
+#undef G_LAYER_KERNELS
+
+		inline ENUM_SIMD_LEVEL parseLevel(const char* text, ENUM_SIMD_LEVEL fallback)
+		{
+			if (!text) return fallback;
+			if (!strcmp(text, "scalar")) return SIMD_SCALAR;
+			if (!strcmp(text, "sse42") || !strcmp(text, "sse4.2")) return SIMD_SSE42;
+			if (!strcmp(text, "avx2")) return SIMD_AVX2;
+			if (!strcmp(text, "avx512")) return SIMD_AVX512;
+			return fallback;
+		}
+	}
+
+	/// <summary>
+	/// Highest instruction set level supported by both the CPU (cpuid) and the OS (xgetbv).
+	/// </summary>
+	inline ENUM_SIMD_LEVEL DetectLevel()
+	{
+#ifdef G_SIMD_X86
+		unsigned r1[4], r7[4];
+		detail::cpuid(0, 0, r1);
+		const unsigned maxLeaf = r1[0];
+		detail::cpuid(1, 0, r1);
+		const bool sse42 = (r1[2] >> 20) & 1;
+		const bool fma = (r1[2] >> 12) & 1;
+		const bool osxsave = (r1[2] >> 27) & 1;
+		const unsigned long long xcr0 = osxsave ? detail::xgetbv0() : 0;
+		const bool osAvx = (xcr0 & 0x6) == 0x6;			// XMM + YMM state
+		const bool osAvx512 = (xcr0 & 0xE6) == 0xE6;	// + opmask, ZMM_Hi256, Hi16_ZMM
+		bool avx2 = false, avx512f = false;
+		if (maxLeaf >= 7) {
+			detail::cpuid(7, 0, r7);
+			avx2 = (r7[1] >> 5) & 1;
+			avx512f = (r7[1] >> 16) & 1;
+		}
+		if (avx512f && osAvx512) return SIMD_AVX512;
+		if (avx2 && fma && osAvx) return SIMD_AVX2;
+		if (sse42) return SIMD_SSE42;
+#endif
+		return SIMD_SCALAR;
+	}
+
+	/// <summary>
+	/// The level chosen once at startup: the detected level, lowered by the GNEURAL_SIMD
+	/// environment variable (scalar, sse42, avx2, avx512) when it is set.
+	/// </summary>
+	inline ENUM_SIMD_LEVEL& ActiveLevel()
+	{
+		static ENUM_SIMD_LEVEL level = [] {
+			const ENUM_SIMD_LEVEL detected = DetectLevel();
+#if defined(_MSC_VER)
+			char* env = nullptr;
+			size_t len = 0;
+			ENUM_SIMD_LEVEL requested = detected;
+			if (_dupenv_s(&env, &len, "GNEURAL_SIMD") == 0 && env) {
+				requested = detail::parseLevel(env, detected);
+				free(env);
+			}
+#else
+			const ENUM_SIMD_LEVEL requested = detail::parseLevel(getenv("GNEURAL_SIMD"), detected);
+#endif
+			return requested < detected ? requested : detected;
+		}();
+		return level;
+	}
+
+	// Kernels of the active level for double (default) or float. Cheap enough to call once per pass.
+	template<typename T = double>
+	inline const GSimdKernelsT<T>& Kernels() { return detail::table<T>(ActiveLevel()); }
+
+	/// <summary>
+	/// Stable softmax over one output layer, in place: v[i] = exp(v[i] - max) / sum. The max
+	/// and the sum are found in one pass (the sum is rescaled whenever the max grows), then
+	/// the row is normalized. Output layers are a few neurons wide, so this is scalar code.
+	/// </summary>
+	template<typename T>
+	inline void Softmax(T* v, size_t n, ENUM_ACTIVATION_PRECISION precision)
+	{
+		const bool fast = precision == ACTIVATION_FAST;
+		auto expOf = [fast](T x) { return fast ? detail::expFastScalar(x) : T(std::exp(x)); };
+		T max = v[0], sum = T(1);
+		for (size_t i = 1; i < n; ++i) {
+			if (v[i] > max) {
+				sum = sum * expOf(max - v[i]) + T(1);
+				max = v[i];
+			}
+			else
+				sum += expOf(v[i] - max);
+		}
+		const T inv = T(1) / sum;
+		for (size_t i = 0; i < n; ++i)
+			v[i] = expOf(v[i] - max) * inv;
+	}
+
+	/// <summary>
+	/// Fused softmax + cross-entropy gradient of the output logits: grad[i] = t[i] - p[i] (the
+	/// repo's sign, target minus output), where p is the softmax output. The softmax Jacobian
+	/// cancels against the cross-entropy derivative, so no activation derivative is applied.
+	/// </summary>
+	/// <returns>The cross-entropy -sum(t[i] * log(p[i])).</returns>
+	template<typename T>
+	inline double SoftmaxCrossEntropy(const T* p, const double* t, T* grad, size_t n)
+	{
+		// Keeps log() finite when a probability underflows to 0
+		constexpr double kMinProbability = 1e-300;
+		double loss = 0.0;
+		for (size_t i = 0; i < n; ++i) {
+			grad[i] = T(t[i]) - p[i];
+			if (t[i] != 0.0)
+				loss -= t[i] * std::log(std::max(double(p[i]), kMinProbability));
+		}
+		return loss;
+	}
+
+	/// <summary>
+	/// Forces a specific level for testing and benchmarking. Levels the CPU does not support
+	/// are clamped to the detected one. Not meant to be called while networks are training.
+	/// </summary>
+	/// <returns>The level that is actually in effect.</returns>
+	inline ENUM_SIMD_LEVEL ForceLevel(ENUM_SIMD_LEVEL level)
+	{
+		const ENUM_SIMD_LEVEL detected = DetectLevel();
+		ActiveLevel() = level < detected ? level : detected;
+		return ActiveLevel();
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <array>
+
+/// <summary>
+/// Non-owning view of a contiguous array (pointer + count), the C++17 stand-in for
+/// std::span used by the allocation-free overloads of the network API. It binds to
+/// std::vector, std::array, C arrays or a pointer and a count; GSpan&lt;const double&gt;
+/// also accepts const containers. The caller keeps the storage alive.
+/// </summary>
+template<typename T>
+class GSpan
+{
+public:
+	constexpr		GSpan() : m_data(nullptr), m_size(0) {}
+	constexpr		GSpan(T* data, size_t size) : m_data(data), m_size(size) {}
+	template<size_t N>
+	constexpr		GSpan(T (&data)[N]) : m_data(data), m_size(N) {}
+	template<typename U, typename A>
+					GSpan(std::vector<U, A>& v) : m_data(v.data()), m_size(v.size()) {}
+	template<typename U, typename A>
+					GSpan(const std::vector<U, A>& v) : m_data(v.data()), m_size(v.size()) {}
+	template<typename U, size_t N>
+	constexpr		GSpan(std::array<U, N>& a) : m_data(a.data()), m_size(N) {}
+	template<typename U, size_t N>
+	constexpr		GSpan(const std::array<U, N>& a) : m_data(a.data()), m_size(N) {}
+
+	constexpr T*	data() const { return m_data; }
+	constexpr size_t size() const { return m_size; }
+	constexpr bool	empty() const { return m_size == 0; }
+	constexpr T&	operator[](size_t i) const { return m_data[i]; }
+	constexpr T*	begin() const { return m_data; }
+	constexpr T*	end() const { return m_data + m_size; }
+
+private:
+	T*				m_data;
+	size_t			m_size;
+};
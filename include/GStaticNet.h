@@ -0,0 +1,306 @@
+#pragma once
+#include <array>
+#include <algorithm>
+#include <utility>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <cassert>
+#include "constants.h"
+#include "GTypes.h"
+#include "GSimdKernels.h"
+#include "GFileIO.h"
+#include "GNetworkFile.h"
+
+/// <summary>
+/// Fixed-topology network for tiny models such as the 2-3-1 and 2-4-4-1 logic gates:
+/// GStaticNet&lt;2, 3, 1&gt;. The layer sizes are template arguments, so every weight, output
+/// and gradient lives in a std::array inside the object, every loop bound is a compile-time
+/// constant the compiler can unroll, and nothing is virtual. Training and inference never
+/// touch the heap. It trains like GNeuralNetMatrix with the Momentum optimizer (eta/alpha,
+/// same update order and smoothed error), and at the scalar SIMD level both give the same
+/// results from the same weights.
+/// </summary>
+/// <remarks>
+/// Weights are stored like a GLayerMatrix without padding: for layer l, row n holds the
+/// input weights of neuron n and the bias weight last. importWeights()/exportWeights()
+/// copy them through the GNeuron-style getNeuron(layer, i).getConnection(n) accessors, and
+/// saveNetwork()/loadNetwork() use the GNeuralNetMatrix file format, so a gate trained by
+/// either network can be moved to the other.
+/// </remarks>
+template<size_t... Sizes>
+class GStaticNet
+{
+	static_assert(sizeof...(Sizes) >= 2, "GStaticNet needs at least an input and an output layer");
+
+public:
+		static constexpr size_t		kLayers = sizeof...(Sizes);
+		static constexpr std::array<size_t, kLayers> kTopology = { Sizes... };
+		static constexpr size_t		kInputs = kTopology[0];
+		static constexpr size_t		kOutputs = kTopology[kLayers - 1];
+
+		// Random weights in [0, 1], drawn in the same order as GNeuralNetMatrix::build().
+					GStaticNet()
+		{
+			for (double& w : m_weights)
+				w = rand() / double(RAND_MAX);
+			for (size_t l = 0; l < kLayers; ++l)
+				m_outputs[outputOffset(l) + kTopology[l]] = 1.0;	// bias neurons
+		}
+
+		// Runs kInputs values through the network.
+		void		feedForward(const double* inputVals)
+		{
+			for (size_t i = 0; i < kInputs; ++i)
+				m_outputs[i] = inputVals[i];
+			dispatch([this](auto a, auto fast) { forwardAll<decltype(a)::value, decltype(fast)::value>(std::make_index_sequence<kLayers - 1>()); });
+		}
+		void		feedForward(const VectorDouble& inputVals) { assert(inputVals.size() == kInputs); feedForward(inputVals.data()); }
+		// Back-propagates kOutputs targets of the last feedForward() and applies the momentum update.
+		void		backPropagate(const double* targetVals)
+		{
+			double error = 0.0;
+			dispatch([&](auto a, auto) { error = backward<decltype(a)::value>(targetVals); });
+			update(std::make_index_sequence<kLayers - 1>());
+			m_recentAverageError = (m_recentAverageError * m_recentAverageSmoothingFactor + error)
+				/ (m_recentAverageSmoothingFactor + 1.0);
+		}
+		void		backPropagate(const VectorDouble& targetVals) { assert(targetVals.size() == kOutputs); backPropagate(targetVals.data()); }
+		// Copies the kOutputs outputs of the last feedForward().
+		void		getResults(double* resultVals) const
+		{
+			for (size_t n = 0; n < kOutputs; ++n)
+				resultVals[n] = m_outputs[outputOffset(kLayers - 1) + n];
+		}
+		void		getResults(VectorDouble& resultVals) const { resultVals.resize(kOutputs); getResults(resultVals.data()); }
+		const double* results() const { return m_outputs.data() + outputOffset(kLayers - 1); }
+		double		getRecentAverageError(void) const { return m_recentAverageError; }
+
+		void		SetTrainingParameters(double learningRate, double momentum, ENUM_ACTIVATION activationType)
+		{
+			m_learningRate = learningRate;
+			m_momentum = momentum;
+			m_activation = activationType;
+		}
+		void		SetActivationType(ENUM_ACTIVATION activationType) { m_activation = activationType; }
+		ENUM_ACTIVATION GetActivationType() const { return m_activation; }
+		void		SetActivationPrecision(ENUM_ACTIVATION_PRECISION precision) { m_precision = precision; }
+		void		SetLearningRate(double learning_rate) { m_learningRate = learning_rate; }
+		void		SetMomentum(double momentum) { m_momentum = momentum; }
+		double		GetLearningRate(void) const { return m_learningRate; }
+		double		GetMomentum(void) const { return m_momentum; }
+		Topology	getTopology() const { return Topology(kTopology.begin(), kTopology.end()); }
+
+		// Weight from neuron 'input' of layer-1 (kTopology[layer-1] is the bias) to neuron 'neuron' of layer.
+		double&		weight(size_t layer, size_t neuron, size_t input)
+		{
+			assert(layer >= 1 && layer < kLayers);
+			return m_weights[weightOffset(layer) + neuron * (kTopology[layer - 1] + 1) + input];
+		}
+		double		weight(size_t layer, size_t neuron, size_t input) const
+		{
+			assert(layer >= 1 && layer < kLayers);
+			return m_weights[weightOffset(layer) + neuron * (kTopology[layer - 1] + 1) + input];
+		}
+
+		// Copies the weights of a network with the same topology and GNeuron-style accessors
+		// (GNeuralNetMatrix): getNeuron(l, i).getConnection(n) is the weight from i to neuron n of l + 1.
+		template<typename Net>
+		bool		importWeights(Net& net)
+		{
+			if (!sameTopology(net.getTopology()))
+				return false;
+			for (size_t l = 1; l < kLayers; ++l)
+				for (size_t i = 0; i <= kTopology[l - 1]; ++i)
+					for (size_t n = 0; n < kTopology[l]; ++n)
+						weight(l, n, i) = net.getNeuron(l - 1, i).getConnection(n).getWeight();
+			m_deltaWeights.fill(0.0);
+			return true;
+		}
+		template<typename Net>
+		bool		exportWeights(Net& net) const
+		{
+			if (!sameTopology(net.getTopology()))
+				return false;
+			for (size_t l = 1; l < kLayers; ++l)
+				for (size_t i = 0; i <= kTopology[l - 1]; ++i)
+					for (size_t n = 0; n < kTopology[l]; ++n)
+						net.getNeuron(l - 1, i).getConnection(n).setConnectionWeight(weight(l, n, i));
+			return true;
+		}
+
+		// Save / load in the GNeuralNetMatrix file format (type, topology, activation, weight rows).
+		bool		saveNetwork(const std::string& file_name) const;
+		bool		loadNetwork(const std::string& file_name);
+
+private:
+		// Offsets of layer l's weight matrix and output row in the flat arrays.
+		static constexpr size_t	weightOffset(size_t l)
+		{
+			size_t offset = 0;
+			for (size_t i = 1; i < l; ++i)
+				offset += kTopology[i] * (kTopology[i - 1] + 1);
+			return offset;
+		}
+		static constexpr size_t	outputOffset(size_t l)
+		{
+			size_t offset = 0;
+			for (size_t i = 0; i < l; ++i)
+				offset += kTopology[i] + 1;
+			return offset;
+		}
+
+		std::array<double, weightOffset(kLayers)>	m_weights{};		// per layer [neurons x (inputs + 1)]
+		std::array<double, weightOffset(kLayers)>	m_deltaWeights{};	// previous update, for momentum
+		std::array<double, outputOffset(kLayers)>	m_outputs{};		// per layer neurons + bias
+		std::array<double, outputOffset(kLayers)>	m_gradients{};
+		ENUM_ACTIVATION				m_activation = SIGMOID;
+		ENUM_ACTIVATION_PRECISION	m_precision = ACTIVATION_EXACT;
+		double			m_learningRate = 0.1;	// Eta
+		double			m_momentum = 0.5;		// Alpha
+		double			m_recentAverageError = 0.0;
+		double			m_recentAverageSmoothingFactor = 100.0;
+
+		template<ENUM_ACTIVATION A> using ActivationTag = std::integral_constant<ENUM_ACTIVATION, A>;
+		template<bool B> using FastTag = std::bool_constant<B>;
+		// Calls fn(activation tag, precision tag) once per pass; the layer loops are compiled per activation.
+		template<typename F>
+		void		dispatch(F&& fn)
+		{
+			const bool fast = m_precision == ACTIVATION_FAST;
+			switch (m_activation) {
+			case TANH:	fast ? fn(ActivationTag<TANH>(), FastTag<true>()) : fn(ActivationTag<TANH>(), FastTag<false>()); break;
+			case RELU:	fast ? fn(ActivationTag<RELU>(), FastTag<true>()) : fn(ActivationTag<RELU>(), FastTag<false>()); break;
+			default:	fast ? fn(ActivationTag<SIGMOID>(), FastTag<true>()) : fn(ActivationTag<SIGMOID>(), FastTag<false>()); break;
+			}
+		}
+
+		template<ENUM_ACTIVATION A, bool Fast, size_t L>
+		void		forwardLayer()
+		{
+			constexpr size_t N = kTopology[L], K = kTopology[L - 1] + 1;
+			const double* w = m_weights.data() + weightOffset(L);
+			const double* x = m_outputs.data() + outputOffset(L - 1);
+			double* out = m_outputs.data() + outputOffset(L);
+			for (size_t n = 0; n < N; ++n) {
+				double sum = 0.0;
+				for (size_t i = 0; i < K; ++i)
+					sum += w[n * K + i] * x[i];
+				out[n] = GSimd::detail::activateOne<A, Fast>(sum);
+			}
+		}
+		template<ENUM_ACTIVATION A, bool Fast, size_t... I>
+		void		forwardAll(std::index_sequence<I...>) { (forwardLayer<A, Fast, I + 1>(), ...); }
+
+		// Gradients of hidden layer L from layer L + 1 (bias column included, as in GNeuralNetMatrix).
+		template<ENUM_ACTIVATION A, size_t L>
+		void		hiddenGradients()
+		{
+			constexpr size_t N = kTopology[L] + 1, M = kTopology[L + 1];
+			const double* w = m_weights.data() + weightOffset(L + 1);
+			const double* nextGrad = m_gradients.data() + outputOffset(L + 1);
+			const double* out = m_outputs.data() + outputOffset(L);
+			double* grad = m_gradients.data() + outputOffset(L);
+			for (size_t j = 0; j < N; ++j) {
+				double sum = 0.0;
+				for (size_t k = 0; k < M; ++k)
+					sum += nextGrad[k] * w[k * N + j];
+				grad[j] = GSimd::detail::derivativeOne<A>(out[j], sum);
+			}
+		}
+		template<ENUM_ACTIVATION A, size_t... I>
+		void		hiddenAll(std::index_sequence<I...>) { (hiddenGradients<A, kLayers - 2 - I>(), ...); }
+		// Output gradients and hidden gradients; returns the RMS error of the outputs.
+		template<ENUM_ACTIVATION A>
+		double		backward(const double* targets)
+		{
+			const double* out = m_outputs.data() + outputOffset(kLayers - 1);
+			double* grad = m_gradients.data() + outputOffset(kLayers - 1);
+			double error = 0.0;
+			for (size_t n = 0; n < kOutputs; ++n) {
+				const double delta = targets[n] - out[n];
+				error += delta * delta;
+				grad[n] = GSimd::detail::derivativeOne<A>(out[n], delta);
+			}
+			hiddenAll<A>(std::make_index_sequence<kLayers - 2>());
+			return std::sqrt(error / kOutputs);
+		}
+
+		// Momentum update of layer L: dw = eta * grad * x + alpha * dw; w += dw.
+		template<size_t L>
+		void		updateLayer()
+		{
+			constexpr size_t N = kTopology[L], K = kTopology[L - 1] + 1;
+			double* w = m_weights.data() + weightOffset(L);
+			double* dw = m_deltaWeights.data() + weightOffset(L);
+			const double* x = m_outputs.data() + outputOffset(L - 1);
+			const double* grad = m_gradients.data() + outputOffset(L);
+			for (size_t n = 0; n < N; ++n) {
+				const double eg = m_learningRate * grad[n];
+				for (size_t i = 0; i < K; ++i) {
+					dw[n * K + i] = eg * x[i] + m_momentum * dw[n * K + i];
+					w[n * K + i] += dw[n * K + i];
+				}
+			}
+		}
+		// Output layer first, like GNeuralNetMatrix.
+		template<size_t... I>
+		void		update(std::index_sequence<I...>) { (updateLayer<kLayers - 1 - I>(), ...); }
+
+		static bool	sameTopology(const Topology& topology)
+		{
+			if (topology.size() == kLayers && std::equal(topology.begin(), topology.end(), kTopology.begin()))
+				return true;
+			std::cerr << "Error: network topology does not match the static network." << std::endl;
+			return false;
+		}
+};
+
+template<size_t... Sizes>
+inline bool GStaticNet<Sizes...>::saveNetwork(const std::string& file_name) const
+{
+	GFile outFile;
+	if (!outFile.open(file_name, true))
+		return false;
+	// The rows of all layers are stored back to back, exactly like m_weights: one write
+	bool ok = GNetworkFile::WriteVersion1Header(outFile.handle(), kTopology, m_activation)
+		&& WriteDoubles(outFile.handle(), m_weights);
+	ok = outFile.close() && ok;
+	if (!ok)
+		std::cerr << "Error: Failed to write " << file_name << "." << std::endl;
+	return ok;
+}
+
+template<size_t... Sizes>
+inline bool GStaticNet<Sizes...>::loadNetwork(const std::string& file_name)
+{
+	GFile inFile;
+	if (!inFile.open(file_name))
+		return false;
+	int type = 0;
+	size_t layers = 0;
+	int activation = 0;
+	std::array<size_t, kLayers> topology{};
+	if (!ReadBytes(inFile.handle(), &type, sizeof(type)) || !ReadBytes(inFile.handle(), &layers, sizeof(layers))
+		|| type != defNetMatrix || layers != kLayers) {
+		std::cerr << "Error: " << file_name << " is not a matrix network file of this topology." << std::endl;
+		return false;
+	}
+	if (!ReadBytes(inFile.handle(), topology.data(), layers * sizeof(size_t)) || !ReadBytes(inFile.handle(), &activation, sizeof(activation))
+		|| topology != kTopology) {
+		std::cerr << "Error: " << file_name << " is not a matrix network file of this topology." << std::endl;
+		return false;
+	}
+	if (activation & defOutputSoftmax) {
+		std::cerr << "Error: " << file_name << " has a softmax output layer, which GStaticNet does not support." << std::endl;
+		return false;
+	}
+	// The rows of all layers are stored back to back, exactly like m_weights
+	if (!ReadDoubles(inFile.handle(), m_weights))
+		return false;
+	m_deltaWeights.fill(0.0);
+	m_activation = static_cast<ENUM_ACTIVATION>(activation);
+	return true;
+}
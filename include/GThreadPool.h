@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+
+/// <summary>
+/// Small fork-join pool owned by a network. parallelFor() splits an index range into
+/// chunks, runs them on the workers and on the calling thread, and returns when all
+/// chunks are done. One job runs at a time; a parallelFor() issued from inside a chunk runs
+/// inline on that thread. The pool is not meant to be shared between networks that train
+/// concurrently.
+/// </summary>
+class GThreadPool
+{
+public:
+	// threadCount is the total number of threads taking part, the caller included.
+	explicit		GThreadPool(unsigned threadCount)
+						: m_generation(0), m_stop(false), m_invoke(nullptr), m_context(nullptr),
+						  m_count(0), m_chunk(0), m_next(0), m_pending(0)
+	{
+		const unsigned workers = threadCount > 1 ? threadCount - 1 : 0;
+		m_workers.reserve(workers);
+		for (unsigned i = 0; i < workers; ++i)
+			m_workers.emplace_back([this] { workerLoop(); });
+	}
+					~GThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (std::thread& worker : m_workers)
+			worker.join();
+	}
+					GThreadPool(const GThreadPool&) = delete;
+	GThreadPool&	operator=(const GThreadPool&) = delete;
+
+	unsigned		getThreadCount() const { return static_cast<unsigned>(m_workers.size()) + 1; }
+
+	/// <summary>
+	/// Calls fn(begin, end) over [0, count) in chunks of at least 'grain' indices.
+	/// Runs inline when the range is too small to be worth splitting.
+	/// </summary>
+	template<typename F>
+	void			parallelFor(size_t count, size_t grain, F&& fn)
+	{
+		const size_t threads = getThreadCount();
+		grain = std::max<size_t>(grain, 1);
+		if (threads == 1 || count <= grain || insideJob()) {
+			if (count)
+				fn(size_t(0), count);
+			return;
+		}
+		const size_t chunks = std::min(threads, (count + grain - 1) / grain);
+		using Fn = typename std::remove_reference<F>::type;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_invoke = [](void* context, size_t begin, size_t end) { (*static_cast<Fn*>(context))(begin, end); };
+			m_context = const_cast<void*>(static_cast<const void*>(&fn));
+			m_count = count;
+			m_chunk = (count + chunks - 1) / chunks;
+			m_next.store(0, std::memory_order_relaxed);
+			m_pending = static_cast<unsigned>(m_workers.size());
+			++m_generation;
+		}
+		m_wake.notify_all();
+		runChunks();
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this] { return m_pending == 0; });
+	}
+
+	// Convenience: hardware threads available, at least 1.
+	static unsigned	HardwareThreads() { return std::max(1u, std::thread::hardware_concurrency()); }
+
+private:
+	// Set while the current thread runs a chunk, so nested jobs do not re-enter the pool.
+	static bool&	insideJob() { thread_local bool inside = false; return inside; }
+	void			runChunks()
+	{
+		insideJob() = true;
+		for (;;) {
+			const size_t begin = m_next.fetch_add(m_chunk, std::memory_order_relaxed);
+			if (begin >= m_count)
+				break;
+			m_invoke(m_context, begin, std::min(begin + m_chunk, m_count));
+		}
+		insideJob() = false;
+	}
+	void			workerLoop()
+	{
+		unsigned long long seen = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+				if (m_stop)
+					return;
+				seen = m_generation;
+			}
+			runChunks();
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (--m_pending == 0)
+					m_done.notify_one();
+			}
+		}
+	}
+
+	std::vector<std::thread>	m_workers;
+	std::mutex					m_mutex;
+	std::condition_variable		m_wake;
+	std::condition_variable		m_done;
+	unsigned long long			m_generation;
+	bool						m_stop;
+
+	// Current job
+	void						(*m_invoke)(void*, size_t, size_t);
+	void*						m_context;
+	size_t						m_count;
+	size_t						m_chunk;
+	std::atomic<size_t>			m_next;
+	unsigned					m_pending;
+};
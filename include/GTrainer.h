@@ -0,0 +1,222 @@
+#pragma once
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <cassert>
+#include "GSpan.h"
+#include "GDataset.h"
+#include "InterfaceGNeuralNet.h"
+
+/// <summary>
+/// Metrics of one training epoch, measured on the outputs of the forward pass that each
+/// update was computed from.
+/// </summary>
+struct GEpochMetrics
+{
+	size_t			epoch = 0;					// 1-based
+	double			meanAbsError = 0.0;			// mean |output - target| over samples and outputs
+	double			maxAbsError = 0.0;			// largest |output - target| of the epoch
+	size_t			failures = 0;				// samples with an output outside the margin of error
+	int				consecutiveSuccesses = 0;	// epochs in a row without failures, this one included
+	double			seconds = 0.0;
+};
+
+/// <summary>
+/// Stop criteria and batching of GTrainer::Run(). An epoch succeeds when every
+/// output of every sample is within marginOfError of its target; training stops after
+/// requiredSuccesses successful epochs in a row, or after maxPasses epochs.
+/// </summary>
+struct GTrainOptions
+{
+	double			marginOfError = 0.1;
+	int				requiredSuccesses = 3;
+	size_t			maxPasses = 500000;
+	// 1 trains per sample; larger values use feedForwardBatch / backPropagateBatch.
+	size_t			batchSize = 1;
+	// Visits the samples in a new random order every epoch (seeded by seed), gathered into
+	// aligned staging buffers by a GBatchLoader thread. Off trains in dataset order, in place.
+	bool			shuffle = false;
+	unsigned		seed = 0;
+	// Called after every epoch; returning false stops training.
+	std::function<bool(const GEpochMetrics&)> onEpoch;
+};
+
+struct GTrainResult
+{
+	bool						converged = false;
+	size_t						epochs = 0;
+	std::vector<GEpochMetrics>	history;		// one entry per epoch
+};
+
+namespace GTrainer
+{
+	/// <summary>
+	/// Epoch loop shared by the entry points below. trainRows(batch) trains on the rows of one
+	/// loader batch and returns their outputs, row-major; chunkRows is the loader batch size.
+	/// </summary>
+	template<typename TrainRows>
+	inline GTrainResult RunEpochs(const GDatasetView& data, const GTrainOptions& options, size_t chunkRows, TrainRows&& trainRows)
+	{
+		using Clock = std::chrono::steady_clock;
+		GTrainResult result;
+		if (data.samples == 0)
+			return result;
+		const size_t numOutputs = data.outputCount;
+		int consecutiveSuccesses = 0;
+
+		// Adds one sample's errors to the epoch metrics
+		auto score = [&](GEpochMetrics& metrics, const double* out, const double* target) {
+			double sampleMax = 0.0;
+			for (size_t n = 0; n < numOutputs; ++n) {
+				const double error = std::fabs(out[n] - target[n]);
+				metrics.meanAbsError += error;
+				sampleMax = std::max(sampleMax, error);
+			}
+			metrics.maxAbsError = std::max(metrics.maxAbsError, sampleMax);
+			if (sampleMax > options.marginOfError)
+				++metrics.failures;
+		};
+
+		GBatchLoader loader(data, chunkRows, options.shuffle, options.seed);
+		GBatchView batch;
+
+		for (size_t pass = 1; pass <= options.maxPasses; ++pass) {
+			const Clock::time_point start = Clock::now();
+			GEpochMetrics metrics;
+			metrics.epoch = pass;
+			loader.startEpoch();
+			while (loader.next(batch)) {
+				const double* outputs = trainRows(batch);
+				for (size_t b = 0; b < batch.rows; ++b)
+					score(metrics, outputs + b * numOutputs, batch.targets + b * numOutputs);
+			}
+			metrics.meanAbsError /= double(data.samples * numOutputs);
+			consecutiveSuccesses = metrics.failures == 0 ? consecutiveSuccesses + 1 : 0;
+			metrics.consecutiveSuccesses = consecutiveSuccesses;
+			metrics.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+			result.history.push_back(metrics);
+			const bool keepGoing = !options.onEpoch || options.onEpoch(metrics);
+			if (consecutiveSuccesses >= options.requiredSuccesses) {
+				result.converged = true;
+				break;
+			}
+			if (!keepGoing)
+				break;
+		}
+		result.epochs = result.history.size();
+		return result;
+	}
+
+	// Per-sample training still walks the loader in chunks so that shuffled rows are gathered
+	// ahead of the network, not one sample at a time
+	constexpr size_t	perSampleChunk = 256;
+
+	/// <summary>
+	/// Trainer of the header-only backends (GNeuralNetMatrixT): the per-sample calls go to
+	/// their native span overloads, bound statically and inlined into the loop, and
+	/// options.batchSize above 1 uses their feedForwardBatch / backPropagateBatch.
+	/// </summary>
+	template<typename Net>
+	inline GTrainResult Run(Net& net, const GDatasetView& data, const GTrainOptions& options)
+	{
+		const size_t batchSize = std::max<size_t>(options.batchSize, 1);
+		const size_t numInputs = data.inputCount, numOutputs = data.outputCount;
+		std::vector<double> outputs((batchSize == 1 ? perSampleChunk : batchSize) * numOutputs);
+		std::vector<double> batchOutputs;
+		return RunEpochs(data, options, batchSize == 1 ? perSampleChunk : batchSize, [&](const GBatchView& batch) {
+			if (batchSize == 1) {
+				for (size_t b = 0; b < batch.rows; ++b) {
+					net.feedForward(GSpan<const double>(batch.inputs + b * numInputs, numInputs));
+					net.backPropagate(GSpan<const double>(batch.targets + b * numOutputs, numOutputs));
+					net.getResults(GSpan<double>(outputs.data() + b * numOutputs, numOutputs));
+				}
+				return static_cast<const double*>(outputs.data());
+			}
+			net.feedForwardBatch(batch.inputs, batch.rows);
+			net.getBatchResults(batchOutputs);
+			net.backPropagateBatch(batch.targets, batch.rows);
+			return static_cast<const double*>(batchOutputs.data());
+		});
+	}
+
+	/// <summary>
+	/// Trains a network held through the interface. The header-only matrix backends take the
+	/// templated Run(Net&amp;) (span and batch paths); the backends built inside the DLL, whose
+	/// interface has only the single-sample virtuals, train per sample with RunPerSample().
+	/// Declared here so that a call on an InterfaceGNeuralNet&amp; never binds Run&lt;InterfaceGNeuralNet&gt;;
+	/// defined in GNeuralNetMatrix.h (included at the end of this file), which knows the matrix
+	/// types it dispatches to.
+	/// </summary>
+	inline GTrainResult Run(InterfaceGNeuralNet& net, const GDatasetView& data, const GTrainOptions& options);
+
+	/// <summary>
+	/// Trainer of any InterfaceGNeuralNet through the virtuals the interface has always had
+	/// (feedForward / backPropagate / getResults on VectorDouble), so it works on the
+	/// GNeuralNet and GNeuralNetOCL objects built inside the DLL. Those backends have no
+	/// batch API, so every sample is trained on its own and options.batchSize is ignored.
+	/// Run(InterfaceGNeuralNet&) sends the header-only backends to Run(Net&) instead.
+	/// </summary>
+	inline GTrainResult RunPerSample(InterfaceGNeuralNet& net, const GDatasetView& data, const GTrainOptions& options)
+	{
+		const size_t numInputs = data.inputCount, numOutputs = data.outputCount;
+		std::vector<double> outputs(perSampleChunk * numOutputs);
+		VectorDouble row, target, results;
+		return RunEpochs(data, options, perSampleChunk, [&](const GBatchView& batch) {
+			for (size_t b = 0; b < batch.rows; ++b) {
+				row.assign(batch.inputs + b * numInputs, batch.inputs + (b + 1) * numInputs);
+				target.assign(batch.targets + b * numOutputs, batch.targets + (b + 1) * numOutputs);
+				net.feedForward(row);
+				net.backPropagate(target);
+				net.getResults(results);
+				assert(results.size() >= numOutputs);
+				std::copy(results.begin(), results.begin() + numOutputs, outputs.begin() + b * numOutputs);
+			}
+			return static_cast<const double*>(outputs.data());
+		});
+	}
+
+	/// <summary>
+	/// Trains every network of a caller-owned container (of pointers or unique_ptrs) on its own
+	/// thread and waits for all of them. The trainer is called once per network with the
+	/// network and its index; it owns the training loop and data.
+	/// </summary>
+	/// <remarks>
+	/// Only backends that keep their hyperparameters per instance may train side by side:
+	/// GNeuralNetMatrixT does, through its GTrainingContext. GNeuralNet (built in the DLL) reads
+	/// the process-wide GNeuron::eta / alpha on every update, so concurrent GNeuralNet instances
+	/// race on them; train those one at a time.
+	/// Rethrows the first exception thrown by a trainer, after every thread has joined.
+	/// </remarks>
+	template<typename Networks>
+	inline void TrainConcurrently(Networks& networks, const std::function<void(InterfaceGNeuralNet&, unsigned int)>& trainer)
+	{
+		std::vector<std::thread> threads;
+		std::vector<std::exception_ptr> errors(networks.size());
+		threads.reserve(networks.size());
+		unsigned int index = 0;
+		for (auto& network : networks) {
+			InterfaceGNeuralNet& net = *network;
+			threads.emplace_back([&trainer, &errors, &net, index]() {
+				try {
+					trainer(net, index);
+				}
+				catch (...) {
+					errors[index] = std::current_exception();
+				}
+			});
+			++index;
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+		for (const std::exception_ptr& error : errors)
+			if (error)
+				std::rethrow_exception(error);
+	}
+}
+
+// Definition of Run(InterfaceGNeuralNet&); GNeuralNetMatrix.h includes this file first.
+#include "GNeuralNetMatrix.h"
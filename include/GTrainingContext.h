@@ -0,0 +1,24 @@
+#pragma once
+#include "GTypes.h"
+#include "GNeuronOpenCL.h"
+
+/// <summary>
+/// Hyperparameters and activation choice of one network. GNeuron keeps eta/alpha as
+/// process-wide statics, so two networks cannot train side by side with different rates;
+/// the CPU matrix backend instead owns one context per network and passes it by reference
+/// through every forward, backward and update pass.
+/// </summary>
+struct GTrainingContext
+{
+	double							learningRate = 0.1;		// Eta
+	double							momentum = 0.5;			// Alpha
+	ENUM_ACTIVATION					activation = SIGMOID;
+	ENUM_ACTIVATION_PRECISION		precision = ACTIVATION_EXACT;
+	ENUM_OUTPUT_LAYER				outputLayer = OUTPUT_ACTIVATION;
+	ENUM_OPTIMIZER					optimizer = OPTIMIZER_MOMENTUM;
+	double							adam_b1 = 0.9;
+	double							adam_b2 = 0.999;
+	double							epsilon = 1e-8;			// Adam/AdamW/RMSProp denominator guard
+	double							weightDecay = 0.01;		// AdamW decoupled decay
+	double							rmsDecay = 0.9;			// RMSProp rho
+};
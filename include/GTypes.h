@@ -40,6 +40,55 @@ typedef enum
 	SECOND_MOMENTUM
 } ENUM_BUFFERS;
 
+typedef enum
+{
+	PARALLEL_LAYER,		// split the neurons of each layer across threads
+	PARALLEL_DATA,		// split the mini-batch into shards, reduce the gradients, update once
+	PARALLEL_HOGWILD	// lock-free per-sample SGD, threads update the shared weights directly
+} ENUM_PARALLEL_MODE;
+
+typedef enum
+{
+	ACTIVATION_EXACT,	// libm tanh/exp
+	ACTIVATION_FAST		// vectorized polynomial exp, see GSimdKernels.h for the error bounds
+} ENUM_ACTIVATION_PRECISION;
+
+typedef enum
+{
+	SCALAR_FP64,		// double storage and arithmetic
+	SCALAR_FP32			// float storage and arithmetic, twice the SIMD lanes
+} ENUM_SCALAR_TYPE;
+
+typedef enum
+{
+	STORAGE_FULL,		// the forward pass reads the network's own T weights
+	STORAGE_BF16,		// ... a bfloat16 copy (8-bit exponent, 7-bit mantissa)
+	STORAGE_FP16		// ... an IEEE half copy (5-bit exponent, 10-bit mantissa)
+} ENUM_WEIGHT_STORAGE;
+
+typedef enum
+{
+	QUANT_PER_ROW,		// one int8 weight scale per neuron (weight row)
+	QUANT_PER_LAYER		// one int8 weight scale for the whole layer
+} ENUM_QUANT_GRANULARITY;
+
+typedef enum
+{
+	OUTPUT_ACTIVATION,	// output neurons use the network activation, trained on squared error
+	OUTPUT_SOFTMAX		// softmax over the output layer, trained on cross-entropy (one-hot targets)
+} ENUM_OUTPUT_LAYER;
+
+// Weight update of the matrix networks. The DLL backends only take GNeuronOpenCL::OptimizerType
+// (Momentum, Adam), so the others are set with GNeuralNetMatrixT::SetOptimizer().
+typedef enum
+{
+	OPTIMIZER_MOMENTUM,	// eta/alpha momentum
+	OPTIMIZER_ADAM,		// Adam with bias correction
+	OPTIMIZER_ADAMW,	// Adam with decoupled weight decay
+	OPTIMIZER_RMSPROP,	// RMSProp
+	OPTIMIZER_NESTEROV	// Nesterov momentum
+} ENUM_OPTIMIZER;
+
 class DateTime {
 public: 
 	//tm* getGMTTime(void) { return gmtime_s(&now); }
@@ -52,15 +101,6 @@ private:
 };
 
 
-class NNetTrainingData {
-public:
-
-private:
-	VectorDouble m_input;
-	VectorDouble m_output;
-
-
-};
 #ifdef MAKEDLL
 #  define GN_EXPORT __declspec(dllexport)
 #else
@@ -2,8 +2,11 @@
 
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <cassert>
 #include "GNeuronOpenCL.h"
 #include "GTypes.h" // Your type definitions
+#include "GSpan.h"
 // Abstract base class defining the common interface for all network types.
 class InterfaceGNeuralNet {
 
@@ -44,3 +47,33 @@ public:
     
 };
 
+/// <summary>
+/// Span adapters for any InterfaceGNeuralNet, including the GNeuralNet and GNeuralNetOCL
+/// objects built inside the DLL. The interface is implemented by the DLL, so it cannot gain
+/// members or virtuals; these copy through a caller-owned scratch vector instead. The scratch
+/// keeps its capacity, so after the first call they do not touch the heap, and threads that
+/// each own their scratch may call them on different networks at once. GNeuralNetMatrixT has
+/// native span overloads that need no scratch.
+/// </summary>
+namespace GNetSpan
+{
+    inline void FeedForward(InterfaceGNeuralNet& net, GSpan<const double> inputVals, VectorDouble& scratch)
+    {
+        scratch.assign(inputVals.begin(), inputVals.end());
+        net.feedForward(scratch);
+    }
+
+    inline void BackPropagate(InterfaceGNeuralNet& net, GSpan<const double> targetVals, VectorDouble& scratch)
+    {
+        scratch.assign(targetVals.begin(), targetVals.end());
+        net.backPropagate(scratch);
+    }
+
+    // Writes the outputs into resultVals, which must hold exactly the output count.
+    inline void GetResults(const InterfaceGNeuralNet& net, GSpan<double> resultVals, VectorDouble& scratch)
+    {
+        net.getResults(scratch);
+        assert(scratch.size() == resultVals.size());
+        std::copy(scratch.begin(), scratch.end(), resultVals.begin());
+    }
+}
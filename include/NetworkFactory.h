@@ -7,6 +7,7 @@
 #include "DllExport.h" // Our new export macro header
 #include "GNeuralNet.h"       // Include the CPU implementation
 #include "GNeuralNetOCL.h"    // Include the GPU implementation
+#include "GNeuralNetMatrix.h" // Include the contiguous-storage CPU implementation
 #include <iostream>
 
 namespace NetworkFactory
@@ -46,5 +47,40 @@ namespace NetworkFactory
     /// It will automatically create the correct backend (GPU or CPU) that the network was saved with.
     /// </summary>
     GNEURAL_API std::unique_ptr<InterfaceGNeuralNet> LoadNetworkFromFile(const std::string& file_name);
-}
 
+    /// <summary>
+    /// Creates a CPU network that stores every layer as one aligned, row-major weight matrix
+    /// (GNeuralNetMatrix) instead of per-neuron connection objects.
+    /// SCALAR_FP32 selects GNeuralNetMatrixF, which stores and computes in float.
+    /// </summary>
+    inline std::unique_ptr<InterfaceGNeuralNet> CreateMatrixNetwork(const Topology& topology,
+        ENUM_SCALAR_TYPE scalar = SCALAR_FP64)
+    {
+        if (scalar == SCALAR_FP32)
+            return std::make_unique<GNeuralNetMatrixF>(topology);
+        return std::make_unique<GNeuralNetMatrix>(topology);
+    }
+
+    /// <summary>
+    /// Loads a matrix network file for inference only: the training state built while
+    /// loading is dropped and just the frozen weights are kept (see GFrozenNetT).
+    /// A .nnw version 2 file of the same dtype is memory-mapped and its weights are used in
+    /// place, with no parse or copy step.
+    /// The shared instance may be used by any number of threads at once.
+    /// </summary>
+    /// <returns>The frozen network, or nullptr if the file could not be read.</returns>
+    template<typename T = double>
+    std::shared_ptr<const GFrozenNetT<T>> LoadFrozenNetwork(const std::string& file_name)
+    {
+        if (GNetworkFile::IsVersion2(file_name)) {
+            auto frozen = std::make_shared<GFrozenNetT<T>>();
+            if (!frozen->load(file_name))
+                return nullptr;
+            return frozen;
+        }
+        GNeuralNetMatrixT<T> net;
+        if (!net.loadNetwork(file_name))
+            return nullptr;
+        return std::make_shared<const GFrozenNetT<T>>(net.freeze());
+    }
+}
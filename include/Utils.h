@@ -8,6 +8,7 @@
 #include <fstream>
 #include <streambuf>
 #include <stdexcept>
+#include "GFileIO.h"
 
 
 
@@ -33,6 +34,8 @@ bool FileWriteDouble(HANDLE hFile, double value);
  * @return TRUE (1) on success, FALSE (0) on failure (e.g., end of file).
  */
 bool FileReadDouble(HANDLE hFile, double* pValue);
+// Arrays of doubles: WriteDoubles / ReadDoubles / ReadDoublesAt (GFileIO.h) move a whole
+// GSpan in one call, on a HANDLE, a CRT descriptor or a stream.
 
 //USING STREAMS IN C++ FOR FILE OPERATIONS
 
@@ -13,6 +13,10 @@ constexpr int defArrayLayer = 0x7788;
 constexpr int defNet = 0x7789;
 constexpr int defNetConv = 0x7790;
 constexpr int defNeuronLSTM = 0x7791;
+constexpr int defNetMatrix = 0x7793; // CPU network with contiguous layer matrices
+constexpr int defOutputSoftmax = 0x100; // matrix file: flag in the activation field, softmax output layer
+constexpr int defDatasetCache = 0x7794; // binary training set cache written by GDataLoader
+constexpr int defNetFileV2 = 0x7795; // .nnw version 2: aligned weight sections, mappable (GNetworkFile.h)
 //---
 constexpr int defBufferDouble = 0x7882;
 constexpr int defNeuronBaseOCL = 0x7883;